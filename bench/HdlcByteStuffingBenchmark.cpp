@@ -0,0 +1,136 @@
+/**
+ * \file      HdlcByteStuffingBenchmark.cpp
+ * \brief     Throughput benchmark of the HDLC byte stuffing codec
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcByteStuffing.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Throughput of HdlcByteStuffing compared with a bytewise loop, for frames of typical size and several densities of
+// octets to escape. Reported is the best of all rounds in MB/s of payload.
+
+static const size_t s_FrameSize = 1500;
+static const size_t s_Frames = 2000;
+static const int    s_Rounds = 5;
+
+static void BytewiseStuff(const unsigned char* a_Buffer, size_t a_Length, std::vector<unsigned char>& a_Stuffed) {
+    for (size_t l_Index = 0; l_Index < a_Length; ++l_Index) {
+        if ((a_Buffer[l_Index] == HdlcByteStuffing::FLAG) || (a_Buffer[l_Index] == HdlcByteStuffing::ESCAPE)) {
+            a_Stuffed.push_back(HdlcByteStuffing::ESCAPE);
+            a_Stuffed.push_back(a_Buffer[l_Index] ^ HdlcByteStuffing::XOR);
+        } else {
+            a_Stuffed.push_back(a_Buffer[l_Index]);
+        } // else
+    } // for
+}
+
+static bool BytewiseUnstuff(const unsigned char* a_Buffer, size_t a_Length, std::vector<unsigned char>& a_Unstuffed) {
+    for (size_t l_Index = 0; l_Index < a_Length; ++l_Index) {
+        if (a_Buffer[l_Index] == HdlcByteStuffing::FLAG) {
+            return false;
+        } else if (a_Buffer[l_Index] == HdlcByteStuffing::ESCAPE) {
+            if (++l_Index == a_Length) {
+                return false;
+            } // if
+
+            a_Unstuffed.push_back(a_Buffer[l_Index] ^ HdlcByteStuffing::XOR);
+        } else {
+            a_Unstuffed.push_back(a_Buffer[l_Index]);
+        } // else
+    } // for
+
+    return true;
+}
+
+// Apply the codec to all frames, returns the throughput of the best round in MB/s of the input
+template<class TCodec>
+static double Measure(const std::vector<std::vector<unsigned char>>& a_Frames, TCodec a_Codec) {
+    size_t l_Octets = 0;
+    for (const auto& l_Frame: a_Frames) {
+        l_Octets += l_Frame.size();
+    } // for
+
+    double l_Best = 0;
+    std::vector<unsigned char> l_Output;
+    for (int l_Round = 0; l_Round < s_Rounds; ++l_Round) {
+        auto l_Begin = std::chrono::steady_clock::now();
+        for (const auto& l_Frame: a_Frames) {
+            l_Output.clear();
+            a_Codec(l_Frame.data(), l_Frame.size(), l_Output);
+        } // for
+
+        auto l_End = std::chrono::steady_clock::now();
+        double l_Seconds = std::chrono::duration<double>(l_End - l_Begin).count();
+        l_Best = std::max(l_Best, (l_Octets / l_Seconds / 1e6));
+    } // for
+
+    return l_Best;
+}
+
+int main() {
+    std::mt19937 l_Random(1662);
+    std::cout << "Frames of " << s_FrameSize << " octets, MB/s of input, best of " << s_Rounds << " rounds" << std::endl;
+    std::cout << "escape density    stuff bytewise / block    unstuff bytewise / block" << std::endl;
+    for (uint32_t l_Density: { 0u, 4096u, 256u, 32u, 4u }) {
+        // Payload frames with one octet to escape in l_Density on average, none for 0
+        std::vector<std::vector<unsigned char>> l_Payloads(s_Frames, std::vector<unsigned char>(s_FrameSize));
+        std::vector<std::vector<unsigned char>> l_Stuffed(s_Frames);
+        for (size_t l_Index = 0; l_Index < s_Frames; ++l_Index) {
+            for (auto& l_Octet: l_Payloads[l_Index]) {
+                do {
+                    l_Octet = static_cast<unsigned char>(l_Random());
+                } while ((l_Octet == HdlcByteStuffing::FLAG) || (l_Octet == HdlcByteStuffing::ESCAPE));
+
+                if (l_Density && ((l_Random() % l_Density) == 0)) {
+                    l_Octet = HdlcByteStuffing::FLAG;
+                } // if
+            } // for
+
+            HdlcByteStuffing::Stuff(l_Payloads[l_Index].data(), s_FrameSize, l_Stuffed[l_Index]);
+        } // for
+
+        std::cout << (l_Density ? ("1 in " + std::to_string(l_Density)) : std::string("none")) << "\t\t"
+                  << Measure(l_Payloads, BytewiseStuff) << " / " << Measure(l_Payloads, HdlcByteStuffing::Stuff) << "\t\t"
+                  << Measure(l_Stuffed, BytewiseUnstuff) << " / " << Measure(l_Stuffed, HdlcByteStuffing::Unstuff) << std::endl;
+    } // for
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * \file      HdlcdConnectStormBenchmark.cpp
+ * \brief     Connect storm benchmark of the default and the fast session setup
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcdClient.h"
+#include "HdlcdSessionAcceptor.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Connect storm: many clients connect to an HdlcdSessionAcceptor over loopback at once, each sends a data packet as
+// soon as its session is established and waits for the echo. Measured is the time from the first connect until all
+// clients received their echo, with and without HdlcdClient::SetFastConnect(). Client and server share one thread, thus
+// the result reflects the number of round trips and system calls of the session setup rather than parallelism. Whether
+// TCP Fast Open takes effect depends on net.ipv4.tcp_fastopen; the first round of each run primes the cookie cache.
+
+static size_t s_Clients = 300;
+static const int s_Rounds = 5;
+
+// Run a single connect storm, returns the elapsed time in milliseconds, or a negative value on failure
+static double RunRound(bool a_bFastConnect) {
+    boost::asio::io_service l_IOService;
+    HdlcdSessionAcceptor l_Acceptor(l_IOService);
+    l_Acceptor.SetFastOpen(1024);
+    std::vector<std::shared_ptr<HdlcdPacketEndpoint>> l_PacketEndpoints;
+    auto l_SessionHandler = [&l_PacketEndpoints](boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint,
+                                                 std::shared_ptr<HdlcdSessionHeader> a_SessionHeader) {
+        // Echo all data packets of data sessions, control sessions are just kept open
+        auto l_PacketEndpoint = std::make_shared<HdlcdPacketEndpoint>(a_IOService, a_FrameEndpoint);
+        std::weak_ptr<HdlcdPacketEndpoint> l_WeakPacketEndpoint(l_PacketEndpoint);
+        if (HdlcdSessionDescriptor(a_SessionHeader->GetServiceAccessPointSpecifier()).GetSessionType() == SESSION_TYPE_TRX_ALL) {
+            l_PacketEndpoint->SetOnDataCallback([l_WeakPacketEndpoint](std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+                l_WeakPacketEndpoint.lock()->Send(HdlcdPacketData::CreatePacket(a_PacketData->GetData(), false));
+                return true;
+            });
+        } // if
+
+        l_PacketEndpoints.emplace_back(l_PacketEndpoint);
+        l_PacketEndpoint->Start();
+    };
+
+    l_Acceptor.SetSessionHandler(SESSION_TYPE_TRX_ALL, l_SessionHandler);
+    l_Acceptor.SetSessionHandler(SESSION_TYPE_TRX_STATUS, l_SessionHandler);
+    boost::system::error_code l_ErrorCode;
+    if (!l_Acceptor.Open(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0), l_ErrorCode)) {
+        std::cerr << "Failed to open the acceptor: " << l_ErrorCode.message() << std::endl;
+        return -1;
+    } // if
+
+    boost::asio::ip::tcp::resolver l_Resolver(l_IOService);
+    auto l_EndpointIterator = l_Resolver.resolve(boost::asio::ip::tcp::resolver::query("127.0.0.1", std::to_string(l_Acceptor.GetLocalEndpoint().port())));
+    std::vector<std::unique_ptr<HdlcdClient>> l_Clients;
+    size_t l_Echoed = 0;
+    double l_Elapsed = -1;
+    const auto l_Begin = std::chrono::steady_clock::now();
+    for (size_t l_Index = 0; l_Index < s_Clients; ++l_Index) {
+        l_Clients.emplace_back(new HdlcdClient(l_IOService, "/dev/ttyUSB0", HdlcdSessionDescriptor(SESSION_TYPE_TRX_ALL, SESSION_FLAGS_DELIVER_RCVD)));
+        HdlcdClient* l_pClient = l_Clients.back().get();
+        l_pClient->SetFastConnect(a_bFastConnect);
+        l_pClient->SetOnDataCallback([&](const HdlcdPacketData&) {
+            if (++l_Echoed == s_Clients) {
+                l_Elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - l_Begin).count();
+                l_IOService.stop();
+            } // if
+        });
+        l_pClient->AsyncConnect(l_EndpointIterator, [l_pClient](bool a_bSuccess) {
+            if (a_bSuccess) {
+                l_pClient->Send(HdlcdPacketData::CreatePacket(std::vector<unsigned char>(3, 0x55), false));
+            } // if
+        });
+    } // for
+
+    // Give up if not all sessions were established in time
+    boost::asio::deadline_timer l_Timer(l_IOService, boost::posix_time::seconds(30));
+    l_Timer.async_wait([&l_IOService](const boost::system::error_code& a_ErrorCode) {
+        if (!a_ErrorCode) {
+            l_IOService.stop();
+        } // if
+    }); // async_wait
+
+    l_IOService.run();
+    if (l_Echoed != s_Clients) {
+        std::cerr << "Only " << l_Echoed << " of " << s_Clients << " clients received their echo" << std::endl;
+    } // if
+
+    // Tear down without running the IOService again
+    for (auto l_Client = l_Clients.begin(); l_Client != l_Clients.end(); ++l_Client) {
+        (*l_Client)->SetOnClosedCallback(nullptr);
+    } // for
+
+    return l_Elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of clients per round
+    if (argc > 1) {
+        s_Clients = std::stoul(argv[1]);
+    } // if
+
+    double l_BestDefault = 1e9;
+    double l_BestFast = 1e9;
+    for (int l_Round = 0; l_Round < s_Rounds; ++l_Round) {
+        const double l_Default = RunRound(false);
+        const double l_Fast = RunRound(true);
+        if ((l_Default < 0) || (l_Fast < 0)) {
+            return 1;
+        } // if
+
+        l_BestDefault = std::min(l_BestDefault, l_Default);
+        l_BestFast = std::min(l_BestFast, l_Fast);
+    } // for
+
+    std::cout << "Connect storm, " << s_Clients << " clients over loopback, best of " << s_Rounds << " rounds" << std::endl;
+    std::cout << "  default session setup:  " << l_BestDefault << " ms" << std::endl;
+    std::cout << "  fast connect:           " << l_BestFast << " ms" << std::endl;
+    return 0;
+}
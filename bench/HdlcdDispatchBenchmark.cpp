@@ -0,0 +1,146 @@
+/**
+ * \file      HdlcdDispatchBenchmark.cpp
+ * \brief     Benchmark of the type-erased vs. the compile-time bound packet dispatch
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameEndpoint.h"
+#include "HdlcdPacketData.h"
+#include "HdlcdPacketEndpoint.h"
+
+// Compares the receive path of the type-erased HdlcdPacketEndpoint with that of HdlcdPacketEndpointT bound to a handler at
+// compile time. A second thread writes a pre-serialized stream of data packets to a loopback connection, thus the sender
+// does not compete with the receiver. The type-erased path forwards through two std::function layers, like HdlcdClient did
+// before the handler was bound at compile time. Reported is the best of all rounds in nanoseconds per data packet.
+
+static size_t       s_Packets = 1000000;
+static const size_t s_PayloadSize = 16;
+static const int    s_Rounds = 5;
+
+// The handler bound at compile time
+class CountingHandler {
+public:
+    CountingHandler(boost::asio::io_service& a_IOService): m_IOService(a_IOService), m_Count(0) {}
+    bool HandleData(std::shared_ptr<const HdlcdPacketData>) { ++m_Count; return true; }
+    void HandleCtrl(const HdlcdPacketCtrl&) {}
+    void HandleClosed() { m_IOService.stop(); }
+    boost::asio::io_service& m_IOService;
+    size_t m_Count;
+};
+
+// Write the stream of data packets to the peer of the receiver
+static void WriteStream(unsigned short a_Port, const std::vector<unsigned char>& a_Stream) {
+    boost::asio::io_service l_IOService;
+    boost::asio::ip::tcp::socket l_Socket(l_IOService);
+    l_Socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), a_Port));
+    boost::asio::write(l_Socket, boost::asio::buffer(a_Stream));
+    l_Socket.shutdown(boost::asio::ip::tcp::socket::shutdown_send);
+}
+
+// Receive the stream via the provided endpoint factory, returns the elapsed time in nanoseconds per data packet
+template<class TStart>
+static double RunRound(const std::vector<unsigned char>& a_Stream, TStart a_Start) {
+    boost::asio::io_service l_IOService;
+    boost::asio::ip::tcp::acceptor l_Acceptor(l_IOService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    boost::asio::ip::tcp::socket l_Socket(l_IOService);
+    std::thread l_Writer(WriteStream, l_Acceptor.local_endpoint().port(), std::cref(a_Stream));
+    l_Acceptor.accept(l_Socket);
+    auto l_FrameEndpoint = std::make_shared<FrameEndpoint>(l_IOService, l_Socket);
+    auto l_Begin = std::chrono::steady_clock::now();
+    size_t l_Count = a_Start(l_IOService, l_FrameEndpoint);
+    auto l_End = std::chrono::steady_clock::now();
+    l_Writer.join();
+    if (l_Count != s_Packets) {
+        std::cerr << "Received " << l_Count << " of " << s_Packets << " data packets" << std::endl;
+        exit(1);
+    } // if
+
+    return (double(std::chrono::duration_cast<std::chrono::nanoseconds>(l_End - l_Begin).count()) / s_Packets);
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of data packets per round
+    if (argc > 1) {
+        s_Packets = std::stoul(argv[1]);
+    } // if
+
+    // Prepare the stream of data packets
+    std::vector<unsigned char> l_Stream;
+    const std::vector<unsigned char> l_Packet = static_cast<const Frame&>(HdlcdPacketData::CreatePacket(std::vector<unsigned char>(s_PayloadSize, 0x55), false)).Serialize();
+    for (size_t l_Index = 0; l_Index < s_Packets; ++l_Index) {
+        l_Stream.insert(l_Stream.end(), l_Packet.begin(), l_Packet.end());
+    } // for
+
+    double l_BestErased = 1e9;
+    double l_BestBound = 1e9;
+    for (int l_Round = 0; l_Round < s_Rounds; ++l_Round) {
+        l_BestErased = std::min(l_BestErased, RunRound(l_Stream, [](boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint) {
+            size_t l_Count = 0;
+            std::function<void(const HdlcdPacketData&)> l_UserCallback = [&l_Count](const HdlcdPacketData&) { ++l_Count; };
+            auto l_PacketEndpoint = std::make_shared<HdlcdPacketEndpoint>(a_IOService, a_FrameEndpoint);
+            l_PacketEndpoint->SetOnDataCallback([&l_UserCallback](std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+                l_UserCallback(*a_PacketData);
+                return true;
+            });
+            l_PacketEndpoint->SetOnClosedCallback([&a_IOService]() { a_IOService.stop(); });
+            l_PacketEndpoint->Start();
+            a_IOService.run();
+            return l_Count;
+        }));
+
+        l_BestBound = std::min(l_BestBound, RunRound(l_Stream, [](boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint) {
+            CountingHandler l_Handler(a_IOService);
+            auto l_PacketEndpoint = std::make_shared<HdlcdPacketEndpointT<CountingHandler>>(a_IOService, a_FrameEndpoint, l_Handler);
+            l_PacketEndpoint->Start();
+            a_IOService.run();
+            return l_Handler.m_Count;
+        }));
+    } // for
+
+    std::cout << "Receive path, " << s_Packets << " data packets of " << s_PayloadSize << " octets, best of " << s_Rounds << " rounds" << std::endl;
+    std::cout << "  type-erased (HdlcdPacketEndpoint):  " << l_BestErased << " ns/packet" << std::endl;
+    std::cout << "  bound (HdlcdPacketEndpointT):        " << l_BestBound << " ns/packet" << std::endl;
+    std::cout << "  saving:                             " << (l_BestErased - l_BestBound) << " ns/packet" << std::endl;
+    return 0;
+}
@@ -0,0 +1,269 @@
+/**
+ * \file      HdlcdImpairmentBenchmark.cpp
+ * \brief     Echo and reconnect benchmark of HdlcdClient over a link impaired by HdlcdImpairmentProxy
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcdClient.h"
+#include "HdlcdHistogram.h"
+#include "HdlcdImpairmentProxy.h"
+#include "HdlcdSessionAcceptor.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Echo and reconnect benchmark over an impaired link: clients connect to an HdlcdSessionAcceptor through an
+// HdlcdImpairmentProxy, each one keeps a single data packet in flight and sends the next one as soon as the echo arrived.
+// A client whose session is closed, e.g., by a reset injected by the proxy, connects again after 10 ms. Reported per
+// scenario are the echoes per second, the round trip times, the number of sessions, and the recovery time from the close
+// of a session to the first echo of the next one.
+
+static size_t s_Clients = 16;
+static unsigned int s_Seconds = 2;
+
+typedef std::chrono::steady_clock Clock;
+
+/*! \class EchoClient
+ *  \brief A client entity that keeps a single data packet in flight and connects again if its session was closed
+ */
+class EchoClient {
+public:
+    EchoClient(boost::asio::io_service& a_IOService, boost::asio::ip::tcp::resolver::iterator a_EndpointIterator, HdlcdHistogram& a_RoundTrips,
+               HdlcdHistogram& a_Recoveries): m_IOService(a_IOService), m_EndpointIterator(a_EndpointIterator), m_RoundTrips(a_RoundTrips),
+        m_Recoveries(a_Recoveries), m_RetryTimer(a_IOService), m_bStopped(false), m_bRecovering(false), m_Sessions(0), m_Echoes(0) {
+    }
+
+    void Start() {
+        Connect();
+    }
+
+    void Stop() {
+        m_bStopped = true;
+        m_RetryTimer.cancel();
+        if (m_Client) {
+            m_Client->SetOnClosedCallback(nullptr);
+            m_Client->Close();
+        } // if
+    }
+
+    uint64_t GetSessions() const { return m_Sessions; }
+    uint64_t GetEchoes() const { return m_Echoes; }
+
+private:
+    void Connect() {
+        // Replaces the client entity of a closed session, never called by one of its callbacks
+        m_Client.reset(new HdlcdClient(m_IOService, "/dev/ttyUSB0", HdlcdSessionDescriptor(SESSION_TYPE_TRX_ALL, SESSION_FLAGS_DELIVER_RCVD)));
+        m_Client->SetOnDataCallback([this](const HdlcdPacketData&) {
+            const Clock::time_point l_Now = Clock::now();
+            m_RoundTrips.Add(std::chrono::duration_cast<std::chrono::microseconds>(l_Now - m_Sent).count());
+            if (m_bRecovering) {
+                m_bRecovering = false;
+                m_Recoveries.Add(std::chrono::duration_cast<std::chrono::microseconds>(l_Now - m_ClosedAt).count());
+            } // if
+
+            ++m_Echoes;
+            Ping();
+        });
+        m_Client->SetOnClosedCallback([this]() {
+            if (!m_bRecovering) {
+                m_bRecovering = true;
+                m_ClosedAt = Clock::now();
+            } // if
+
+            Retry();
+        });
+        m_Client->AsyncConnect(m_EndpointIterator, [this](bool a_bSuccess) {
+            if (!a_bSuccess) {
+                Retry();
+                return;
+            } // if
+
+            ++m_Sessions;
+            Ping();
+        });
+    }
+
+    void Retry() {
+        m_RetryTimer.expires_from_now(std::chrono::milliseconds(10));
+        m_RetryTimer.async_wait([this](const boost::system::error_code& a_ErrorCode) {
+            if ((!a_ErrorCode) && (!m_bStopped)) {
+                Connect();
+            } // if
+        }); // async_wait
+    }
+
+    void Ping() {
+        m_Sent = Clock::now();
+        m_Client->Send(HdlcdPacketData::CreatePacket(std::vector<unsigned char>(64, 0x55), false));
+    }
+
+    // Members
+    boost::asio::io_service& m_IOService;
+    boost::asio::ip::tcp::resolver::iterator m_EndpointIterator;
+    HdlcdHistogram& m_RoundTrips;
+    HdlcdHistogram& m_Recoveries;
+    boost::asio::steady_timer m_RetryTimer;
+    std::unique_ptr<HdlcdClient> m_Client;
+    bool m_bStopped;
+    bool m_bRecovering;          //!< Indicates whether a session was closed and no echo was received since
+    Clock::time_point m_Sent;     //!< The point in time the data packet in flight was sent
+    Clock::time_point m_ClosedAt; //!< The point in time the last session was closed
+    uint64_t m_Sessions;
+    uint64_t m_Echoes;
+};
+
+// Run a single scenario, the proxy resets all connections every a_ResetInterval milliseconds if not zero
+static bool RunScenario(const char* a_Name, const HdlcdImpairment& a_Impairment, unsigned int a_ResetInterval) {
+    boost::asio::io_service l_IOService;
+    HdlcdSessionAcceptor l_Acceptor(l_IOService);
+    std::vector<std::shared_ptr<HdlcdPacketEndpoint>> l_PacketEndpoints;
+    auto l_SessionHandler = [&l_PacketEndpoints](boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint,
+                                                 std::shared_ptr<HdlcdSessionHeader> a_SessionHeader) {
+        // Echo all data packets of data sessions, control sessions are just kept open
+        auto l_PacketEndpoint = std::make_shared<HdlcdPacketEndpoint>(a_IOService, a_FrameEndpoint);
+        std::weak_ptr<HdlcdPacketEndpoint> l_WeakPacketEndpoint(l_PacketEndpoint);
+        if (HdlcdSessionDescriptor(a_SessionHeader->GetServiceAccessPointSpecifier()).GetSessionType() == SESSION_TYPE_TRX_ALL) {
+            l_PacketEndpoint->SetOnDataCallback([l_WeakPacketEndpoint](std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+                l_WeakPacketEndpoint.lock()->Send(HdlcdPacketData::CreatePacket(a_PacketData->GetData(), false));
+                return true;
+            });
+        } // if
+
+        l_PacketEndpoints.emplace_back(l_PacketEndpoint);
+        l_PacketEndpoint->Start();
+    };
+
+    l_Acceptor.SetSessionHandler(SESSION_TYPE_TRX_ALL, l_SessionHandler);
+    l_Acceptor.SetSessionHandler(SESSION_TYPE_TRX_STATUS, l_SessionHandler);
+    boost::system::error_code l_ErrorCode;
+    if (!l_Acceptor.Open(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0), l_ErrorCode)) {
+        std::cerr << "Failed to open the acceptor: " << l_ErrorCode.message() << std::endl;
+        return false;
+    } // if
+
+    HdlcdImpairmentProxy l_Proxy(l_IOService, l_Acceptor.GetLocalEndpoint());
+    l_Proxy.SetSeed(1662);
+    l_Proxy.SetImpairment(a_Impairment);
+    if (!l_Proxy.Open(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0), l_ErrorCode)) {
+        std::cerr << "Failed to open the proxy: " << l_ErrorCode.message() << std::endl;
+        return false;
+    } // if
+
+    boost::asio::ip::tcp::resolver l_Resolver(l_IOService);
+    auto l_EndpointIterator = l_Resolver.resolve(boost::asio::ip::tcp::resolver::query("127.0.0.1", std::to_string(l_Proxy.GetLocalEndpoint().port())));
+    HdlcdHistogram l_RoundTrips;
+    HdlcdHistogram l_Recoveries;
+    std::vector<std::unique_ptr<EchoClient>> l_Clients;
+    for (size_t l_Index = 0; l_Index < s_Clients; ++l_Index) {
+        l_Clients.emplace_back(new EchoClient(l_IOService, l_EndpointIterator, l_RoundTrips, l_Recoveries));
+        l_Clients.back()->Start();
+    } // for
+
+    // Periodic resets of all connections
+    boost::asio::steady_timer l_ResetTimer(l_IOService);
+    std::function<void()> l_ArmResetTimer = [&]() {
+        l_ResetTimer.expires_from_now(std::chrono::milliseconds(a_ResetInterval));
+        l_ResetTimer.async_wait([&](const boost::system::error_code& a_ErrorCode) {
+            if (!a_ErrorCode) {
+                l_Proxy.ResetAll();
+                l_ArmResetTimer();
+            } // if
+        }); // async_wait
+    };
+
+    if (a_ResetInterval) {
+        l_ArmResetTimer();
+    } // if
+
+    // End of the scenario
+    boost::asio::steady_timer l_StopTimer(l_IOService);
+    l_StopTimer.expires_from_now(std::chrono::seconds(s_Seconds));
+    l_StopTimer.async_wait([&](const boost::system::error_code&) {
+        for (auto l_Client = l_Clients.begin(); l_Client != l_Clients.end(); ++l_Client) {
+            (*l_Client)->Stop();
+        } // for
+
+        l_ResetTimer.cancel();
+        l_IOService.stop();
+    }); // async_wait
+
+    l_IOService.run();
+    uint64_t l_Sessions = 0;
+    uint64_t l_Echoes = 0;
+    for (auto l_Client = l_Clients.begin(); l_Client != l_Clients.end(); ++l_Client) {
+        l_Sessions += (*l_Client)->GetSessions();
+        l_Echoes += (*l_Client)->GetEchoes();
+    } // for
+
+    std::cout << a_Name << ":" << std::endl;
+    std::cout << "  echoes per second:     " << (l_Echoes / s_Seconds) << std::endl;
+    std::cout << "  round trip p50/p99:    " << l_RoundTrips.GetPercentile(50) << " / " << l_RoundTrips.GetPercentile(99) << " us" << std::endl;
+    std::cout << "  sessions:              " << l_Sessions << ", proxy resets: " << l_Proxy.GetResets() << std::endl;
+    if (l_Recoveries.GetCount()) {
+        std::cout << "  recovery p50/p99:      " << l_Recoveries.GetPercentile(50) << " / " << l_Recoveries.GetPercentile(99) << " us" << std::endl;
+    } // if
+
+    return (l_Echoes != 0);
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of clients and the duration of each scenario in seconds
+    if (argc > 1) {
+        s_Clients = std::stoul(argv[1]);
+    } // if
+
+    if (argc > 2) {
+        s_Seconds = std::stoul(argv[2]);
+    } // if
+
+    std::cout << s_Clients << " clients, " << s_Seconds << " s per scenario, round trip and recovery times are bucket upper bounds" << std::endl;
+    HdlcdImpairment l_Impairment;
+    bool l_bSuccess = RunScenario("Unimpaired", l_Impairment, 0);
+
+    l_Impairment.m_DelayMilliseconds = 5;
+    l_Impairment.m_JitterMilliseconds = 2;
+    l_bSuccess &= RunScenario("Delay 5 ms, jitter 2 ms per direction", l_Impairment, 0);
+
+    l_bSuccess &= RunScenario("Delay 5 ms, jitter 2 ms, all connections reset every 250 ms", l_Impairment, 250);
+
+    l_Impairment.m_DelayMilliseconds = 1;
+    l_Impairment.m_JitterMilliseconds = 0;
+    l_Impairment.m_StallProbability = 0.01;
+    l_Impairment.m_StallMilliseconds = 100;
+    l_bSuccess &= RunScenario("Delay 1 ms, 1% stalls of 100 ms", l_Impairment, 0);
+    return (l_bSuccess ? 0 : 1);
+}
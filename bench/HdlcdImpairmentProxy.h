@@ -0,0 +1,468 @@
+/**
+ * \file      HdlcdImpairmentProxy.h
+ * \brief     This file contains the header declaration of class HdlcdImpairmentProxy
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_IMPAIRMENT_PROXY_H
+#define HDLCD_IMPAIRMENT_PROXY_H
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+#include <stdint.h>
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+/*! \enum E_PROXY_DIRECTION
+ *  \brief The direction of the traffic passing the proxy
+ */
+typedef enum {
+    PROXY_DIRECTION_UPSTREAM   = 0, //!< From the client to the HDLCd
+    PROXY_DIRECTION_DOWNSTREAM = 1  //!< From the HDLCd to the client
+} E_PROXY_DIRECTION;
+
+/*! \struct HdlcdImpairment
+ *  \brief The impairments applied to one direction of the traffic passing the proxy
+ * 
+ *  The probabilities are evaluated per chunk of data read from a TCP socket
+ */
+struct HdlcdImpairment {
+    HdlcdImpairment(): m_DelayMilliseconds(0), m_JitterMilliseconds(0), m_BytesPerSecond(0), m_StallProbability(0.0), m_StallMilliseconds(0),
+        m_ResetProbability(0.0) {}
+
+    unsigned int m_DelayMilliseconds;  //!< The constant one-way delay
+    unsigned int m_JitterMilliseconds; //!< The maximum random delay added to the constant delay, uniformly distributed
+    uint64_t     m_BytesPerSecond;     //!< The bandwidth cap, zero if unlimited
+    double       m_StallProbability;   //!< The probability to stall the connection, in both directions
+    unsigned int m_StallMilliseconds;  //!< The duration of a stall
+    double       m_ResetProbability;   //!< The probability to reset the connection, in both directions
+};
+
+/*! \class HdlcdImpairmentProxy
+ *  \brief Class HdlcdImpairmentProxy
+ * 
+ *  A TCP proxy to put between clients and an HDLCd, e.g., a mock, to emulate slow or lossy links in a reproducible way.
+ *  Each accepted connection is forwarded to the upstream endpoint, and each direction is impaired by delay, jitter, and a
+ *  bandwidth cap. The order of the forwarded data is preserved. Additionally, connections may stall or be reset, either
+ *  randomly or on request. The random decisions are taken from a generator with a configurable seed. The end of a stream is
+ *  passed on as a half-close, whereas a reset or any other failure of one peer resets the connection to the other peer.
+ *  
+ *  All methods have to be called by the thread running the IOService, thus a benchmark harness may change the impairments
+ *  at any time, e.g., from a timer. Changes apply to data read afterwards. This class is part of the benchmarks and not
+ *  installed, see HdlcdImpairmentBenchmark.cpp.
+ */
+class HdlcdImpairmentProxy {
+public:
+    /*! \brief  The constructor of HdlcdImpairmentProxy objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_UpstreamEndpoint the endpoint of the HDLCd to forward all connections to
+     */
+    HdlcdImpairmentProxy(boost::asio::io_service& a_IOService, boost::asio::ip::tcp::endpoint a_UpstreamEndpoint): m_IOService(a_IOService),
+        m_UpstreamEndpoint(a_UpstreamEndpoint), m_Acceptor(a_IOService), m_QueueLimit(1024 * 1024), m_Connections(0), m_Resets(0), m_Stalls(0) {
+        m_Bytes[PROXY_DIRECTION_UPSTREAM] = 0;
+        m_Bytes[PROXY_DIRECTION_DOWNSTREAM] = 0;
+    }
+
+    /*! \brief  The destructor of HdlcdImpairmentProxy objects
+     */
+    ~HdlcdImpairmentProxy() {
+        Close();
+    }
+
+    /*! \brief  Start accepting connections
+     * 
+     *  \param  a_ListenEndpoint the local endpoint to listen at, the port number may be zero to pick an unused one
+     *  \param  a_ErrorCode the reason of a failure
+     * 
+     *  \retval true the proxy is listening
+     *  \retval false the local endpoint could not be bound
+     *  \return Indicates whether the proxy is listening
+     */
+    bool Open(const boost::asio::ip::tcp::endpoint& a_ListenEndpoint, boost::system::error_code& a_ErrorCode) {
+        m_Acceptor.open(a_ListenEndpoint.protocol(), a_ErrorCode);
+        if (!a_ErrorCode) {
+            m_Acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), a_ErrorCode);
+        } // if
+
+        if (!a_ErrorCode) {
+            m_Acceptor.bind(a_ListenEndpoint, a_ErrorCode);
+        } // if
+
+        if (!a_ErrorCode) {
+            m_Acceptor.listen(boost::asio::socket_base::max_listen_connections, a_ErrorCode);
+        } // if
+
+        if (a_ErrorCode) {
+            boost::system::error_code l_ErrorCode;
+            m_Acceptor.close(l_ErrorCode);
+            return false;
+        } // if
+
+        Accept();
+        return true;
+    }
+
+    /*! \brief  Stop accepting connections and close all forwarded connections
+     */
+    void Close() {
+        boost::system::error_code l_ErrorCode;
+        m_Acceptor.close(l_ErrorCode);
+        ForEachConnection([](Connection& a_Connection) { a_Connection.Abort(false); });
+    }
+
+    /*! \brief  Query the local endpoint the proxy is listening at
+     * 
+     *  \return The local endpoint
+     */
+    boost::asio::ip::tcp::endpoint GetLocalEndpoint() const {
+        boost::system::error_code l_ErrorCode;
+        return m_Acceptor.local_endpoint(l_ErrorCode);
+    }
+
+    /*! \brief  Specify the impairments of a single direction
+     * 
+     *  \param  a_eDirection the direction
+     *  \param  a_Impairment the impairments
+     */
+    void SetImpairment(E_PROXY_DIRECTION a_eDirection, const HdlcdImpairment& a_Impairment) {
+        m_Impairments[a_eDirection] = a_Impairment;
+    }
+
+    /*! \brief  Specify the impairments of both directions
+     * 
+     *  \param  a_Impairment the impairments
+     */
+    void SetImpairment(const HdlcdImpairment& a_Impairment) {
+        SetImpairment(PROXY_DIRECTION_UPSTREAM, a_Impairment);
+        SetImpairment(PROXY_DIRECTION_DOWNSTREAM, a_Impairment);
+    }
+
+    /*! \brief  Seed the generator of all random decisions, to repeat a run exactly
+     * 
+     *  \param  a_Seed the seed
+     */
+    void SetSeed(uint32_t a_Seed) {
+        m_Random.seed(a_Seed);
+    }
+
+    /*! \brief  Specify the number of octets buffered per direction before the proxy stops reading
+     * 
+     *  \param  a_QueueLimit the number of octets buffered per direction
+     */
+    void SetQueueLimit(size_t a_QueueLimit) {
+        m_QueueLimit = (a_QueueLimit ? a_QueueLimit : 1);
+    }
+
+    /*! \brief  Stall all connections, in both directions
+     * 
+     *  \param  a_Milliseconds the duration of the stall
+     */
+    void StallAll(unsigned int a_Milliseconds) {
+        ForEachConnection([a_Milliseconds](Connection& a_Connection) { a_Connection.Stall(std::chrono::milliseconds(a_Milliseconds)); });
+    }
+
+    /*! \brief  Reset all connections, i.e., abort them with a TCP RST
+     */
+    void ResetAll() {
+        ForEachConnection([](Connection& a_Connection) { a_Connection.Abort(true); });
+    }
+
+    uint64_t GetConnections() const { return m_Connections; } //!< The number of accepted connections
+    uint64_t GetResets() const { return m_Resets; }           //!< The number of reset connections
+    uint64_t GetStalls() const { return m_Stalls; }           //!< The number of stalls
+    uint64_t GetBytes(E_PROXY_DIRECTION a_eDirection) const { return m_Bytes[a_eDirection]; } //!< The number of forwarded octets
+
+private:
+    typedef std::chrono::steady_clock::time_point Timestamp;
+
+    /*! \class Connection
+     *  \brief A forwarded connection, socket 0 is the client side and socket 1 the upstream side
+     */
+    class Connection: public std::enable_shared_from_this<Connection> {
+    public:
+        Connection(HdlcdImpairmentProxy& a_Proxy): m_Proxy(a_Proxy), m_bClosed(false), m_StallUntil() {
+            for (unsigned int l_Index = 0; l_Index < 2; ++l_Index) {
+                m_Sockets[l_Index].reset(new boost::asio::ip::tcp::socket(a_Proxy.m_IOService));
+                m_Pipes[l_Index].reset(new Pipe(a_Proxy.m_IOService));
+            } // for
+        }
+
+        boost::asio::ip::tcp::socket& GetClientSocket() { return *m_Sockets[0]; }
+
+        void Start() {
+            auto self(this->shared_from_this());
+            m_Sockets[1]->async_connect(m_Proxy.m_UpstreamEndpoint, [this, self](const boost::system::error_code& a_ErrorCode) {
+                if (a_ErrorCode) {
+                    Abort(false);
+                    return;
+                } // if
+
+                Read(PROXY_DIRECTION_UPSTREAM);
+                Read(PROXY_DIRECTION_DOWNSTREAM);
+            }); // async_connect
+        }
+
+        void Stall(std::chrono::milliseconds a_Duration) {
+            ++m_Proxy.m_Stalls;
+            m_StallUntil = std::max(m_StallUntil, (std::chrono::steady_clock::now() + a_Duration));
+        }
+
+        void Abort(bool a_bReset) {
+            if (m_bClosed) {
+                return;
+            } // if
+
+            m_bClosed = true;
+            if (a_bReset) {
+                ++m_Proxy.m_Resets;
+            } // if
+
+            for (unsigned int l_Index = 0; l_Index < 2; ++l_Index) {
+                boost::system::error_code l_ErrorCode;
+                if (a_bReset) {
+                    // A linger timeout of zero lets close() send a TCP RST
+                    m_Sockets[l_Index]->set_option(boost::asio::socket_base::linger(true, 0), l_ErrorCode);
+                } // if
+
+                m_Sockets[l_Index]->close(l_ErrorCode);
+                m_Pipes[l_Index]->m_Timer.cancel();
+            } // for
+        }
+
+    private:
+        /*! \struct Pipe
+         *  \brief One direction of a connection
+         */
+        struct Pipe {
+            explicit Pipe(boost::asio::io_service& a_IOService): m_Timer(a_IOService), m_QueuedBytes(0), m_bReading(false), m_bWriting(false),
+                m_bTimerArmed(false) {}
+            std::deque<std::pair<Timestamp, std::shared_ptr<std::vector<unsigned char>>>> m_Queue; //!< The chunks and their release times, an empty chunk marks the end of the stream
+            boost::asio::steady_timer m_Timer; //!< The timer to wait for the release of the next chunk
+            Timestamp m_LastRelease;           //!< The release time of the chunk enqueued last
+            Timestamp m_LineFree;              //!< The point in time the emulated line is free again, regarding the bandwidth cap
+            size_t    m_QueuedBytes;
+            bool      m_bReading;
+            bool      m_bWriting;
+            bool      m_bTimerArmed;
+        };
+
+        void Read(E_PROXY_DIRECTION a_eDirection) {
+            Pipe& l_Pipe = *m_Pipes[a_eDirection];
+            if ((m_bClosed) || (l_Pipe.m_bReading) || (l_Pipe.m_QueuedBytes >= m_Proxy.m_QueueLimit)) {
+                return;
+            } // if
+
+            l_Pipe.m_bReading = true;
+            auto self(this->shared_from_this());
+            auto l_Buffer = std::make_shared<std::vector<unsigned char>>(16384);
+            m_Sockets[a_eDirection]->async_read_some(boost::asio::buffer(*l_Buffer), [this, self, a_eDirection, l_Buffer](const boost::system::error_code& a_ErrorCode, std::size_t a_BytesRead) {
+                m_Pipes[a_eDirection]->m_bReading = false;
+                if (m_bClosed) {
+                    return;
+                } // if
+
+                if ((a_ErrorCode) && (a_ErrorCode != boost::asio::error::eof)) {
+                    // A failed peer, e.g., one that sent a TCP RST, is passed on as a reset instead of a half-close
+                    Abort(true);
+                    return;
+                } // if
+
+                l_Buffer->resize(a_ErrorCode ? 0 : a_BytesRead);
+                Enqueue(a_eDirection, l_Buffer);
+                if (!a_ErrorCode) {
+                    Read(a_eDirection);
+                } // if
+            }); // async_read_some
+        }
+
+        void Enqueue(E_PROXY_DIRECTION a_eDirection, std::shared_ptr<std::vector<unsigned char>> a_Chunk) {
+            Pipe& l_Pipe = *m_Pipes[a_eDirection];
+            const HdlcdImpairment& l_Impairment = m_Proxy.m_Impairments[a_eDirection];
+            const Timestamp l_Now = std::chrono::steady_clock::now();
+            if ((l_Impairment.m_ResetProbability > 0.0) && (m_Proxy.Draw() < l_Impairment.m_ResetProbability)) {
+                Abort(true);
+                return;
+            } // if
+
+            if ((l_Impairment.m_StallProbability > 0.0) && (m_Proxy.Draw() < l_Impairment.m_StallProbability)) {
+                Stall(std::chrono::milliseconds(l_Impairment.m_StallMilliseconds));
+            } // if
+
+            // Delay and jitter, but never overtake the previous chunk
+            Timestamp l_Release = (l_Now + std::chrono::milliseconds(l_Impairment.m_DelayMilliseconds));
+            if (l_Impairment.m_JitterMilliseconds) {
+                l_Release += std::chrono::microseconds(int64_t(m_Proxy.Draw() * l_Impairment.m_JitterMilliseconds * 1000));
+            } // if
+
+            if (l_Impairment.m_BytesPerSecond) {
+                // The chunk occupies the emulated line for its transmission time
+                l_Pipe.m_LineFree = (std::max(l_Pipe.m_LineFree, l_Now) + std::chrono::microseconds(int64_t(a_Chunk->size() * 1000000 / l_Impairment.m_BytesPerSecond)));
+                l_Release = std::max(l_Release, l_Pipe.m_LineFree);
+            } // if
+
+            l_Release = std::max(l_Release, l_Pipe.m_LastRelease);
+            l_Pipe.m_LastRelease = l_Release;
+            l_Pipe.m_QueuedBytes += a_Chunk->size();
+            l_Pipe.m_Queue.emplace_back(l_Release, a_Chunk);
+            Pump(a_eDirection);
+        }
+
+        void Pump(E_PROXY_DIRECTION a_eDirection) {
+            Pipe& l_Pipe = *m_Pipes[a_eDirection];
+            if ((m_bClosed) || (l_Pipe.m_bWriting) || (l_Pipe.m_bTimerArmed) || (l_Pipe.m_Queue.empty())) {
+                return;
+            } // if
+
+            auto self(this->shared_from_this());
+            const Timestamp l_Due = std::max(l_Pipe.m_Queue.front().first, m_StallUntil);
+            if (l_Due > std::chrono::steady_clock::now()) {
+                l_Pipe.m_bTimerArmed = true;
+                l_Pipe.m_Timer.expires_at(l_Due);
+                l_Pipe.m_Timer.async_wait([this, self, a_eDirection](const boost::system::error_code& a_ErrorCode) {
+                    m_Pipes[a_eDirection]->m_bTimerArmed = false;
+                    if (!a_ErrorCode) {
+                        Pump(a_eDirection);
+                    } // if
+                }); // async_wait
+                return;
+            } // if
+
+            // Write to the socket of the other side
+            boost::asio::ip::tcp::socket& l_Destination = *m_Sockets[1 - a_eDirection];
+            std::shared_ptr<std::vector<unsigned char>> l_Chunk = l_Pipe.m_Queue.front().second;
+            if (l_Chunk->empty()) {
+                // End of stream: pass the half-close on
+                boost::system::error_code l_ErrorCode;
+                l_Destination.shutdown(boost::asio::ip::tcp::socket::shutdown_send, l_ErrorCode);
+                l_Pipe.m_Queue.pop_front();
+                return;
+            } // if
+
+            l_Pipe.m_bWriting = true;
+            boost::asio::async_write(l_Destination, boost::asio::buffer(*l_Chunk), [this, self, a_eDirection, l_Chunk](const boost::system::error_code& a_ErrorCode, std::size_t) {
+                Pipe& l_Pipe = *m_Pipes[a_eDirection];
+                l_Pipe.m_bWriting = false;
+                if (a_ErrorCode) {
+                    Abort(false);
+                    return;
+                } // if
+
+                m_Proxy.m_Bytes[a_eDirection] += l_Chunk->size();
+                l_Pipe.m_QueuedBytes -= l_Chunk->size();
+                l_Pipe.m_Queue.pop_front();
+                Read(a_eDirection);
+                Pump(a_eDirection);
+            }); // async_write
+        }
+
+        // Members
+        HdlcdImpairmentProxy& m_Proxy;
+        std::unique_ptr<boost::asio::ip::tcp::socket> m_Sockets[2];
+        std::unique_ptr<Pipe> m_Pipes[2];
+        bool m_bClosed;
+        Timestamp m_StallUntil; //!< Both directions are stalled until this point in time
+    };
+
+    friend class Connection;
+
+    /*! \brief  Accept the next connection
+     */
+    void Accept() {
+        auto l_Connection = std::make_shared<Connection>(*this);
+        m_Acceptor.async_accept(l_Connection->GetClientSocket(), [this, l_Connection](const boost::system::error_code& a_ErrorCode) {
+            if (a_ErrorCode == boost::asio::error::operation_aborted) {
+                return;
+            } // if
+
+            if (!a_ErrorCode) {
+                ++m_Connections;
+                ForEachConnection([](Connection&) {}); // Forget closed connections
+                m_ConnectionList.push_back(l_Connection);
+                l_Connection->Start();
+            } // if
+
+            if (m_Acceptor.is_open()) {
+                Accept();
+            } // if
+        }); // async_accept
+    }
+
+    /*! \brief  Apply a function to all connections that still exist, and forget the others
+     * 
+     *  \param  a_Function the function to apply
+     */
+    template <class TFunction>
+    void ForEachConnection(TFunction a_Function) {
+        for (auto l_Iterator = m_ConnectionList.begin(); l_Iterator != m_ConnectionList.end();) {
+            auto l_Connection = l_Iterator->lock();
+            if (l_Connection) {
+                a_Function(*l_Connection);
+                ++l_Iterator;
+            } else {
+                l_Iterator = m_ConnectionList.erase(l_Iterator);
+            } // else
+        } // for
+    }
+
+    /*! \brief  Draw a uniformly distributed random number
+     * 
+     *  \return A random number in the range [0, 1)
+     */
+    double Draw() {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(m_Random);
+    }
+
+    // Members
+    boost::asio::io_service& m_IOService;
+    const boost::asio::ip::tcp::endpoint m_UpstreamEndpoint; //!< The endpoint of the HDLCd
+    boost::asio::ip::tcp::acceptor m_Acceptor;
+    HdlcdImpairment m_Impairments[2]; //!< The impairments, indexed by direction
+    std::mt19937 m_Random;            //!< The generator of all random decisions
+    size_t m_QueueLimit;              //!< The number of octets buffered per direction before the proxy stops reading
+    std::list<std::weak_ptr<Connection>> m_ConnectionList; //!< All accepted connections, pruned lazily
+    uint64_t m_Connections;
+    uint64_t m_Resets;
+    uint64_t m_Stalls;
+    uint64_t m_Bytes[2];              //!< The number of forwarded octets, indexed by direction
+};
+
+#endif // HDLCD_IMPAIRMENT_PROXY_H
@@ -0,0 +1,221 @@
+/**
+ * \file      HdlcByteStuffing.h
+ * \brief     This file contains the header declaration of class HdlcByteStuffing
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLC_BYTE_STUFFING_H
+#define HDLC_BYTE_STUFFING_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HDLC_BYTE_STUFFING_HAS_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*! \class HdlcByteStuffing
+ *  \brief Class HdlcByteStuffing
+ * 
+ *  Conversion between the payload form and the stuffed on-wire form of HDLC frames according to RFC 1662: each flag
+ *  octet 0x7E and each escape octet 0x7D is transmitted as the escape octet followed by the original octet XOR 0x20.
+ *  
+ *  Both directions search for the next octet requiring treatment and copy the unaffected runs in between as a whole.
+ *  On x86-64 the search inspects 16 octets per step using SSE2, or 32 octets per step using AVX2 if the CPU supports it,
+ *  selected at runtime. Otherwise a scalar search is used.
+ */
+class HdlcByteStuffing {
+public:
+    /*! \brief The special octets of the HDLC framing
+     */
+    typedef enum {
+        FLAG   = 0x7E, //!< The flag octet delimiting HDLC frames
+        ESCAPE = 0x7D, //!< The escape octet
+        XOR    = 0x20  //!< The value escaped octets are XORed with
+    } E_OCTET;
+
+    /*! \brief  Stuff a buffer and append the result
+     * 
+     *  \param  a_Buffer the buffer in payload form
+     *  \param  a_Length the number of octets in the buffer
+     *  \param  a_Stuffed the vector to append the stuffed octets to
+     */
+    static void Stuff(const unsigned char* a_Buffer, size_t a_Length, std::vector<unsigned char>& a_Stuffed) {
+        // Reserve for the common case of few octets to escape, the vector grows on demand otherwise
+        a_Stuffed.reserve(a_Stuffed.size() + a_Length + (a_Length >> 5) + 2);
+        while (a_Length) {
+            size_t l_Run = FindSpecial(a_Buffer, a_Length);
+            a_Stuffed.insert(a_Stuffed.end(), a_Buffer, a_Buffer + l_Run);
+            if (l_Run == a_Length) {
+                break;
+            } // if
+
+            a_Stuffed.push_back(static_cast<unsigned char>(ESCAPE));
+            a_Stuffed.push_back(static_cast<unsigned char>(a_Buffer[l_Run] ^ XOR));
+            a_Buffer += (l_Run + 1);
+            a_Length -= (l_Run + 1);
+        } // while
+    }
+
+    /*! \brief  Stuff a buffer and append it as a complete frame enclosed by flags
+     * 
+     *  \param  a_Buffer the frame in payload form
+     *  \param  a_Length the number of octets of the frame
+     *  \param  a_Stuffed the vector to append the stuffed frame to
+     */
+    static void StuffFrame(const unsigned char* a_Buffer, size_t a_Length, std::vector<unsigned char>& a_Stuffed) {
+        a_Stuffed.push_back(static_cast<unsigned char>(FLAG));
+        Stuff(a_Buffer, a_Length, a_Stuffed);
+        a_Stuffed.push_back(static_cast<unsigned char>(FLAG));
+    }
+
+    /*! \brief  Unstuff a buffer and append the result
+     * 
+     *  The buffer must contain the content of a single frame without flags.
+     * 
+     *  \param  a_Buffer the buffer in stuffed form
+     *  \param  a_Length the number of octets in the buffer
+     *  \param  a_Unstuffed the vector to append the unstuffed octets to
+     * 
+     *  \retval true the buffer was unstuffed successfully
+     *  \retval false the buffer contains a flag or ends with an escape octet, the appended octets are incomplete
+     *  \return Indicates whether the buffer was valid
+     */
+    static bool Unstuff(const unsigned char* a_Buffer, size_t a_Length, std::vector<unsigned char>& a_Unstuffed) {
+        a_Unstuffed.reserve(a_Unstuffed.size() + a_Length);
+        while (a_Length) {
+            size_t l_Run = FindSpecial(a_Buffer, a_Length);
+            a_Unstuffed.insert(a_Unstuffed.end(), a_Buffer, a_Buffer + l_Run);
+            if (l_Run == a_Length) {
+                break;
+            } // if
+
+            if ((a_Buffer[l_Run] == FLAG) || ((l_Run + 1) == a_Length)) {
+                return false;
+            } // if
+
+            a_Unstuffed.push_back(static_cast<unsigned char>(a_Buffer[l_Run + 1] ^ XOR));
+            a_Buffer += (l_Run + 2);
+            a_Length -= (l_Run + 2);
+        } // while
+
+        return true;
+    }
+
+    /*! \brief  Find the first flag or escape octet in a buffer
+     * 
+     *  \param  a_Buffer the buffer to search
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The offset of the first flag or escape octet, a_Length if there is none
+     */
+    static size_t FindSpecial(const unsigned char* a_Buffer, size_t a_Length) {
+#ifdef HDLC_BYTE_STUFFING_HAS_SIMD
+        static const bool s_bHasAvx2 = __builtin_cpu_supports("avx2");
+        if (a_Length >= 32) {
+            return (s_bHasAvx2 ? FindSpecialAvx2(a_Buffer, a_Length) : FindSpecialSse2(a_Buffer, a_Length));
+        } // if
+#endif
+        return FindSpecialScalar(a_Buffer, a_Length);
+    }
+
+    /*! \brief  Find the first flag or escape octet in a buffer inspecting one octet at a time
+     * 
+     *  \param  a_Buffer the buffer to search
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The offset of the first flag or escape octet, a_Length if there is none
+     */
+    static size_t FindSpecialScalar(const unsigned char* a_Buffer, size_t a_Length) {
+        for (size_t l_Index = 0; l_Index < a_Length; ++l_Index) {
+            if ((a_Buffer[l_Index] == FLAG) || (a_Buffer[l_Index] == ESCAPE)) {
+                return l_Index;
+            } // if
+        } // for
+
+        return a_Length;
+    }
+
+#ifdef HDLC_BYTE_STUFFING_HAS_SIMD
+    /*! \brief  Find the first flag or escape octet in a buffer inspecting 16 octets at a time
+     * 
+     *  \param  a_Buffer the buffer to search
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The offset of the first flag or escape octet, a_Length if there is none
+     */
+    static size_t FindSpecialSse2(const unsigned char* a_Buffer, size_t a_Length) {
+        const __m128i l_Flag   = _mm_set1_epi8(char(FLAG));
+        const __m128i l_Escape = _mm_set1_epi8(char(ESCAPE));
+        size_t l_Offset = 0;
+        for (; (l_Offset + 16) <= a_Length; l_Offset += 16) {
+            __m128i l_Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + l_Offset));
+            unsigned int l_Mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(l_Block, l_Flag), _mm_cmpeq_epi8(l_Block, l_Escape)));
+            if (l_Mask) {
+                return (l_Offset + __builtin_ctz(l_Mask));
+            } // if
+        } // for
+
+        return (l_Offset + FindSpecialScalar(a_Buffer + l_Offset, a_Length - l_Offset));
+    }
+
+    /*! \brief  Find the first flag or escape octet in a buffer inspecting 32 octets at a time
+     * 
+     *  \param  a_Buffer the buffer to search
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The offset of the first flag or escape octet, a_Length if there is none
+     */
+    __attribute__((target("avx2")))
+    static size_t FindSpecialAvx2(const unsigned char* a_Buffer, size_t a_Length) {
+        const __m256i l_Flag   = _mm256_set1_epi8(char(FLAG));
+        const __m256i l_Escape = _mm256_set1_epi8(char(ESCAPE));
+        size_t l_Offset = 0;
+        for (; (l_Offset + 32) <= a_Length; l_Offset += 32) {
+            __m256i l_Block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_Buffer + l_Offset));
+            unsigned int l_Mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(l_Block, l_Flag), _mm256_cmpeq_epi8(l_Block, l_Escape)));
+            if (l_Mask) {
+                return (l_Offset + __builtin_ctz(l_Mask));
+            } // if
+        } // for
+
+        return (l_Offset + FindSpecialScalar(a_Buffer + l_Offset, a_Length - l_Offset));
+    }
+#endif // HDLC_BYTE_STUFFING_HAS_SIMD
+};
+
+#endif // HDLC_BYTE_STUFFING_H
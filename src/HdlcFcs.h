@@ -0,0 +1,305 @@
+/**
+ * \file      HdlcFcs.h
+ * \brief     This file contains the header declaration of class HdlcFcs
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLC_FCS_H
+#define HDLC_FCS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HDLC_FCS_HAS_PCLMUL 1
+#include <immintrin.h>
+#endif
+
+/*! \class HdlcFcs
+ *  \brief Class HdlcFcs
+ * 
+ *  Calculation and verification of the frame check sequences of HDLC frames according to RFC 1662: FCS-16 (CRC-16/X.25)
+ *  and FCS-32 (CRC-32). Both are calculated eight octets at a time using sliced lookup tables. On x86 CPUs supporting
+ *  carry-less multiplication, long buffers are folded via PCLMULQDQ to calculate the FCS-32, selected at runtime.
+ *  
+ *  The FCS is transmitted least significant octet first. Calculating the FCS over a frame including its FCS yields a
+ *  constant residue if the frame is intact, thus there is no need to locate and extract the transmitted FCS.
+ */
+class HdlcFcs {
+public:
+    static const uint16_t FCS16_INIT = 0xFFFF; //!< The initial value of the FCS-16 calculation
+    static const uint16_t FCS16_GOOD = 0xF0B8; //!< The FCS-16 residue of an intact frame
+    static const uint32_t FCS32_INIT = 0xFFFFFFFF; //!< The initial value of the FCS-32 calculation
+    static const uint32_t FCS32_GOOD = 0xDEBB20E3; //!< The FCS-32 residue of an intact frame
+
+    /*! \brief  Continue the calculation of an FCS-16
+     * 
+     *  \param  a_Fcs the FCS calculated so far, FCS16_INIT to start a new calculation
+     *  \param  a_Buffer the buffer of octets
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The updated FCS, to be inverted before transmission
+     */
+    static uint16_t Fcs16(uint16_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+        const Tables& l_Tables = GetTables();
+        while (a_Length >= 8) {
+            uint32_t l_Low  = (ReadLittleEndian32(a_Buffer) ^ a_Fcs);
+            uint32_t l_High = ReadLittleEndian32(a_Buffer + 4);
+            a_Fcs = (l_Tables.m_Fcs16[7][l_Low & 0xFF] ^ l_Tables.m_Fcs16[6][(l_Low >> 8) & 0xFF] ^
+                     l_Tables.m_Fcs16[5][(l_Low >> 16) & 0xFF] ^ l_Tables.m_Fcs16[4][l_Low >> 24] ^
+                     l_Tables.m_Fcs16[3][l_High & 0xFF] ^ l_Tables.m_Fcs16[2][(l_High >> 8) & 0xFF] ^
+                     l_Tables.m_Fcs16[1][(l_High >> 16) & 0xFF] ^ l_Tables.m_Fcs16[0][l_High >> 24]);
+            a_Buffer += 8;
+            a_Length -= 8;
+        } // while
+
+        while (a_Length--) {
+            a_Fcs = ((a_Fcs >> 8) ^ l_Tables.m_Fcs16[0][(a_Fcs ^ *a_Buffer++) & 0xFF]);
+        } // while
+
+        return a_Fcs;
+    }
+
+    /*! \brief  Continue the calculation of an FCS-32
+     * 
+     *  \param  a_Fcs the FCS calculated so far, FCS32_INIT to start a new calculation
+     *  \param  a_Buffer the buffer of octets
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The updated FCS, to be inverted before transmission
+     */
+    static uint32_t Fcs32(uint32_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+#ifdef HDLC_FCS_HAS_PCLMUL
+        if ((a_Length >= 64) && (HasPclmul())) {
+            size_t l_Folded = (a_Length & ~size_t(15));
+            a_Fcs = Fcs32Pclmul(a_Fcs, a_Buffer, l_Folded);
+            a_Buffer += l_Folded;
+            a_Length -= l_Folded;
+        } // if
+#endif
+        return Fcs32Sliced(a_Fcs, a_Buffer, a_Length);
+    }
+
+    /*! \brief  Verify the FCS-16 of a frame
+     * 
+     *  \param  a_Frame the frame including its FCS-16
+     *  \param  a_Length the length of the frame including its FCS-16
+     * 
+     *  \return Indicates whether the FCS-16 is valid
+     */
+    static bool CheckFcs16(const unsigned char* a_Frame, size_t a_Length) {
+        return ((a_Length >= 2) && (Fcs16(FCS16_INIT, a_Frame, a_Length) == FCS16_GOOD));
+    }
+
+    /*! \brief  Verify the FCS-32 of a frame
+     * 
+     *  \param  a_Frame the frame including its FCS-32
+     *  \param  a_Length the length of the frame including its FCS-32
+     * 
+     *  \return Indicates whether the FCS-32 is valid
+     */
+    static bool CheckFcs32(const unsigned char* a_Frame, size_t a_Length) {
+        return ((a_Length >= 4) && (Fcs32(FCS32_INIT, a_Frame, a_Length) == FCS32_GOOD));
+    }
+
+    /*! \brief  Continue the calculation of an FCS-32 using the sliced lookup tables only
+     * 
+     *  \param  a_Fcs the FCS calculated so far, FCS32_INIT to start a new calculation
+     *  \param  a_Buffer the buffer of octets
+     *  \param  a_Length the number of octets in the buffer
+     * 
+     *  \return The updated FCS, to be inverted before transmission
+     */
+    static uint32_t Fcs32Sliced(uint32_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+        const Tables& l_Tables = GetTables();
+        while (a_Length >= 8) {
+            uint32_t l_Low  = (ReadLittleEndian32(a_Buffer) ^ a_Fcs);
+            uint32_t l_High = ReadLittleEndian32(a_Buffer + 4);
+            a_Fcs = (l_Tables.m_Fcs32[7][l_Low & 0xFF] ^ l_Tables.m_Fcs32[6][(l_Low >> 8) & 0xFF] ^
+                     l_Tables.m_Fcs32[5][(l_Low >> 16) & 0xFF] ^ l_Tables.m_Fcs32[4][l_Low >> 24] ^
+                     l_Tables.m_Fcs32[3][l_High & 0xFF] ^ l_Tables.m_Fcs32[2][(l_High >> 8) & 0xFF] ^
+                     l_Tables.m_Fcs32[1][(l_High >> 16) & 0xFF] ^ l_Tables.m_Fcs32[0][l_High >> 24]);
+            a_Buffer += 8;
+            a_Length -= 8;
+        } // while
+
+        while (a_Length--) {
+            a_Fcs = ((a_Fcs >> 8) ^ l_Tables.m_Fcs32[0][(a_Fcs ^ *a_Buffer++) & 0xFF]);
+        } // while
+
+        return a_Fcs;
+    }
+
+private:
+    /*! \struct Tables
+     *  \brief The sliced lookup tables of both FCS variants
+     */
+    struct Tables {
+        Tables() {
+            for (unsigned int l_Index = 0; l_Index < 256; ++l_Index) {
+                uint16_t l_Fcs16 = l_Index;
+                uint32_t l_Fcs32 = l_Index;
+                for (unsigned int l_Bit = 0; l_Bit < 8; ++l_Bit) {
+                    l_Fcs16 = ((l_Fcs16 & 1) ? ((l_Fcs16 >> 1) ^ 0x8408) : (l_Fcs16 >> 1));
+                    l_Fcs32 = ((l_Fcs32 & 1) ? ((l_Fcs32 >> 1) ^ 0xEDB88320) : (l_Fcs32 >> 1));
+                } // for
+
+                m_Fcs16[0][l_Index] = l_Fcs16;
+                m_Fcs32[0][l_Index] = l_Fcs32;
+            } // for
+
+            for (unsigned int l_Slice = 1; l_Slice < 8; ++l_Slice) {
+                for (unsigned int l_Index = 0; l_Index < 256; ++l_Index) {
+                    m_Fcs16[l_Slice][l_Index] = ((m_Fcs16[l_Slice - 1][l_Index] >> 8) ^ m_Fcs16[0][m_Fcs16[l_Slice - 1][l_Index] & 0xFF]);
+                    m_Fcs32[l_Slice][l_Index] = ((m_Fcs32[l_Slice - 1][l_Index] >> 8) ^ m_Fcs32[0][m_Fcs32[l_Slice - 1][l_Index] & 0xFF]);
+                } // for
+            } // for
+        }
+
+        uint16_t m_Fcs16[8][256]; //!< Slice n processes an octet followed by n further octets
+        uint32_t m_Fcs32[8][256]; //!< Slice n processes an octet followed by n further octets
+    };
+
+    /*! \brief  Access the sliced lookup tables, they are created on first use
+     * 
+     *  \return The sliced lookup tables
+     */
+    static const Tables& GetTables() {
+        static const Tables s_Tables;
+        return s_Tables;
+    }
+
+    /*! \brief  Read four octets in little endian byte order
+     * 
+     *  \param  a_Buffer the buffer containing at least four octets
+     * 
+     *  \return The value of the four octets
+     */
+    static uint32_t ReadLittleEndian32(const unsigned char* a_Buffer) {
+        return (uint32_t(a_Buffer[0]) | (uint32_t(a_Buffer[1]) << 8) | (uint32_t(a_Buffer[2]) << 16) | (uint32_t(a_Buffer[3]) << 24));
+    }
+
+#ifdef HDLC_FCS_HAS_PCLMUL
+    /*! \brief  Query whether the CPU supports carry-less multiplication
+     * 
+     *  \return Indicates whether PCLMULQDQ and SSE4.1 are available
+     */
+    static bool HasPclmul() {
+        static const bool s_bHasPclmul = (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"));
+        return s_bHasPclmul;
+    }
+
+    /*! \brief  Calculate an FCS-32 by folding with carry-less multiplications
+     * 
+     *  Follows "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel, 2009,
+     *  using the constants of the bit-reflected domain.
+     * 
+     *  \param  a_Fcs the FCS calculated so far
+     *  \param  a_Buffer the buffer of octets
+     *  \param  a_Length the number of octets in the buffer, at least 64 and a multiple of 16
+     * 
+     *  \return The updated FCS
+     */
+    __attribute__((target("pclmul,sse4.1")))
+    static uint32_t Fcs32Pclmul(uint32_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+        const __m128i l_K1K2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+        const __m128i l_K3K4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+        const __m128i l_K5K0 = _mm_set_epi64x(0, 0x0163CD6124LL);
+        const __m128i l_Poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+        const __m128i l_Mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        // Load the first block of 64 octets
+        __m128i l_X1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x00));
+        __m128i l_X2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x10));
+        __m128i l_X3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x20));
+        __m128i l_X4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x30));
+        l_X1 = _mm_xor_si128(l_X1, _mm_cvtsi32_si128(a_Fcs));
+        a_Buffer += 64;
+        a_Length -= 64;
+
+        // Fold four blocks of 16 octets in parallel
+        while (a_Length >= 64) {
+            l_X1 = Fold(l_X1, l_K1K2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x00)));
+            l_X2 = Fold(l_X2, l_K1K2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x10)));
+            l_X3 = Fold(l_X3, l_K1K2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x20)));
+            l_X4 = Fold(l_X4, l_K1K2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer + 0x30)));
+            a_Buffer += 64;
+            a_Length -= 64;
+        } // while
+
+        // Fold into 128 bits
+        l_X1 = Fold(l_X1, l_K3K4, l_X2);
+        l_X1 = Fold(l_X1, l_K3K4, l_X3);
+        l_X1 = Fold(l_X1, l_K3K4, l_X4);
+
+        // Fold remaining blocks of 16 octets
+        while (a_Length >= 16) {
+            l_X1 = Fold(l_X1, l_K3K4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_Buffer)));
+            a_Buffer += 16;
+            a_Length -= 16;
+        } // while
+
+        // Fold 128 bits to 64 bits
+        __m128i l_X2Low = _mm_clmulepi64_si128(l_X1, l_K3K4, 0x10);
+        l_X1 = _mm_xor_si128(_mm_srli_si128(l_X1, 8), l_X2Low);
+        __m128i l_X1High = _mm_srli_si128(l_X1, 4);
+        l_X1 = _mm_clmulepi64_si128(_mm_and_si128(l_X1, l_Mask), l_K5K0, 0x00);
+        l_X1 = _mm_xor_si128(l_X1, l_X1High);
+
+        // Barrett reduction to 32 bits
+        __m128i l_Reduced = _mm_clmulepi64_si128(_mm_and_si128(l_X1, l_Mask), l_Poly, 0x10);
+        l_Reduced = _mm_clmulepi64_si128(_mm_and_si128(l_Reduced, l_Mask), l_Poly, 0x00);
+        l_X1 = _mm_xor_si128(l_X1, l_Reduced);
+        return uint32_t(_mm_extract_epi32(l_X1, 1));
+    }
+
+    /*! \brief  Fold a block of 128 bits onto the next one
+     * 
+     *  \param  a_Block the folded block
+     *  \param  a_Constants the folding constants
+     *  \param  a_Next the next block
+     * 
+     *  \return The folded block
+     */
+    __attribute__((target("pclmul,sse4.1")))
+    static __m128i Fold(__m128i a_Block, __m128i a_Constants, __m128i a_Next) {
+        __m128i l_Low  = _mm_clmulepi64_si128(a_Block, a_Constants, 0x00);
+        __m128i l_High = _mm_clmulepi64_si128(a_Block, a_Constants, 0x11);
+        return _mm_xor_si128(_mm_xor_si128(l_High, l_Low), a_Next);
+    }
+#endif // HDLC_FCS_HAS_PCLMUL
+};
+
+#endif // HDLC_FCS_H
@@ -0,0 +1,232 @@
+/**
+ * \file      HdlcFrameDissector.h
+ * \brief     This file contains the header declaration of class HdlcFrameDissector
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLC_FRAME_DISSECTOR_H
+#define HDLC_FRAME_DISSECTOR_H
+
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "HdlcFcs.h"
+#include "HdlcdPacketData.h"
+
+/*! \enum E_HDLC_FRAME_TYPE
+ *  \brief The enum E_HDLC_FRAME_TYPE to specify the classes of HDLC frames
+ */
+typedef enum {
+    HDLC_FRAME_TYPE_I       = 0x00, //!< Information frame
+    HDLC_FRAME_TYPE_S       = 0x01, //!< Supervisory frame
+    HDLC_FRAME_TYPE_U       = 0x03, //!< Unnumbered frame
+    HDLC_FRAME_TYPE_INVALID = 0xFF  //!< The frame is too short to be classified
+} E_HDLC_FRAME_TYPE;
+
+/*! \enum E_HDLC_FCS_TYPE
+ *  \brief The enum E_HDLC_FCS_TYPE to specify the frame check sequence trailing each HDLC frame
+ */
+typedef enum {
+    HDLC_FCS_TYPE_NONE = 0, //!< The frames carry no FCS, e.g., because it was already stripped
+    HDLC_FCS_TYPE_16   = 2, //!< The frames carry an FCS-16
+    HDLC_FCS_TYPE_32   = 4  //!< The frames carry an FCS-32
+} E_HDLC_FCS_TYPE;
+
+/*! \struct HdlcFrameInfo
+ *  \brief The result of dissecting a single HDLC frame
+ * 
+ *  The information field refers to the buffer of the dissected frame, which must outlive this object.
+ */
+struct HdlcFrameInfo {
+    E_HDLC_FRAME_TYPE    m_eFrameType;       //!< The class of the frame
+    bool                 m_bFcsValid;        //!< Indicates whether the FCS is valid, always true without FCS
+    bool                 m_bPollFinal;       //!< The poll / final bit
+    uint8_t              m_Address;          //!< The address field
+    uint16_t             m_Control;          //!< The control field, two octets in little endian order if extended
+    uint8_t              m_SendSequence;     //!< N(S) of I-frames
+    uint8_t              m_ReceiveSequence;  //!< N(R) of I-frames and S-frames
+    uint8_t              m_Function;         //!< The supervisory function of S-frames, the modifier bits of U-frames
+    const unsigned char* m_Information;      //!< The information field, nullptr if empty
+    size_t               m_InformationSize;  //!< The number of octets of the information field
+};
+
+/*! \class HdlcFrameDissector
+ *  \brief Class HdlcFrameDissector
+ * 
+ *  Dissects raw HDLC frames as delivered via sessions of type SESSION_TYPE_RX_HDLC: the frames are classified as I-, S-,
+ *  or U-frames, the sequence numbers are extracted, and the FCS is verified. The frames are expected to be unstuffed and
+ *  without the enclosing flags, i.e., address field, control field, information field, and FCS.
+ */
+class HdlcFrameDissector {
+public:
+    /*! \brief  The constructor of HdlcFrameDissector objects
+     * 
+     *  \param  a_eFcsType the type of the FCS trailing each frame
+     *  \param  a_bExtendedControl indicates whether I-frames and S-frames carry a two-octet control field (modulo 128)
+     */
+    explicit HdlcFrameDissector(E_HDLC_FCS_TYPE a_eFcsType = HDLC_FCS_TYPE_16, bool a_bExtendedControl = false):
+        m_eFcsType(a_eFcsType), m_bExtendedControl(a_bExtendedControl) {
+    }
+
+    /*! \brief  Dissect a single HDLC frame
+     * 
+     *  \param  a_Frame the buffer containing the frame
+     *  \param  a_Length the number of octets of the frame
+     *  \param  a_FrameInfo the result of the dissection
+     * 
+     *  \retval true the frame was classified and its FCS is valid
+     *  \retval false the frame is invalid or its FCS is wrong
+     *  \return Indicates whether the frame is valid
+     */
+    bool Dissect(const unsigned char* a_Frame, size_t a_Length, HdlcFrameInfo& a_FrameInfo) const {
+        a_FrameInfo.m_eFrameType      = HDLC_FRAME_TYPE_INVALID;
+        a_FrameInfo.m_bFcsValid       = false;
+        a_FrameInfo.m_bPollFinal      = false;
+        a_FrameInfo.m_Address         = 0;
+        a_FrameInfo.m_Control         = 0;
+        a_FrameInfo.m_SendSequence    = 0;
+        a_FrameInfo.m_ReceiveSequence = 0;
+        a_FrameInfo.m_Function        = 0;
+        a_FrameInfo.m_Information     = nullptr;
+        a_FrameInfo.m_InformationSize = 0;
+        if (a_Length < (size_t(2) + m_eFcsType)) {
+            return false;
+        } // if
+
+        // Verify the FCS via its residue
+        switch (m_eFcsType) {
+        case HDLC_FCS_TYPE_16:
+            a_FrameInfo.m_bFcsValid = HdlcFcs::CheckFcs16(a_Frame, a_Length);
+            break;
+        case HDLC_FCS_TYPE_32:
+            a_FrameInfo.m_bFcsValid = HdlcFcs::CheckFcs32(a_Frame, a_Length);
+            break;
+        default:
+            a_FrameInfo.m_bFcsValid = true;
+            break;
+        } // switch
+
+        // Parse address and control field
+        size_t l_Header = 2;
+        const uint8_t l_Control = a_Frame[1];
+        a_FrameInfo.m_Address = a_Frame[0];
+        a_FrameInfo.m_Control = l_Control;
+        if ((l_Control & 0x01) == 0x00) {
+            a_FrameInfo.m_eFrameType = HDLC_FRAME_TYPE_I;
+        } else if ((l_Control & 0x03) == 0x01) {
+            a_FrameInfo.m_eFrameType = HDLC_FRAME_TYPE_S;
+            a_FrameInfo.m_Function   = ((l_Control >> 2) & 0x03);
+        } else {
+            a_FrameInfo.m_eFrameType = HDLC_FRAME_TYPE_U;
+            a_FrameInfo.m_Function   = (((l_Control >> 2) & 0x03) | ((l_Control >> 3) & 0x1C));
+            a_FrameInfo.m_bPollFinal = ((l_Control & 0x10) != 0);
+        } // else
+
+        if (a_FrameInfo.m_eFrameType != HDLC_FRAME_TYPE_U) {
+            if (m_bExtendedControl) {
+                if (a_Length < (size_t(3) + m_eFcsType)) {
+                    a_FrameInfo.m_eFrameType = HDLC_FRAME_TYPE_INVALID;
+                    return false;
+                } // if
+
+                const uint8_t l_Control2 = a_Frame[2];
+                l_Header = 3;
+                a_FrameInfo.m_Control        |= (uint16_t(l_Control2) << 8);
+                a_FrameInfo.m_bPollFinal      = ((l_Control2 & 0x01) != 0);
+                a_FrameInfo.m_ReceiveSequence = (l_Control2 >> 1);
+                if (a_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_I) {
+                    a_FrameInfo.m_SendSequence = (l_Control >> 1);
+                } // if
+            } else {
+                a_FrameInfo.m_bPollFinal      = ((l_Control & 0x10) != 0);
+                a_FrameInfo.m_ReceiveSequence = (l_Control >> 5);
+                if (a_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_I) {
+                    a_FrameInfo.m_SendSequence = ((l_Control >> 1) & 0x07);
+                } // if
+            } // else
+        } // if
+
+        // The remainder up to the FCS is the information field
+        a_FrameInfo.m_InformationSize = (a_Length - l_Header - m_eFcsType);
+        if (a_FrameInfo.m_InformationSize) {
+            a_FrameInfo.m_Information = (a_Frame + l_Header);
+        } // if
+
+        return a_FrameInfo.m_bFcsValid;
+    }
+
+    /*! \brief  Dissect the HDLC frame contained in a received data packet
+     * 
+     *  \param  a_PacketData the received data packet
+     *  \param  a_FrameInfo the result of the dissection, referring to the payload of the data packet
+     * 
+     *  \return Indicates whether the frame is valid
+     */
+    bool Dissect(const HdlcdPacketData& a_PacketData, HdlcFrameInfo& a_FrameInfo) const {
+        const std::vector<unsigned char>& l_Data = a_PacketData.GetData();
+        return Dissect(l_Data.data(), l_Data.size(), a_FrameInfo);
+    }
+
+    /*! \brief  Dissect a batch of received data packets at once
+     * 
+     *  The results are appended to the provided vector in the order of the data packets, one for each data packet.
+     *  The vector is reused by subsequent calls without reallocation if the caller clears it in between.
+     * 
+     *  \param  a_Packets the received data packets, which must outlive the results
+     *  \param  a_FrameInfos the vector to append the results to
+     * 
+     *  \return The number of valid frames in the batch
+     */
+    size_t DissectBatch(const std::vector<std::shared_ptr<const HdlcdPacketData>>& a_Packets, std::vector<HdlcFrameInfo>& a_FrameInfos) const {
+        size_t l_Valid = 0;
+        size_t l_Offset = a_FrameInfos.size();
+        a_FrameInfos.resize(l_Offset + a_Packets.size());
+        for (size_t l_Index = 0; l_Index < a_Packets.size(); ++l_Index) {
+            if (Dissect(*a_Packets[l_Index], a_FrameInfos[l_Offset + l_Index])) {
+                ++l_Valid;
+            } // if
+        } // for
+
+        return l_Valid;
+    }
+
+private:
+    // Members
+    const E_HDLC_FCS_TYPE m_eFcsType;         //!< The type of the FCS trailing each frame
+    const bool            m_bExtendedControl; //!< Indicates whether I-frames and S-frames carry two control octets
+};
+
+#endif // HDLC_FRAME_DISSECTOR_H
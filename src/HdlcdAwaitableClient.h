@@ -0,0 +1,304 @@
+/**
+ * \file      HdlcdAwaitableClient.h
+ * \brief     This file contains the header declaration of class HdlcdAwaitableClient
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_AWAITABLE_CLIENT_H
+#define HDLCD_AWAITABLE_CLIENT_H
+
+#include <utility> // Some boost versions use std::exchange in awaitable.hpp without including it
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+
+// The awaitable client requires C++20 coroutines, e.g., GCC 10 or newer with -std=c++20
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "HdlcdClient.h"
+
+/*! \class HdlcdAwaitableClient
+ *  \brief Class HdlcdAwaitableClient
+ * 
+ *  A client of the HDLCd access protocol for C++20 coroutines. Connecting, sending, and receiving are awaitable operations.
+ *  Received data packets are buffered in a bounded queue; if it is full, the receiver is stalled until the next call to
+ *  Receive(), thus a slow coroutine throttles the HDLCd instead of accumulating data packets. A loop like
+ *  "while (auto l_PacketData = co_await l_Client.Receive()) { ... }" consumes all data packets until the session is closed.
+ * 
+ *  Only a single coroutine may await Receive() at a time, whereas Send() and SendBatch() may be awaited concurrently.
+ *  All methods must be called from the thread running the io_service.
+ */
+class HdlcdAwaitableClient {
+public:
+    /*! \brief  The constructor of HdlcdAwaitableClient objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_SerialPortName the name of the serial port device
+     *  \param  a_HdlcdSessionDescriptor the indentifier of the session, see "service access point"
+     *  \param  a_ReceiveQueueLimit the number of received data packets to buffer before the receiver is stalled
+     */
+    HdlcdAwaitableClient(boost::asio::io_service& a_IOService, const std::string &a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor, size_t a_ReceiveQueueLimit = 16):
+        m_Client(a_IOService, a_SerialPortName, a_HdlcdSessionDescriptor, *this),
+        m_ReceiveQueueLimit(a_ReceiveQueueLimit),
+        m_bConnectDone(false),
+        m_bConnected(false),
+        m_bClosed(false),
+        m_bReceiverStalled(false),
+        m_bRetryArmed(false),
+        m_ConnectSignal(a_IOService),
+        m_SendSignal(a_IOService),
+        m_ReceiveSignal(a_IOService),
+        m_RetryTimer(a_IOService) {
+        // The signals never expire, cancelling them resumes all waiting coroutines but keeps the expiry time
+        m_ConnectSignal.expires_at(boost::asio::steady_timer::time_point::max());
+        m_SendSignal.expires_at(boost::asio::steady_timer::time_point::max());
+        m_ReceiveSignal.expires_at(boost::asio::steady_timer::time_point::max());
+        m_Client.SetOnSendProgressCallback([this](uint64_t) { m_SendSignal.cancel(); });
+    }
+
+    /*! \brief  Connect both TCP sockets to the HDLCd
+     * 
+     *  \param  a_EndpointIterator the boost endpoint iteratior referring to the destination
+     * 
+     *  \return Indicates whether the session was established
+     */
+    boost::asio::awaitable<bool> Connect(boost::asio::ip::tcp::resolver::iterator a_EndpointIterator) {
+        m_Client.AsyncConnect(a_EndpointIterator, [this](bool a_bSuccess) {
+            m_bConnectDone = true;
+            m_bConnected = a_bSuccess;
+            m_ConnectSignal.cancel();
+        });
+
+        while ((!m_bConnectDone) && (!m_bClosed)) {
+            co_await Wait(m_ConnectSignal);
+        } // while
+
+        co_return (m_bConnected && (!m_bClosed));
+    }
+
+    /*! \brief  Send a single data packet and wait until it was written
+     * 
+     *  If the send queue is full, this method waits for free space instead of failing.
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     * 
+     *  \return Indicates whether the data packet was written, false if the session was closed before
+     */
+    boost::asio::awaitable<bool> Send(const HdlcdPacketData& a_PacketData) {
+        uint64_t l_Sequence = co_await Enqueue(a_PacketData);
+        co_return (co_await WaitForCompletion(l_Sequence));
+    }
+
+    /*! \brief  Send multiple data packets and wait until all of them were written
+     * 
+     *  \param  a_PacketDataBatch the data packets to be transmitted, in order
+     * 
+     *  \return Indicates whether all data packets were written, false if the session was closed before
+     */
+    boost::asio::awaitable<bool> SendBatch(const std::vector<HdlcdPacketData>& a_PacketDataBatch) {
+        uint64_t l_Sequence = 0;
+        for (auto l_PacketData = a_PacketDataBatch.begin(); l_PacketData != a_PacketDataBatch.end(); ++l_PacketData) {
+            l_Sequence = co_await Enqueue(*l_PacketData);
+            if (l_Sequence == 0) {
+                co_return false;
+            } // if
+        } // for
+
+        co_return (co_await WaitForCompletion(l_Sequence));
+    }
+
+    /*! \brief  Wait for the next received data packet
+     * 
+     *  \return The received data packet, or an empty pointer if the session was closed
+     */
+    boost::asio::awaitable<std::shared_ptr<const HdlcdPacketData>> Receive() {
+        while (m_ReceiveQueue.empty() && (!m_bClosed)) {
+            co_await Wait(m_ReceiveSignal);
+        } // while
+
+        std::shared_ptr<const HdlcdPacketData> l_PacketData;
+        if (!m_ReceiveQueue.empty()) {
+            l_PacketData = m_ReceiveQueue.front();
+            m_ReceiveQueue.pop_front();
+            if (m_bReceiverStalled) {
+                // Space is available again
+                m_bReceiverStalled = false;
+                m_Client.TriggerNextDataPacket();
+            } // if
+        } // if
+
+        co_return l_PacketData;
+    }
+
+    /*! \brief  Close the session
+     * 
+     *  All awaiting coroutines are resumed
+     */
+    void Close() {
+        m_Client.Close();
+    }
+
+    /*! \brief  Access the underlying client entity, e.g., to exchange control packets
+     * 
+     *  \return The underlying client entity
+     */
+    HdlcdClientT<HdlcdAwaitableClient>& GetClient() {
+        return m_Client;
+    }
+
+private:
+    // The underlying client entity delivers all packets and events to this object
+    friend class HdlcdClientT<HdlcdAwaitableClient>;
+
+    /*! \brief  Suspend the calling coroutine until a signal is raised
+     * 
+     *  Internal helper: a timer that never expires serves as signal, it is raised by cancelling it. The expiry time is set
+     *  only once by the constructor, as setting it here would cancel the other coroutines waiting for the same signal.
+     * 
+     *  \param  a_Signal the signal to wait for
+     */
+    static boost::asio::awaitable<void> Wait(boost::asio::steady_timer& a_Signal) {
+        boost::system::error_code l_ErrorCode;
+        co_await a_Signal.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, l_ErrorCode));
+    }
+
+    /*! \brief  Enqueue a single data packet, waiting for free space in the send queue if required
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     * 
+     *  \return The sequence number of the enqueued data packet, or 0 if the session was closed
+     */
+    boost::asio::awaitable<uint64_t> Enqueue(const HdlcdPacketData& a_PacketData) {
+        while (m_bConnected && (!m_bClosed)) {
+            uint64_t l_Sequence = m_Client.SendSequenced(a_PacketData);
+            if (l_Sequence) {
+                co_return l_Sequence;
+            } // if
+
+            // The send queue is full, wait for progress. The queue may be filled by data packets sent via GetClient().Send(),
+            // which do not raise the signal, thus it is raised after a bounded time as well.
+            ArmRetryTimer();
+            co_await Wait(m_SendSignal);
+        } // while
+
+        co_return 0;
+    }
+
+    /*! \brief  Raise the send signal after a short while, to retry to enqueue a data packet
+     */
+    void ArmRetryTimer() {
+        if (m_bRetryArmed) {
+            return;
+        } // if
+
+        m_bRetryArmed = true;
+        m_RetryTimer.expires_from_now(std::chrono::milliseconds(10));
+        m_RetryTimer.async_wait([this](const boost::system::error_code& a_ErrorCode) {
+            if (a_ErrorCode == boost::asio::error::operation_aborted) {
+                // Only cancelled by the destructor
+                return;
+            } // if
+
+            m_bRetryArmed = false;
+            m_SendSignal.cancel();
+        }); // async_wait
+    }
+
+    /*! \brief  Wait until the data packet with the specified sequence number was written
+     * 
+     *  \param  a_Sequence the sequence number of the data packet
+     * 
+     *  \return Indicates whether the data packet was written, false if the session was closed before
+     */
+    boost::asio::awaitable<bool> WaitForCompletion(uint64_t a_Sequence) {
+        if (a_Sequence == 0) {
+            co_return false;
+        } // if
+
+        while ((m_Client.GetCompletedSequence() < a_Sequence) && (!m_bClosed)) {
+            co_await Wait(m_SendSignal);
+        } // while
+
+        co_return (m_Client.GetCompletedSequence() >= a_Sequence);
+    }
+
+    bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+        m_ReceiveQueue.emplace_back(a_PacketData);
+        m_ReceiveSignal.cancel();
+        if (m_ReceiveQueue.size() >= m_ReceiveQueueLimit) {
+            // Stall the receiver until the consumer catches up
+            m_bReceiverStalled = true;
+            return false;
+        } // if
+
+        return true;
+    }
+
+    void HandleCtrl(const HdlcdPacketCtrl&) {
+    }
+
+    void HandleClosed() {
+        m_bClosed = true;
+        m_bConnected = false;
+        m_ConnectSignal.cancel();
+        m_SendSignal.cancel();
+        m_ReceiveSignal.cancel();
+    }
+
+    // Members
+    HdlcdClientT<HdlcdAwaitableClient> m_Client; //!< The underlying client entity
+    std::deque<std::shared_ptr<const HdlcdPacketData>> m_ReceiveQueue; //!< The received data packets not yet consumed
+    size_t m_ReceiveQueueLimit;                  //!< The number of received data packets to buffer before the receiver is stalled
+    bool m_bConnectDone;                         //!< Indicates whether the result of the connect procedure is available
+    bool m_bConnected;                           //!< Indicates whether the session was established
+    bool m_bClosed;                              //!< Indicates whether the session was closed
+    bool m_bReceiverStalled;                     //!< Indicates whether the receiver is stalled due to a full receive queue
+    bool m_bRetryArmed;                          //!< Indicates whether the retry timer is armed
+    boost::asio::steady_timer m_ConnectSignal;   //!< Raised if the result of the connect procedure is available
+    boost::asio::steady_timer m_SendSignal;      //!< Raised on progress of transmission and on close
+    boost::asio::steady_timer m_ReceiveSignal;   //!< Raised on reception of a data packet and on close
+    boost::asio::steady_timer m_RetryTimer;      //!< Raises the send signal while waiting for free space in the send queue
+};
+
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
+#endif // HDLCD_AWAITABLE_CLIENT_H
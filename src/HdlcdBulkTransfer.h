@@ -0,0 +1,297 @@
+/**
+ * \file      HdlcdBulkTransfer.h
+ * \brief     This file contains the header declaration of class template HdlcdBulkTransfer
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_BULK_TRANSFER_H
+#define HDLCD_BULK_TRANSFER_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include "HdlcdPacketData.h"
+
+/*! \class HdlcdBulkTransfer
+ *  \brief Class template HdlcdBulkTransfer
+ * 
+ *  Sends a large payload, e.g., a firmware image, as a stream of data packets of at most MTU octets each. A window of data
+ *  packets is kept in flight, thus the data socket and the serial line never run dry while waiting for the application,
+ *  and the application is only involved once per transfer and per progress interval.
+ *  
+ *  The sink is typically an HdlcdClient and has to provide "bool Send(const HdlcdPacketData&, std::function<void()>)"
+ *  which invokes the callback after the data packet was sent. If the session is closed, data packets in flight are never
+ *  reported as sent, thus the owner has to call Cancel() on close of the session to report the transfer as failed. A sink
+ *  refusing a data packet but invoking its callback nonetheless, as HdlcdClient does without a session, dropped it, and
+ *  the transfer fails.
+ */
+template <class TSink>
+class HdlcdBulkTransfer {
+public:
+    /*! \brief  The constructor of HdlcdBulkTransfer objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_Sink the sink the data packets are sent to
+     */
+    HdlcdBulkTransfer(boost::asio::io_service& a_IOService, TSink& a_Sink): m_Sink(a_Sink), m_Timer(a_IOService), m_Mtu(256), m_Window(16),
+        m_bReliable(true), m_ProgressInterval(65536), m_Generation(0), m_Offset(0), m_BytesSent(0), m_NextProgress(0), m_InFlight(0),
+        m_bRunning(false), m_bTimerArmed(false) {
+    }
+
+    /*! \brief  The destructor of HdlcdBulkTransfer objects
+     * 
+     *  Must not be destroyed while data packets are in flight, i.e., before the completion callback or the close of the sink
+     */
+    ~HdlcdBulkTransfer() {
+        m_bRunning = false;
+        m_Timer.cancel();
+    }
+
+    /*! \brief  Configure the segmentation, must be called before Start()
+     * 
+     *  \param  a_Mtu the maximum number of payload octets per data packet
+     *  \param  a_Window the maximum number of data packets handed to the sink but not sent yet
+     *  \param  a_bReliable the reliable flag of the data packets, i.e., whether they are sent via I-frames
+     */
+    void Configure(size_t a_Mtu, size_t a_Window = 16, bool a_bReliable = true) {
+        m_Mtu       = (a_Mtu ? a_Mtu : 1);
+        m_Window    = (a_Window ? a_Window : 1);
+        m_bReliable = a_bReliable;
+    }
+
+    /*! \brief  Provide a callback method to report the progress of transfers
+     * 
+     *  \param  a_OnProgressCallback the method to be called with the number of octets sent and the total number of octets
+     *  \param  a_ProgressInterval the minimum number of octets sent between two calls of the callback
+     */
+    void SetOnProgressCallback(std::function<void(size_t a_BytesSent, size_t a_BytesTotal)> a_OnProgressCallback, size_t a_ProgressInterval = 65536) {
+        m_OnProgressCallback = a_OnProgressCallback;
+        m_ProgressInterval = (a_ProgressInterval ? a_ProgressInterval : 1);
+    }
+
+    /*! \brief  Start the transfer of a payload
+     * 
+     *  \param  a_Payload the payload to send, segmented into data packets of at most MTU octets
+     *  \param  a_OnDoneCallback the method to be called after the last data packet was sent or the transfer was cancelled
+     * 
+     *  \retval true the transfer was started
+     *  \retval false another transfer is still running
+     *  \return Indicates whether the transfer was started
+     */
+    bool Start(std::vector<unsigned char> a_Payload, std::function<void(bool a_bSuccess)> a_OnDoneCallback) {
+        if (m_bRunning) {
+            return false;
+        } // if
+
+        m_Payload = std::move(a_Payload);
+        m_OnDoneCallback = a_OnDoneCallback;
+        ++m_Generation; // Completions and timer expiries of cancelled transfers are ignored
+        m_bTimerArmed = false;
+        m_Offset = 0;
+        m_BytesSent = 0;
+        m_NextProgress = m_ProgressInterval;
+        m_InFlight = 0;
+        m_bRunning = true;
+        Pump();
+        return true;
+    }
+
+    /*! \brief  Start the transfer of the contents of a file
+     * 
+     *  \param  a_FileName the name of the file to send
+     *  \param  a_OnDoneCallback the method to be called after the last data packet was sent or the transfer was cancelled
+     * 
+     *  \retval true the transfer was started
+     *  \retval false the file could not be read or another transfer is still running
+     *  \return Indicates whether the transfer was started
+     */
+    bool StartFile(const std::string& a_FileName, std::function<void(bool a_bSuccess)> a_OnDoneCallback) {
+        if (m_bRunning) {
+            return false;
+        } // if
+
+        std::ifstream l_File(a_FileName.c_str(), std::ios::binary);
+        if (!l_File) {
+            return false;
+        } // if
+
+        std::vector<unsigned char> l_Payload((std::istreambuf_iterator<char>(l_File)), std::istreambuf_iterator<char>());
+        if (l_File.bad()) {
+            return false;
+        } // if
+
+        return Start(std::move(l_Payload), a_OnDoneCallback);
+    }
+
+    /*! \brief  Abort the running transfer and report it as failed, data packets already handed to the sink are not revoked
+     */
+    void Cancel() {
+        if (m_bRunning) {
+            m_bRunning = false;
+            m_Timer.cancel();
+            m_bTimerArmed = false;
+            ++m_Generation;
+            std::function<void(bool a_bSuccess)> l_OnDoneCallback;
+            l_OnDoneCallback.swap(m_OnDoneCallback);
+            if (l_OnDoneCallback) {
+                l_OnDoneCallback(false);
+            } // if
+        } // if
+    }
+
+    bool   IsRunning() const { return m_bRunning; }           //!< Indicates whether a transfer is running
+    size_t GetBytesSent() const { return m_BytesSent; }        //!< The number of octets of the current transfer that were sent
+    size_t GetBytesTotal() const { return m_Payload.size(); } //!< The number of octets of the current transfer
+
+private:
+    /*! \brief  Hand data packets to the sink as long as the window permits
+     */
+    void Pump() {
+        while ((m_bRunning) && (m_Offset < m_Payload.size()) && (m_InFlight < m_Window)) {
+            const size_t l_Length = std::min(m_Mtu, (m_Payload.size() - m_Offset));
+            std::vector<unsigned char> l_Segment(m_Payload.begin() + m_Offset, m_Payload.begin() + m_Offset + l_Length);
+            const uint64_t l_Generation = m_Generation;
+            auto l_bAccepted = std::make_shared<bool>(false);
+            if (!m_Sink.Send(HdlcdPacketData::CreatePacket(std::move(l_Segment), m_bReliable), [this, l_Generation, l_Length, l_bAccepted]() {
+                    OnSendDone(l_Generation, l_Length, *l_bAccepted);
+                })) {
+                if (!m_InFlight) {
+                    // The queue is full without pending completions: retry later
+                    ArmTimer();
+                } // if
+
+                return;
+            } // if
+
+            *l_bAccepted = true;
+            ++m_InFlight;
+            m_Offset += l_Length;
+        } // while
+
+        CheckDone();
+    }
+
+    /*! \brief  Retry to hand data packets to the sink later
+     */
+    void ArmTimer() {
+        if (m_bTimerArmed) {
+            return;
+        } // if
+
+        m_bTimerArmed = true;
+        const uint64_t l_Generation = m_Generation;
+        m_Timer.expires_from_now(std::chrono::milliseconds(10));
+        m_Timer.async_wait([this, l_Generation](const boost::system::error_code& a_ErrorCode) {
+            if (l_Generation != m_Generation) {
+                // Armed by a cancelled transfer, the current one may have armed the timer again
+                return;
+            } // if
+
+            m_bTimerArmed = false;
+            if (!a_ErrorCode) {
+                Pump();
+            } // if
+        }); // async_wait
+    }
+
+    /*! \brief  A data packet was sent by the sink
+     * 
+     *  \param  a_Generation the transfer the data packet belongs to
+     *  \param  a_Length the number of payload octets of the data packet
+     *  \param  a_bAccepted indicates whether the sink accepted the data packet, i.e., whether it is accounted as in flight
+     */
+    void OnSendDone(uint64_t a_Generation, size_t a_Length, bool a_bAccepted) {
+        if ((!m_bRunning) || (a_Generation != m_Generation)) {
+            return;
+        } // if
+
+        if (!a_bAccepted) {
+            // The sink refused and dropped the data packet, e.g., it has no session
+            Cancel();
+            return;
+        } // if
+
+        --m_InFlight;
+        m_BytesSent += a_Length;
+        if ((m_OnProgressCallback) && ((m_BytesSent >= m_NextProgress) || (m_BytesSent == m_Payload.size()))) {
+            m_NextProgress = (m_BytesSent + m_ProgressInterval);
+            m_OnProgressCallback(m_BytesSent, m_Payload.size());
+        } // if
+
+        Pump();
+    }
+
+    /*! \brief  Report the end of the transfer after all data packets were sent
+     */
+    void CheckDone() {
+        if ((m_bRunning) && (m_Offset == m_Payload.size()) && (!m_InFlight)) {
+            m_bRunning = false;
+            std::function<void(bool a_bSuccess)> l_OnDoneCallback;
+            l_OnDoneCallback.swap(m_OnDoneCallback);
+            if (l_OnDoneCallback) {
+                l_OnDoneCallback(true);
+            } // if
+        } // if
+    }
+
+    // Members
+    TSink& m_Sink;
+    boost::asio::steady_timer m_Timer; //!< The timer to retry if the sink is not able to take data packets
+    size_t   m_Mtu;              //!< The maximum number of payload octets per data packet
+    size_t   m_Window;           //!< The maximum number of pending send operations
+    bool     m_bReliable;        //!< The reliable flag of all data packets
+    size_t   m_ProgressInterval; //!< The minimum number of octets between two progress reports
+    uint64_t m_Generation;       //!< Identifies the current transfer to ignore completions and timer expiries of cancelled ones
+    std::vector<unsigned char> m_Payload; //!< The payload of the current transfer
+    size_t   m_Offset;           //!< The number of octets handed to the sink
+    size_t   m_BytesSent;        //!< The number of octets reported as sent by the sink
+    size_t   m_NextProgress;     //!< The number of sent octets to report the progress at next
+    size_t   m_InFlight;         //!< The number of pending send operations
+    bool     m_bRunning;
+    bool     m_bTimerArmed;
+    std::function<void(bool a_bSuccess)> m_OnDoneCallback;
+    std::function<void(size_t a_BytesSent, size_t a_BytesTotal)> m_OnProgressCallback;
+};
+
+#endif // HDLCD_BULK_TRANSFER_H
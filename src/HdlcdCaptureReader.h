@@ -0,0 +1,344 @@
+/**
+ * \file      HdlcdCaptureReader.h
+ * \brief     This file contains the header declaration of class HdlcdCaptureReader
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_CAPTURE_READER_H
+#define HDLCD_CAPTURE_READER_H
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "HdlcdPacketData.h"
+
+/*! \struct HdlcdCaptureRecord
+ *  \brief A data packet read from a capture file
+ * 
+ *  The payload refers to the memory-mapped capture file and stays valid as long as the file is open.
+ */
+struct HdlcdCaptureRecord {
+    uint64_t             m_Timestamp;  //!< The timestamp in nanoseconds since the epoch
+    uint16_t             m_LinkType;   //!< The link type of the interface the data packet was recorded on
+    const unsigned char* m_Data;       //!< The payload inside the mapped capture file
+    size_t               m_Length;     //!< The number of octets of the payload
+    bool                 m_bWasSent;   //!< The data packet was sent, derived from the direction flags
+    bool                 m_bInvalid;   //!< The data packet was invalid, derived from the CRC error flag
+    bool                 m_bReliable;  //!< The data packet was reliable, derived from the comment "reliable"
+
+    /*! \brief  Create a data packet carrying a copy of the payload and the flags of this record
+     * 
+     *  \return The data packet
+     */
+    HdlcdPacketData CreatePacket() const {
+        return HdlcdPacketData::CreatePacket(std::vector<unsigned char>(m_Data, m_Data + m_Length), m_bReliable, m_bInvalid, m_bWasSent);
+    }
+};
+
+/*! \class HdlcdCaptureReader
+ *  \brief Class HdlcdCaptureReader
+ * 
+ *  Reads data packets from pcapng files, e.g., as written by HdlcdCaptureWriter. The file is mapped into memory and each
+ *  record refers to the payload inside the mapping, thus reading a record does not copy anything. Only enhanced packet
+ *  blocks are returned, all other blocks are skipped. Files in foreign byte order are not supported.
+ */
+class HdlcdCaptureReader {
+public:
+    /*! \brief  The constructor of HdlcdCaptureReader objects
+     */
+    HdlcdCaptureReader(): m_Begin(nullptr), m_End(nullptr), m_Position(nullptr) {
+    }
+
+    /*! \brief  Map a capture file into memory
+     * 
+     *  \param  a_FileName the name of the capture file
+     * 
+     *  \retval true the capture file was mapped and starts with a section header block in host byte order
+     *  \retval false the capture file could not be mapped or is not a pcapng file in host byte order
+     *  \return Indicates whether the capture file was opened
+     */
+    bool Open(const std::string& a_FileName) {
+        Close();
+        try {
+            boost::interprocess::file_mapping l_FileMapping(a_FileName.c_str(), boost::interprocess::read_only);
+            boost::interprocess::mapped_region l_Region(l_FileMapping, boost::interprocess::read_only);
+            m_Region.swap(l_Region);
+        } catch (const boost::interprocess::interprocess_exception&) {
+            return false;
+        } // catch
+
+        m_Begin = static_cast<const unsigned char*>(m_Region.get_address());
+        m_End   = (m_Begin + m_Region.get_size());
+        if (((m_End - m_Begin) < 28) || (ReadUint32(m_Begin) != 0x0A0D0D0A) || (ReadUint32(m_Begin + 8) != 0x1A2B3C4D)) {
+            Close();
+            return false;
+        } // if
+
+        m_Position = m_Begin;
+        return true;
+    }
+
+    /*! \brief  Unmap the capture file, all records referring to it become invalid
+     */
+    void Close() {
+        boost::interprocess::mapped_region().swap(m_Region);
+        m_Begin = m_End = m_Position = nullptr;
+        m_Interfaces.clear();
+    }
+
+    /*! \brief  Query whether a capture file is open
+     * 
+     *  \return Indicates whether a capture file is open
+     */
+    bool IsOpen() const {
+        return (m_Begin != nullptr);
+    }
+
+    /*! \brief  Restart reading at the beginning of the capture file
+     */
+    void Rewind() {
+        m_Position = m_Begin;
+        m_Interfaces.clear();
+    }
+
+    /*! \brief  Read the next data packet
+     * 
+     *  \param  a_Record the record to fill
+     * 
+     *  \retval true the next data packet was read
+     *  \retval false the end of the capture file was reached or the file is truncated or corrupt
+     *  \return Indicates whether a data packet was read
+     */
+    bool Next(HdlcdCaptureRecord& a_Record) {
+        while ((m_Position) && ((m_End - m_Position) >= 12)) {
+            const unsigned char* l_Block = m_Position;
+            const uint32_t l_BlockType = ReadUint32(l_Block);
+            const uint32_t l_BlockSize = ReadUint32(l_Block + 4);
+            if ((l_BlockSize < 12) || (l_BlockSize & 0x03) || (l_BlockSize > size_t(m_End - l_Block))) {
+                // Corrupt or truncated, stop here
+                m_Position = m_End;
+                return false;
+            } // if
+
+            m_Position += l_BlockSize;
+            const unsigned char* l_BlockEnd = (l_Block + l_BlockSize - 4);
+            switch (l_BlockType) {
+            case 0x0A0D0D0A:
+                // Section header block: interface IDs start over
+                m_Interfaces.clear();
+                if ((l_BlockSize < 28) || (ReadUint32(l_Block + 8) != 0x1A2B3C4D)) {
+                    m_Position = m_End;
+                    return false;
+                } // if
+
+                break;
+            case 0x00000001:
+                if (l_BlockSize >= 20) {
+                    ParseInterfaceDescriptionBlock(l_Block + 16, l_BlockEnd, ReadUint16(l_Block + 8));
+                } // if
+
+                break;
+            case 0x00000006:
+                if ((l_BlockSize >= 32) && (ParseEnhancedPacketBlock(l_Block, l_BlockEnd, a_Record))) {
+                    return true;
+                } // if
+
+                break;
+            default:
+                break;
+            } // switch
+        } // while
+
+        return false;
+    }
+
+private:
+    /*! \struct Interface
+     *  \brief The properties of an interface relevant to decode enhanced packet blocks
+     */
+    struct Interface {
+        uint16_t m_LinkType;            //!< The link type
+        uint8_t  m_TimestampResolution; //!< The raw value of if_tsresol
+    };
+
+    /*! \brief  Read a 16 bit value in host byte order
+     * 
+     *  \param  a_Buffer the buffer to read from
+     * 
+     *  \return The value
+     */
+    static uint16_t ReadUint16(const unsigned char* a_Buffer) {
+        uint16_t l_Value;
+        memcpy(&l_Value, a_Buffer, sizeof(l_Value));
+        return l_Value;
+    }
+
+    /*! \brief  Read a 32 bit value in host byte order
+     * 
+     *  \param  a_Buffer the buffer to read from
+     * 
+     *  \return The value
+     */
+    static uint32_t ReadUint32(const unsigned char* a_Buffer) {
+        uint32_t l_Value;
+        memcpy(&l_Value, a_Buffer, sizeof(l_Value));
+        return l_Value;
+    }
+
+    /*! \brief  Store the properties of an interface description block
+     * 
+     *  \param  a_Options the first option of the block
+     *  \param  a_OptionsEnd the end of the options
+     *  \param  a_LinkType the link type of the interface
+     */
+    void ParseInterfaceDescriptionBlock(const unsigned char* a_Options, const unsigned char* a_OptionsEnd, uint16_t a_LinkType) {
+        Interface l_Interface;
+        l_Interface.m_LinkType = a_LinkType;
+        l_Interface.m_TimestampResolution = 6; // Microseconds, the default
+        while ((a_OptionsEnd - a_Options) >= 4) {
+            const uint16_t l_Code   = ReadUint16(a_Options);
+            const uint16_t l_Length = ReadUint16(a_Options + 2);
+            if ((l_Code == 0) || (size_t(l_Length) > size_t(a_OptionsEnd - a_Options - 4))) {
+                break;
+            } // if
+
+            if ((l_Code == 9) && (l_Length == 1)) {
+                l_Interface.m_TimestampResolution = a_Options[4];
+            } // if
+
+            a_Options += (4 + ((l_Length + 3) & ~3));
+        } // while
+
+        m_Interfaces.push_back(l_Interface);
+    }
+
+    /*! \brief  Decode an enhanced packet block
+     * 
+     *  \param  a_Block the start of the block
+     *  \param  a_BlockEnd the end of the options of the block
+     *  \param  a_Record the record to fill
+     * 
+     *  \return Indicates whether the block was decoded
+     */
+    bool ParseEnhancedPacketBlock(const unsigned char* a_Block, const unsigned char* a_BlockEnd, HdlcdCaptureRecord& a_Record) const {
+        const uint32_t l_InterfaceId = ReadUint32(a_Block + 8);
+        const uint32_t l_CapturedLength = ReadUint32(a_Block + 20);
+        const unsigned char* l_Options = (a_Block + 28 + ((size_t(l_CapturedLength) + 3) & ~size_t(3)));
+        if ((l_InterfaceId >= m_Interfaces.size()) || (size_t(l_CapturedLength) > size_t(a_BlockEnd - a_Block - 28)) || (l_Options > a_BlockEnd)) {
+            return false;
+        } // if
+
+        const Interface& l_Interface = m_Interfaces[l_InterfaceId];
+        const uint64_t l_Ticks = ((uint64_t(ReadUint32(a_Block + 12)) << 32) | ReadUint32(a_Block + 16));
+        a_Record.m_Timestamp = ToNanoseconds(l_Ticks, l_Interface.m_TimestampResolution);
+        a_Record.m_LinkType  = l_Interface.m_LinkType;
+        a_Record.m_Data      = (a_Block + 28);
+        a_Record.m_Length    = l_CapturedLength;
+        a_Record.m_bWasSent  = false;
+        a_Record.m_bInvalid  = false;
+        a_Record.m_bReliable = false;
+        while ((a_BlockEnd - l_Options) >= 4) {
+            const uint16_t l_Code   = ReadUint16(l_Options);
+            const uint16_t l_Length = ReadUint16(l_Options + 2);
+            if ((l_Code == 0) || (size_t(l_Length) > size_t(a_BlockEnd - l_Options - 4))) {
+                break;
+            } // if
+
+            if ((l_Code == 2) && (l_Length == 4)) {
+                // epb_flags: direction and link-layer errors
+                const uint32_t l_Flags = ReadUint32(l_Options + 4);
+                a_Record.m_bWasSent = ((l_Flags & 0x03) == 0x02);
+                a_Record.m_bInvalid = ((l_Flags & 0x01000000) != 0);
+            } else if ((l_Code == 1) && (l_Length == 8) && (memcmp(l_Options + 4, "reliable", 8) == 0)) {
+                a_Record.m_bReliable = true;
+            } // else if
+
+            l_Options += (4 + ((l_Length + 3) & ~3));
+        } // while
+
+        return true;
+    }
+
+    /*! \brief  Convert a timestamp to nanoseconds
+     * 
+     *  \param  a_Ticks the timestamp in units of the interface
+     *  \param  a_Resolution the raw value of if_tsresol
+     * 
+     *  \return The timestamp in nanoseconds
+     */
+    static uint64_t ToNanoseconds(uint64_t a_Ticks, uint8_t a_Resolution) {
+        if (a_Resolution & 0x80) {
+            // Negative power of two
+            const unsigned int l_Shift = (a_Resolution & 0x7F);
+            if (l_Shift >= 64) {
+                return 0;
+            } // if
+
+            // Keep at most 32 bits of the fraction to avoid overflows, finer than a nanosecond anyway
+            uint64_t l_Fraction = (a_Ticks & ((uint64_t(1) << l_Shift) - 1));
+            unsigned int l_FractionBits = l_Shift;
+            if (l_FractionBits > 32) {
+                l_Fraction >>= (l_FractionBits - 32);
+                l_FractionBits = 32;
+            } // if
+
+            return (((a_Ticks >> l_Shift) * 1000000000) + ((l_Fraction * 1000000000) >> l_FractionBits));
+        } // if
+
+        uint64_t l_Timestamp = a_Ticks;
+        for (uint8_t l_Power = a_Resolution; l_Power < 9; ++l_Power) {
+            l_Timestamp *= 10;
+        } // for
+
+        for (uint8_t l_Power = 9; l_Power < a_Resolution; ++l_Power) {
+            l_Timestamp /= 10;
+        } // for
+
+        return l_Timestamp;
+    }
+
+    // Members
+    boost::interprocess::mapped_region m_Region; //!< The mapping of the capture file
+    const unsigned char*   m_Begin;      //!< The start of the mapping, nullptr if closed
+    const unsigned char*   m_End;        //!< The end of the mapping
+    const unsigned char*   m_Position;   //!< The next block to read
+    std::vector<Interface> m_Interfaces; //!< The interfaces of the current section
+};
+
+#endif // HDLCD_CAPTURE_READER_H
@@ -0,0 +1,285 @@
+/**
+ * \file      HdlcdCaptureReplayer.h
+ * \brief     This file contains the header declaration of class HdlcdCaptureReplayer
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_CAPTURE_REPLAYER_H
+#define HDLCD_CAPTURE_REPLAYER_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include "HdlcdCaptureReader.h"
+
+/*! \class HdlcdCaptureReplayer
+ *  \brief Class HdlcdCaptureReplayer
+ * 
+ *  Streams the data packets of a capture file into a sink, e.g., an HdlcdClient towards an HDLC daemon or an
+ *  HdlcdPacketEndpoint of a mock daemon towards a client. The sink has to provide the method
+ *  "bool Send(const HdlcdPacketData&, std::function<void()>)" which invokes the callback after the data packet was sent.
+ *  Callbacks of refused data packets, as invoked by HdlcdClient without a session, are ignored, and the data packet is
+ *  retried later.
+ *  
+ *  The data packets are either replayed with their original timing, with the timing scaled by a speed factor, or as fast
+ *  as possible. In all modes, the number of data packets handed to the sink but not sent yet is limited by a window, thus
+ *  the replay is throttled by the transport if it cannot keep up. The replayer must outlive all pending send operations.
+ */
+template <class TSink>
+class HdlcdCaptureReplayer {
+public:
+    /*! \enum E_REPLAY_MODE
+     *  \brief The pace at which data packets are replayed
+     */
+    typedef enum {
+        REPLAY_MODE_ORIGINAL_TIMING     = 0, //!< Keep the time between data packets as recorded
+        REPLAY_MODE_SCALED              = 1, //!< Divide the time between data packets by the speed factor
+        REPLAY_MODE_AS_FAST_AS_POSSIBLE = 2  //!< Ignore the timestamps
+    } E_REPLAY_MODE;
+
+    /*! \enum E_REPLAY_FILTER
+     *  \brief The directions of the data packets to replay
+     */
+    typedef enum {
+        REPLAY_FILTER_ALL      = 0, //!< Replay all data packets
+        REPLAY_FILTER_RECEIVED = 1, //!< Replay received data packets only
+        REPLAY_FILTER_SENT     = 2  //!< Replay sent data packets only
+    } E_REPLAY_FILTER;
+
+    /*! \brief  The constructor of HdlcdCaptureReplayer objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_CaptureReader the opened capture file
+     *  \param  a_Sink the sink the data packets are sent to
+     */
+    HdlcdCaptureReplayer(boost::asio::io_service& a_IOService, HdlcdCaptureReader& a_CaptureReader, TSink& a_Sink): m_CaptureReader(a_CaptureReader),
+        m_Sink(a_Sink), m_Timer(a_IOService), m_eReplayMode(REPLAY_MODE_AS_FAST_AS_POSSIBLE), m_eReplayFilter(REPLAY_FILTER_ALL), m_Speed(1.0),
+        m_Window(64), m_InFlight(0), m_ReplayedPackets(0), m_bRunning(false), m_bHasNext(false), m_bTimerArmed(false), m_Generation(0), m_FirstTimestamp(0) {
+    }
+
+    /*! \brief  The destructor of HdlcdCaptureReplayer objects
+     */
+    ~HdlcdCaptureReplayer() {
+        Stop();
+    }
+
+    /*! \brief  Provide a callback method to be called after the last data packet was sent
+     * 
+     *  \param  a_OnDoneCallback the method to be called after the replay completed
+     */
+    void SetOnDoneCallback(std::function<void()> a_OnDoneCallback) {
+        m_OnDoneCallback = a_OnDoneCallback;
+    }
+
+    /*! \brief  Start replaying from the beginning of the capture file
+     * 
+     *  \param  a_eReplayMode the pace at which data packets are replayed
+     *  \param  a_Speed the speed factor for REPLAY_MODE_SCALED, e.g., 2.0 for double speed
+     *  \param  a_eReplayFilter the directions of the data packets to replay
+     *  \param  a_Window the maximum number of data packets handed to the sink but not sent yet
+     */
+    void Start(E_REPLAY_MODE a_eReplayMode = REPLAY_MODE_ORIGINAL_TIMING, double a_Speed = 1.0, E_REPLAY_FILTER a_eReplayFilter = REPLAY_FILTER_ALL,
+               size_t a_Window = 64) {
+        Stop();
+        m_eReplayMode   = a_eReplayMode;
+        m_eReplayFilter = a_eReplayFilter;
+        m_Speed         = (((a_eReplayMode == REPLAY_MODE_SCALED) && (a_Speed > 0.0)) ? a_Speed : 1.0);
+        m_Window        = (a_Window ? a_Window : 1);
+        m_ReplayedPackets = 0;
+        m_bRunning = true;
+        m_CaptureReader.Rewind();
+        m_bHasNext = ReadNext();
+        if (m_bHasNext) {
+            m_FirstTimestamp = m_Next.m_Timestamp;
+            m_StartTime = std::chrono::steady_clock::now();
+        } // if
+
+        Pump();
+    }
+
+    /*! \brief  Stop replaying, data packets already handed to the sink are not revoked
+     */
+    void Stop() {
+        m_bRunning = false;
+        m_bHasNext = false;
+        ++m_Generation; // Timer expiries of stopped replays are ignored
+        if (m_bTimerArmed) {
+            m_bTimerArmed = false;
+            m_Timer.cancel();
+        } // if
+    }
+
+    /*! \brief  Query the number of data packets that were handed to the sink
+     * 
+     *  \return The number of replayed data packets
+     */
+    uint64_t GetReplayedPackets() const {
+        return m_ReplayedPackets;
+    }
+
+    /*! \brief  Query whether the replay is still running
+     * 
+     *  \return Indicates whether data packets are still to be replayed or pending
+     */
+    bool IsRunning() const {
+        return m_bRunning;
+    }
+
+private:
+    /*! \brief  Read the next data packet matching the filter
+     * 
+     *  \return Indicates whether a data packet was read
+     */
+    bool ReadNext() {
+        while (m_CaptureReader.Next(m_Next)) {
+            if ((m_eReplayFilter == REPLAY_FILTER_ALL) || ((m_eReplayFilter == REPLAY_FILTER_SENT) == m_Next.m_bWasSent)) {
+                return true;
+            } // if
+        } // while
+
+        return false;
+    }
+
+    /*! \brief  Hand all due data packets to the sink as long as the window permits
+     */
+    void Pump() {
+        while ((m_bRunning) && (m_bHasNext) && (m_InFlight < m_Window)) {
+            if (m_eReplayMode != REPLAY_MODE_AS_FAST_AS_POSSIBLE) {
+                std::chrono::steady_clock::time_point l_Due = (m_StartTime + std::chrono::nanoseconds(int64_t(
+                    (m_Next.m_Timestamp > m_FirstTimestamp ? (m_Next.m_Timestamp - m_FirstTimestamp) : 0) / m_Speed)));
+                if (l_Due > std::chrono::steady_clock::now()) {
+                    ArmTimer(l_Due);
+                    return;
+                } // if
+            } // if
+
+            auto l_bAccepted = std::make_shared<bool>(false);
+            if (!m_Sink.Send(m_Next.CreatePacket(), [this, l_bAccepted]() { OnSendDone(*l_bAccepted); })) {
+                if (!m_InFlight) {
+                    // Not connected or the queue is full without pending completions: retry later
+                    ArmTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+                } // if
+
+                return;
+            } // if
+
+            *l_bAccepted = true;
+            ++m_InFlight;
+            ++m_ReplayedPackets;
+            m_bHasNext = ReadNext();
+        } // while
+
+        CheckDone();
+    }
+
+    /*! \brief  Wake up at a specific point in time to continue replaying
+     * 
+     *  \param  a_Due the point in time to continue
+     */
+    void ArmTimer(std::chrono::steady_clock::time_point a_Due) {
+        if (m_bTimerArmed) {
+            return;
+        } // if
+
+        m_bTimerArmed = true;
+        const uint64_t l_Generation = m_Generation;
+        m_Timer.expires_at(a_Due);
+        m_Timer.async_wait([this, l_Generation](const boost::system::error_code& a_ErrorCode) {
+            if (l_Generation != m_Generation) {
+                // Armed by a stopped replay, the current one may have armed the timer again
+                return;
+            } // if
+
+            m_bTimerArmed = false;
+            if (!a_ErrorCode) {
+                Pump();
+            } // if
+        }); // async_wait
+    }
+
+    /*! \brief  A data packet was sent by the sink
+     * 
+     *  \param  a_bAccepted indicates whether the sink accepted the data packet, i.e., whether it is accounted as in flight
+     */
+    void OnSendDone(bool a_bAccepted) {
+        if (!a_bAccepted) {
+            // Refused, thus not in flight: the retry timer takes care of it
+            return;
+        } // if
+
+        if (m_InFlight) {
+            --m_InFlight;
+        } // if
+
+        if (m_bRunning) {
+            Pump();
+        } // if
+    }
+
+    /*! \brief  Report the end of the replay after all data packets were sent
+     */
+    void CheckDone() {
+        if ((m_bRunning) && (!m_bHasNext) && (!m_InFlight)) {
+            m_bRunning = false;
+            if (m_OnDoneCallback) {
+                m_OnDoneCallback();
+            } // if
+        } // if
+    }
+
+    // Members
+    HdlcdCaptureReader& m_CaptureReader;
+    TSink& m_Sink;
+    boost::asio::steady_timer m_Timer; //!< The timer to wait for due data packets or to retry
+    E_REPLAY_MODE   m_eReplayMode;
+    E_REPLAY_FILTER m_eReplayFilter;
+    double   m_Speed;           //!< The speed factor applied to the recorded timing
+    size_t   m_Window;          //!< The maximum number of pending send operations
+    size_t   m_InFlight;        //!< The number of pending send operations
+    uint64_t m_ReplayedPackets; //!< The number of data packets handed to the sink
+    bool     m_bRunning;
+    bool     m_bHasNext;        //!< Indicates that m_Next holds the next data packet to replay
+    bool     m_bTimerArmed;
+    uint64_t m_Generation;      //!< Identifies the current replay to ignore timer expiries of stopped ones
+    HdlcdCaptureRecord m_Next;  //!< The next data packet to replay
+    uint64_t m_FirstTimestamp;  //!< The timestamp of the first replayed data packet
+    std::chrono::steady_clock::time_point m_StartTime; //!< The point in time the first data packet was replayed
+    std::function<void()> m_OnDoneCallback;
+};
+
+#endif // HDLCD_CAPTURE_REPLAYER_H
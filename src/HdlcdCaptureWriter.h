@@ -0,0 +1,365 @@
+/**
+ * \file      HdlcdCaptureWriter.h
+ * \brief     This file contains the header declaration of class HdlcdCaptureWriter
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_CAPTURE_WRITER_H
+#define HDLCD_CAPTURE_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include "HdlcdPacketData.h"
+
+/*! \class HdlcdCaptureWriter
+ *  \brief Class HdlcdCaptureWriter
+ * 
+ *  Records received and sent data packets into a pcapng file. Each data packet becomes an enhanced packet block: the
+ *  direction is derived from the "was sent" flag, the "invalid" flag is mapped to a CRC error, and reliable data packets
+ *  carry the comment "reliable".
+ *  
+ *  The calling thread only serializes each data packet into the active one of two preallocated buffers. A background
+ *  thread writes the other buffer to the file, thus the io_service is never blocked by file I/O. If both buffers are
+ *  full, the data packet is dropped and counted.
+ */
+class HdlcdCaptureWriter {
+public:
+    /*! \enum E_LINKTYPE
+     *  \brief The link types applicable to the content of data packets
+     */
+    typedef enum {
+        LINKTYPE_PPP_HDLC = 50,  //!< HDLC frames, e.g., sessions of type SESSION_TYPE_RX_HDLC
+        LINKTYPE_USER0    = 147  //!< Payload without framing, e.g., sessions of type SESSION_TYPE_TRX_ALL
+    } E_LINKTYPE;
+
+    /*! \brief  The constructor of HdlcdCaptureWriter objects
+     * 
+     *  \param  a_BufferSize the size of each of both buffers in octets
+     */
+    explicit HdlcdCaptureWriter(size_t a_BufferSize = (1 << 20)): m_File(nullptr), m_BufferSize(a_BufferSize), m_bFlushing(false),
+        m_bShutdown(false), m_RecordedPackets(0), m_DroppedPackets(0), m_WriteErrors(0) {
+        m_Active.reserve(m_BufferSize);
+        m_Flushing.reserve(m_BufferSize);
+    }
+
+    /*! \brief  The destructor of HdlcdCaptureWriter objects
+     */
+    ~HdlcdCaptureWriter() {
+        Close();
+    }
+
+    /*! \brief  Create the capture file and start the background thread
+     * 
+     *  \param  a_FileName the name of the capture file, an existing file is replaced
+     *  \param  a_eLinkType the link type of the recorded data packets
+     *  \param  a_InterfaceName the name of the interface stored in the capture file, e.g., the serial port name
+     * 
+     *  \retval true the capture file was created
+     *  \retval false the capture file could not be created or a capture file is already open
+     *  \return Indicates whether the capture file was created
+     */
+    bool Open(const std::string& a_FileName, E_LINKTYPE a_eLinkType = LINKTYPE_PPP_HDLC, const std::string& a_InterfaceName = "") {
+        if (m_File) {
+            return false;
+        } // if
+
+        m_File = fopen(a_FileName.c_str(), "wb");
+        if (!m_File) {
+            return false;
+        } // if
+
+        // The file headers are written synchronously, nothing was recorded yet
+        std::vector<char> l_Header;
+        AppendSectionHeaderBlock(l_Header);
+        AppendInterfaceDescriptionBlock(l_Header, a_eLinkType, a_InterfaceName);
+        if (fwrite(l_Header.data(), 1, l_Header.size(), m_File) != l_Header.size()) {
+            ++m_WriteErrors;
+        } // if
+
+        m_bShutdown = false;
+        m_Thread = std::thread([this]() { Run(); });
+        return true;
+    }
+
+    /*! \brief  Flush all recorded data packets, stop the background thread, and close the capture file
+     */
+    void Close() {
+        if (!m_File) {
+            return;
+        } // if
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            m_bShutdown = true;
+        }
+        m_Condition.notify_one();
+        m_Thread.join();
+        fclose(m_File);
+        m_File = nullptr;
+    }
+
+    /*! \brief  Record a data packet
+     * 
+     *  \param  a_PacketData the data packet to record
+     *  \param  a_Timestamp the point in time the data packet was received or sent
+     * 
+     *  \retval true the data packet was recorded
+     *  \retval false the data packet was dropped, either because no capture file is open or all buffers are full
+     *  \return Indicates whether the data packet was recorded
+     */
+    bool Record(const HdlcdPacketData& a_PacketData, std::chrono::system_clock::time_point a_Timestamp = std::chrono::system_clock::now()) {
+        const std::vector<unsigned char>& l_Payload = a_PacketData.GetData();
+        const bool l_bReliable = a_PacketData.GetReliable();
+        const size_t l_BlockSize = (28 + Pad(l_Payload.size()) + 8 + (l_bReliable ? 12 : 0) + 4 + 4);
+        std::unique_lock<std::mutex> l_Lock(m_Mutex);
+        if ((!m_File) || (m_bShutdown) || ((m_Active.size() + l_BlockSize) > m_BufferSize)) {
+            if ((m_File) && (!m_bShutdown) && (m_Active.empty())) {
+                // The data packet would never fit, grow the buffer once instead of dropping it forever
+                m_Active.reserve(l_BlockSize);
+            } else {
+                ++m_DroppedPackets;
+                return false;
+            } // else
+        } // if
+
+        // Enhanced packet block
+        uint64_t l_Timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(a_Timestamp.time_since_epoch()).count();
+        uint32_t l_Flags = (a_PacketData.GetWasSent() ? 0x00000002 : 0x00000001);
+        if (a_PacketData.GetInvalid()) {
+            l_Flags |= 0x01000000;
+        } // if
+
+        AppendUint32(m_Active, 0x00000006);
+        AppendUint32(m_Active, l_BlockSize);
+        AppendUint32(m_Active, 0); // Interface ID
+        AppendUint32(m_Active, uint32_t(l_Timestamp >> 32));
+        AppendUint32(m_Active, uint32_t(l_Timestamp));
+        AppendUint32(m_Active, l_Payload.size()); // Captured packet length
+        AppendUint32(m_Active, l_Payload.size()); // Original packet length
+        AppendPadded(m_Active, l_Payload.data(), l_Payload.size());
+        AppendOption(m_Active, 2, &l_Flags, sizeof(l_Flags)); // epb_flags
+        if (l_bReliable) {
+            AppendOption(m_Active, 1, "reliable", 8); // opt_comment
+        } // if
+
+        AppendUint32(m_Active, 0); // opt_endofopt
+        AppendUint32(m_Active, l_BlockSize);
+        ++m_RecordedPackets;
+        const bool l_bWakeUp = (!m_bFlushing);
+        l_Lock.unlock();
+        if (l_bWakeUp) {
+            m_Condition.notify_one();
+        } // if
+
+        return true;
+    }
+
+    /*! \brief  Query the number of recorded data packets
+     * 
+     *  \return The number of data packets that were recorded
+     */
+    uint64_t GetRecordedPackets() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_RecordedPackets;
+    }
+
+    /*! \brief  Query the number of dropped data packets
+     * 
+     *  \return The number of data packets that were dropped because all buffers were full
+     */
+    uint64_t GetDroppedPackets() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_DroppedPackets;
+    }
+
+    /*! \brief  Query the number of failed writes to the capture file
+     * 
+     *  \return The number of buffers that could not be written completely
+     */
+    uint64_t GetWriteErrors() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_WriteErrors;
+    }
+
+private:
+    /*! \brief  The main loop of the background thread: swap the buffers and write the filled one
+     */
+    void Run() {
+        std::unique_lock<std::mutex> l_Lock(m_Mutex);
+        while (true) {
+            m_Condition.wait(l_Lock, [this]() { return ((m_bShutdown) || (!m_Active.empty())); });
+            if (m_Active.empty()) {
+                // Shutdown requested and everything written
+                break;
+            } // if
+
+            m_Active.swap(m_Flushing);
+            m_bFlushing = true;
+            l_Lock.unlock();
+            bool l_bSuccess = (fwrite(m_Flushing.data(), 1, m_Flushing.size(), m_File) == m_Flushing.size());
+            if (m_Flushing.capacity() > m_BufferSize) {
+                // Shrink a buffer that was grown for an oversized data packet
+                std::vector<char>().swap(m_Flushing);
+                m_Flushing.reserve(m_BufferSize);
+            } else {
+                m_Flushing.clear();
+            } // else
+
+            l_Lock.lock();
+            m_bFlushing = false;
+            if (!l_bSuccess) {
+                ++m_WriteErrors;
+            } // if
+        } // while
+
+        fflush(m_File);
+    }
+
+    /*! \brief  Round a length up to the next multiple of four
+     * 
+     *  \param  a_Length the length
+     * 
+     *  \return The padded length
+     */
+    static size_t Pad(size_t a_Length) {
+        return ((a_Length + 3) & ~size_t(3));
+    }
+
+    /*! \brief  Append a 16 bit value in host byte order, as announced by the byte order magic
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_Value the value to append
+     */
+    static void AppendUint16(std::vector<char>& a_Buffer, uint16_t a_Value) {
+        const char* l_Value = reinterpret_cast<const char*>(&a_Value);
+        a_Buffer.insert(a_Buffer.end(), l_Value, l_Value + sizeof(a_Value));
+    }
+
+    /*! \brief  Append a 32 bit value in host byte order, as announced by the byte order magic
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_Value the value to append
+     */
+    static void AppendUint32(std::vector<char>& a_Buffer, uint32_t a_Value) {
+        const char* l_Value = reinterpret_cast<const char*>(&a_Value);
+        a_Buffer.insert(a_Buffer.end(), l_Value, l_Value + sizeof(a_Value));
+    }
+
+    /*! \brief  Append octets followed by zero padding up to the next multiple of four
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_Data the octets to append
+     *  \param  a_Length the number of octets to append
+     */
+    static void AppendPadded(std::vector<char>& a_Buffer, const void* a_Data, size_t a_Length) {
+        const char* l_Data = static_cast<const char*>(a_Data);
+        a_Buffer.insert(a_Buffer.end(), l_Data, l_Data + a_Length);
+        a_Buffer.insert(a_Buffer.end(), (Pad(a_Length) - a_Length), 0);
+    }
+
+    /*! \brief  Append an option of a pcapng block
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_Code the option code
+     *  \param  a_Data the option value
+     *  \param  a_Length the length of the option value
+     */
+    static void AppendOption(std::vector<char>& a_Buffer, uint16_t a_Code, const void* a_Data, uint16_t a_Length) {
+        AppendUint16(a_Buffer, a_Code);
+        AppendUint16(a_Buffer, a_Length);
+        AppendPadded(a_Buffer, a_Data, a_Length);
+    }
+
+    /*! \brief  Append the section header block
+     * 
+     *  \param  a_Buffer the buffer to append to
+     */
+    static void AppendSectionHeaderBlock(std::vector<char>& a_Buffer) {
+        AppendUint32(a_Buffer, 0x0A0D0D0A);
+        AppendUint32(a_Buffer, 28);
+        AppendUint32(a_Buffer, 0x1A2B3C4D); // Byte order magic
+        AppendUint16(a_Buffer, 1); // Major version
+        AppendUint16(a_Buffer, 0); // Minor version
+        AppendUint32(a_Buffer, 0xFFFFFFFF); // Section length not specified
+        AppendUint32(a_Buffer, 0xFFFFFFFF);
+        AppendUint32(a_Buffer, 28);
+    }
+
+    /*! \brief  Append the interface description block
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_eLinkType the link type of the recorded data packets
+     *  \param  a_InterfaceName the name of the interface, omitted if empty
+     */
+    static void AppendInterfaceDescriptionBlock(std::vector<char>& a_Buffer, E_LINKTYPE a_eLinkType, const std::string& a_InterfaceName) {
+        const uint8_t l_TimestampResolution = 9; // Nanoseconds
+        const size_t l_Name = (a_InterfaceName.empty() ? 0 : (4 + Pad(a_InterfaceName.size())));
+        const uint32_t l_BlockSize = (16 + 8 + l_Name + 4 + 4);
+        AppendUint32(a_Buffer, 0x00000001);
+        AppendUint32(a_Buffer, l_BlockSize);
+        AppendUint16(a_Buffer, a_eLinkType);
+        AppendUint16(a_Buffer, 0); // Reserved
+        AppendUint32(a_Buffer, 0); // No snap length limit
+        AppendOption(a_Buffer, 9, &l_TimestampResolution, sizeof(l_TimestampResolution)); // if_tsresol
+        if (l_Name) {
+            AppendOption(a_Buffer, 2, a_InterfaceName.data(), a_InterfaceName.size()); // if_name
+        } // if
+
+        AppendUint32(a_Buffer, 0); // opt_endofopt
+        AppendUint32(a_Buffer, l_BlockSize);
+    }
+
+    // Members
+    FILE*                   m_File;            //!< The capture file, nullptr if not open
+    const size_t            m_BufferSize;      //!< The size of each of both buffers
+    mutable std::mutex      m_Mutex;           //!< Protects the buffers, the flags, and the counters
+    std::condition_variable m_Condition;       //!< Wakes up the background thread
+    std::thread             m_Thread;          //!< The background thread writing to the capture file
+    std::vector<char>       m_Active;          //!< The buffer data packets are currently recorded into
+    std::vector<char>       m_Flushing;        //!< The buffer currently written by the background thread
+    bool                    m_bFlushing;       //!< Indicates that the background thread is writing
+    bool                    m_bShutdown;       //!< Indicates that the background thread has to terminate
+    uint64_t                m_RecordedPackets; //!< The number of recorded data packets
+    uint64_t                m_DroppedPackets;  //!< The number of dropped data packets
+    uint64_t                m_WriteErrors;     //!< The number of failed writes
+};
+
+#endif // HDLCD_CAPTURE_WRITER_H
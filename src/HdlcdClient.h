@@ -39,41 +39,75 @@
 #ifndef HDLCD_CLIENT_H
 #define HDLCD_CLIENT_H
 
+#include "HdlcdIoUring.h"
 #include <boost/asio.hpp>
+#include <deque>
+#include <map>
+#include <set>
 #include <vector>
 #include <string>
+#include "HdlcdEchoCorrelator.h"
+#include "HdlcdPacer.h"
 #include "HdlcdPacketEndpoint.h"
+#include "HdlcdProbes.h"
+#include "HdlcdSequenceTracker.h"
 #include "HdlcdSessionHeader.h"
 #include "HdlcdPacketData.h"
 #include "HdlcdPacketCtrl.h"
+#include "HdlcdPortStatus.h"
+#include "HdlcdSubmissionQueue.h"
 #include "FrameEndpoint.h"
 
-/*! \class HdlcdClient
- *  \brief Class HdlcdClient
+/*! \class HdlcdClientT
+ *  \brief Class template HdlcdClientT
  * 
- *  The main helper class to easily implement clients of the HDLCd access protocol. It implements the HDLCd access protocol
- *  and makes use of two TCP sockets: one TCP socket is dedicated to the exchange of user data, the second solely to the exchange
- *  of control packets. However, all the socket handling is performed internally and is not visible to the user of this class.
- *  
- *  This class provides an asynchronous interface, but it can also be used in a quasi-synchronous way.
+ *  The client of the HDLCd access protocol, delivering all received packets and events to a handler object whose type is known
+ *  at compile time. Thus, the compiler is able to inline the delivery from the packet endpoints to the code of the user.
+ *  The handler has to provide:
+ *  - bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData), returns false to stall the receiver until
+ *    TriggerNextDataPacket() is called
+ *  - void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl)
+ *  - void HandleClosed()
+ * 
+ *  The handler must outlive the client entity. See class HdlcdClient for a variant based on std::function callbacks.
  */
-class HdlcdClient {
+template <class THandler>
+class HdlcdClientT {
 public:
-    /*! \brief  The constructor of HdlcdClient objects
+    /*! \brief  The constructor of HdlcdClientT objects
      * 
      *  \param  a_IOService the boost IOService object
      *  \param  a_SerialPortName the name of the serial port device
      *  \param  a_HdlcdSessionDescriptor the indentifier of the session, see "service access point"
+     *  \param  a_Handler the handler object to deliver all received packets and events to
      */
-    HdlcdClient(boost::asio::io_service& a_IOService, const std::string &a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor):
+    HdlcdClientT(boost::asio::io_service& a_IOService, const std::string &a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor, THandler& a_Handler):
         m_IOService(a_IOService),
         m_SerialPortName(a_SerialPortName),
         m_HdlcdSessionDescriptor(a_HdlcdSessionDescriptor),
         m_bClosed(false),
+        m_Handler(a_Handler),
+        m_bNotifyHandler(true),
+        m_bFastConnect(false),
+        m_bSequenceNumbers(false),
         m_TcpSocketData(a_IOService),
         m_TcpSocketCtrl(a_IOService),
         m_eTcpSocketDataState(SOCKET_STATE_ERROR),
-        m_eTcpSocketCtrlState(SOCKET_STATE_ERROR) {
+        m_eTcpSocketCtrlState(SOCKET_STATE_ERROR),
+        m_DataSocketHandler(*this),
+        m_CtrlSocketHandler(*this),
+        m_PacingTimer(a_IOService),
+        m_bPacingTimerRunning(false),
+        m_PacedQueueLimit(1000),
+        m_LastSequence(0),
+        m_CompletedSequence(0),
+        m_PortStatusTimer(a_IOService),
+        m_PortStatusQuery(0),
+        m_bDesiredLockState(false),
+        m_PortStatisticsTimer(a_IOService),
+        m_PortStatisticsInterval(0),
+        m_SubmissionTimer(a_IOService),
+        m_bSubmittedPending(false) {
     }
     
     /*! \brief  Perform an asynchronous connect procedure regarding both TCP sockets
@@ -87,8 +121,21 @@ public:
         assert(m_eTcpSocketDataState == SOCKET_STATE_ERROR); // not tried yet, or retrying
         assert(m_eTcpSocketCtrlState == SOCKET_STATE_ERROR); // not tried yet, or retrying
 
-        // Connect the data socket
         m_OnConnectedCallback = a_OnConnectedCallback;
+        if (m_bFastConnect) {
+            // Each socket sends its session header right after its own connect, possibly within the SYN
+            m_eTcpSocketDataState = SOCKET_STATE_CONNECTING;
+            m_eTcpSocketCtrlState = SOCKET_STATE_CONNECTING;
+            auto l_SessionHeaderData = std::make_shared<std::vector<unsigned char>>(static_cast<const Frame&>(HdlcdSessionHeader::Create(
+                m_HdlcdSessionDescriptor, m_SerialPortName, m_PacketFilter, m_PortPatterns, m_bSequenceNumbers)).Serialize());
+            auto l_SessionHeaderCtrl = std::make_shared<std::vector<unsigned char>>(static_cast<const Frame&>(HdlcdSessionHeader::Create(
+                HdlcdSessionDescriptor(SESSION_TYPE_TRX_STATUS, SESSION_FLAGS_NONE), m_SerialPortName)).Serialize());
+            FastConnect(m_TcpSocketData, a_EndpointIterator, l_SessionHeaderData, [this](bool a_bSuccess) { OnTcpSocketDataConnected(a_bSuccess); });
+            FastConnect(m_TcpSocketCtrl, a_EndpointIterator, l_SessionHeaderCtrl, [this](bool a_bSuccess) { OnTcpSocketCtrlConnected(a_bSuccess); });
+            return;
+        } // if
+
+        // Connect the data socket
         m_eTcpSocketDataState = SOCKET_STATE_CONNECTING;
         boost::asio::async_connect(m_TcpSocketData, a_EndpointIterator, [this](boost::system::error_code a_ErrorCode, boost::asio::ip::tcp::resolver::iterator) {
             if (a_ErrorCode == boost::asio::error::operation_aborted) return;
@@ -111,14 +158,45 @@ public:
         });
     }
 
-    /*! \brief  The destructor of HdlcdClient objects
+    /*! \brief  Shorten the session setup, must be called before AsyncConnect()
+     * 
+     *  Each TCP socket sends its session header as soon as it is connected, without waiting for the other one, and the
+     *  session headers are sent within the SYN via TCP Fast Open if the kernel permits it, i.e., if TCP_FASTOPEN_CONNECT is
+     *  available, client-side TCP Fast Open is enabled via net.ipv4.tcp_fastopen, and a cookie of the HDLCd is cached.
+     *  Otherwise, the session headers follow the handshake as usual. The HDLCd has to enable TCP Fast Open on its
+     *  listening socket, see HdlcdSessionAcceptor::SetFastOpen().
+     * 
+     *  \param  a_bFastConnect indicates whether the fast session setup is used
+     */
+    void SetFastConnect(bool a_bFastConnect) {
+        m_bFastConnect = a_bFastConnect;
+    }
+
+    /*! \brief  Request sequence numbers in data packets to detect dropped ones, must be called before AsyncConnect()
+     * 
+     *  The HDLCd numbers the data packets of this session, and gaps are accounted by the sequence tracker. Requesting
+     *  sequence numbers requires an HDLCd supporting version 1 of the session header.
      * 
-     *  All open connections will automatically be closed by the destructor
+     *  \param  a_bSequenceNumbers indicates whether data packets have to carry sequence numbers
      */
-    ~HdlcdClient() {
-        m_OnDataCallback   = nullptr;
-        m_OnCtrlCallback   = nullptr;
-        m_OnClosedCallback = nullptr;
+    void SetSequenceTracking(bool a_bSequenceNumbers) {
+        m_bSequenceNumbers = a_bSequenceNumbers;
+    }
+
+    /*! \brief  Query the loss counters and the histogram of loss bursts
+     * 
+     *  \return The sequence tracker, empty if sequence numbers were not requested
+     */
+    const HdlcdSequenceTracker& GetSequenceTracker() const {
+        return m_SequenceTracker;
+    }
+
+    /*! \brief  The destructor of HdlcdClientT objects
+     * 
+     *  All open connections will automatically be closed by the destructor, without notifying the handler
+     */
+    ~HdlcdClientT() {
+        m_bNotifyHandler = false;
         Close();
     }
 
@@ -143,6 +221,15 @@ public:
     void Close() {
         if (m_bClosed == false) {
             m_bClosed = true;
+            HDLCD_PROBE1(session_closed, this);
+            m_PacingTimer.cancel();
+            m_PacedQueue.clear();
+            if (m_EchoCorrelator) {
+                m_EchoCorrelator->Clear();
+            } // if
+
+            CompletePortStatusQuery(false);
+            StopPortStatisticsPolling();
             if (m_PacketEndpointData) {
                 m_PacketEndpointData->Close();
                 m_PacketEndpointData.reset();
@@ -159,40 +246,20 @@ public:
                 m_TcpSocketCtrl.close();
             } // else
             
-            if (m_OnClosedCallback) {
-                m_OnClosedCallback();
+            if (m_bNotifyHandler) {
+                m_Handler.HandleClosed();
             } // if
         } // if
     }
-    
-    /*! \brief  Provide a callback method to be called for received data packets
-     * 
-     *  Data packets are received in an asynchronous way. Use this method to specify a callback method to be called on reception of single data packets
-     * 
-     *  \param  a_OnDataCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
-     */
-    void SetOnDataCallback(std::function<void(const HdlcdPacketData& a_PacketData)> a_OnDataCallback) {
-        m_OnDataCallback = a_OnDataCallback;
-    }
-    
-    /*! \brief  Provide a callback method to be called for received control packets
-     * 
-     *  Control packets are received in an asynchronous way. Use this method to specify a callback method to be called on reception of single control packets
-     * 
-     *  \param  a_OnCtrlCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
-     */
-    void SetOnCtrlCallback(std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> a_OnCtrlCallback) {
-        m_OnCtrlCallback = a_OnCtrlCallback;
-    }
-    
-    /*! \brief  Provide a callback method to be called if this client entity is closing
-     * 
-     *  This method can be used to provide a function pointer callback to be called if this entoty is closing, e.g., the peer closed its endpoint
+
+    /*! \brief  Resume the delivery of data packets
      * 
-     *  \param  a_OnClosedCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
+     *  Resume the delivery of data packets after the handler stalled the receiver by returning false
      */
-    void SetOnClosedCallback(std::function<void()> a_OnClosedCallback) {
-        m_OnClosedCallback = a_OnClosedCallback;
+    void TriggerNextDataPacket() {
+        if (m_PacketEndpointData) {
+            m_PacketEndpointData->TriggerNextDataPacket();
+        } // if
     }
     
     /*! \brief  Send a single data packet to the peer entity
@@ -207,18 +274,176 @@ public:
      *  \return Indicates whether the provided data packet was successfully enqueued for transmitted
      */
     bool Send(const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        uint64_t l_EchoId = 0;
+        if ((m_EchoCorrelator) && (m_PacketEndpointData)) {
+            l_EchoId = m_EchoCorrelator->Track(a_PacketData.GetData(), std::chrono::steady_clock::now());
+            std::function<void()> l_OnSendDoneCallback = a_OnSendDoneCallback;
+            a_OnSendDoneCallback = [this, l_EchoId, l_OnSendDoneCallback]() {
+                m_EchoCorrelator->OnWritten(l_EchoId, std::chrono::steady_clock::now());
+                if (l_OnSendDoneCallback) {
+                    l_OnSendDoneCallback();
+                } // if
+            };
+        } // if
+
         bool l_bRetVal = false;
-        if (m_PacketEndpointData) {
-            l_bRetVal = m_PacketEndpointData->Send(a_PacketData, a_OnSendDoneCallback);
+        if ((m_PacketEndpointData) && ((m_Pacer.IsEnabled()) || (!m_PacedQueue.empty()))) {
+            // Keep the order: while data packets are held back, all data packets pass the queue of the pacer
+            if (m_PacedQueue.size() < m_PacedQueueLimit) {
+                m_PacedQueue.emplace_back(a_PacketData, a_OnSendDoneCallback);
+                ReleasePacedData();
+                l_bRetVal = true;
+            } // if
+        } else if (m_PacketEndpointData) {
+            l_bRetVal = SendDataPacket(a_PacketData, a_OnSendDoneCallback);
         } else {
             if (a_OnSendDoneCallback) {
                 m_IOService.post([a_OnSendDoneCallback](){ a_OnSendDoneCallback(); });
             } // if
         } // else
+
+        if ((m_EchoCorrelator) && (m_PacketEndpointData) && (!l_bRetVal)) {
+            m_EchoCorrelator->Untrack(l_EchoId);
+        } // if
         
         return l_bRetVal;
     }
 
+    /*! \brief  Send a single data packet to the peer entity and track its transmission by a sequence number
+     * 
+     *  This is an alternative to Send() with a send done callback for high-rate producers. Each enqueued data packet is assigned
+     *  a monotonically increasing sequence number, starting at 1. Data packets are written in the order they were enqueued,
+     *  thus the progress of transmission is reported as a single number: all data packets up to and including that sequence
+     *  number have been written. This requires neither a heap-allocated closure nor a user callback per data packet.
+     *  Data packets dropped via DropPacedData() are reported as completed as well, but only once all data packets enqueued
+     *  before them were written or dropped.
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     * 
+     *  \return The sequence number assigned to the data packet, or 0 if the data packet was not enqueued
+     */
+    uint64_t SendSequenced(const HdlcdPacketData& a_PacketData) {
+        if (!m_PacketEndpointData) {
+            return 0;
+        } // if
+
+        // The closure only captures "this" and the sequence number, thus it fits into the small object buffer of std::function
+        const uint64_t l_Sequence = (m_LastSequence + 1);
+        if (!Send(a_PacketData, [this, l_Sequence](){ OnSequencedSendDone(l_Sequence); })) {
+            return 0;
+        } // if
+
+        m_LastSequence = l_Sequence;
+        return l_Sequence;
+    }
+
+    /*! \brief  Query the progress of data packets sent via SendSequenced()
+     * 
+     *  \return The sequence number of the last data packet that was written, all data packets before have been written as well
+     */
+    uint64_t GetCompletedSequence() const {
+        return m_CompletedSequence;
+    }
+
+    /*! \brief  Query the sequence number of the last data packet enqueued via SendSequenced()
+     * 
+     *  \return The sequence number of the last enqueued data packet, or 0 if no data packet was enqueued yet
+     */
+    uint64_t GetLastSequence() const {
+        return m_LastSequence;
+    }
+
+    /*! \brief  Provide a callback method to be called on progress of data packets sent via SendSequenced()
+     * 
+     *  \param  a_OnSendProgressCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
+     */
+    void SetOnSendProgressCallback(std::function<void(uint64_t a_CompletedSequence)> a_OnSendProgressCallback) {
+        m_OnSendProgressCallback = a_OnSendProgressCallback;
+    }
+
+    /*! \struct SubmittedData
+     *  \brief A data packet passed to Submit(), waiting in the submission queue
+     */
+    struct SubmittedData {
+        SubmittedData(): m_PacketData(HdlcdPacketData::CreatePacket(std::vector<unsigned char>(), false)) {}
+        SubmittedData(HdlcdPacketData a_PacketData, std::function<void()> a_OnSendDoneCallback): m_PacketData(std::move(a_PacketData)), m_OnSendDoneCallback(std::move(a_OnSendDoneCallback)) {}
+
+        HdlcdPacketData m_PacketData; //!< The data packet to be transmitted
+        std::function<void()> m_OnSendDoneCallback; //!< The callback handler to be called if the data packet was sent
+    };
+
+    /*! \brief  Create the submission queue to pass data packets from other threads to this client entity
+     * 
+     *  Must be called before any thread calls Submit(), e.g., directly after construction. The queue is bounded and allocated
+     *  once, thus it is not created unless needed.
+     * 
+     *  \param  a_Capacity the minimum number of data packets the submission queue can hold
+     */
+    void EnableSubmissionQueue(size_t a_Capacity = 1024) {
+        assert(!m_SubmissionQueue);
+        m_SubmissionQueue.reset(new HdlcdSubmissionQueue<SubmittedData>(a_Capacity));
+        m_SubmissionToken = std::make_shared<bool>(true);
+    }
+
+    /*! \brief  Send a single data packet to the peer entity, may be called by any thread
+     * 
+     *  In contrast to all other methods, this method may be called by threads other than the one running the IOService. The
+     *  data packet is appended to a lock-free submission queue, and the thread running the IOService is woken up once per batch
+     *  of submitted data packets to pass them to Send(), in the order of submission. If the send queue is full, the data packets
+     *  are held back and retried later, thus the submission queue fills up and reports backpressure to the producers.
+     *  Data packets submitted while no connection is established are dropped, and their callbacks are invoked nonetheless.
+     *  Callbacks are always invoked by the thread running the IOService. The client entity must not be destroyed while
+     *  other threads may call this method. Only data packets can be submitted; there is no path for packets serialized
+     *  beforehand, and control packets still have to be sent via Send() by the thread running the IOService.
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     *  \param  a_OnSendDoneCallback the callback handler to be called if the provided data packet was sent (optional)
+     * 
+     *  \retval true the data packet was appended to the submission queue
+     *  \retval false the submission queue is full
+     *  \return Indicates whether the provided data packet was appended to the submission queue
+     */
+    bool Submit(HdlcdPacketData a_PacketData, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        assert(m_SubmissionQueue);
+        if (!m_SubmissionQueue->Push(SubmittedData(std::move(a_PacketData), std::move(a_OnSendDoneCallback)))) {
+            return false;
+        } // if
+
+        if (m_SubmissionQueue->RequestWakeup()) {
+            PostDrainSubmissionQueue();
+        } // if
+
+        return true;
+    }
+
+    /*! \brief  Query the submission queue, e.g., to read its depth and contention counters
+     * 
+     *  \return The submission queue, or nullptr if it was not enabled
+     */
+    const HdlcdSubmissionQueue<SubmittedData>* GetSubmissionQueue() const {
+        return m_SubmissionQueue.get();
+    }
+
+    /*! \brief  Measure the latency of the serial line by correlating sent data packets with their echoes
+     * 
+     *  Requires a session with SESSION_FLAGS_DELIVER_SENT. Data packets passed to Send() are tracked, except for those passed
+     *  to SendExpedited() while pacing, as they overtake tracked ones. The echoes are still delivered to the handler.
+     * 
+     *  \param  a_MaxPending the maximum number of data packets waiting for their echo
+     */
+    void EnableEchoCorrelation(size_t a_MaxPending = 1024) {
+        assert(m_HdlcdSessionDescriptor.DeliversSentData());
+        m_EchoCorrelator.reset(new HdlcdEchoCorrelator(a_MaxPending));
+    }
+
+    /*! \brief  Query the latency histograms of the serial line
+     * 
+     *  \return The echo correlator, or nullptr if it was not enabled
+     */
+    const HdlcdEchoCorrelator* GetEchoCorrelator() const {
+        return m_EchoCorrelator.get();
+    }
+
     /*! \brief  Send a single control packet to the peer entity
      * 
      *  Send a single control packet to the peer entity. Due to the asynchronous mode the control packet is enqueued for later transmission.
@@ -231,6 +456,11 @@ public:
      *  \return Indicates whether the provided control packet was successfully enqueued for transmitted
      */
     bool Send(const HdlcdPacketCtrl& a_PacketCtrl, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        if (a_PacketCtrl.GetPacketType() == HdlcdPacketCtrl::CTRL_TYPE_PORT_STATUS) {
+            // Remember the lock state requested last, to be repeated by port status queries
+            m_bDesiredLockState = a_PacketCtrl.GetDesiredLockState();
+        } // if
+
         bool l_bRetVal = false;
         if (m_PacketEndpointCtrl) {
             l_bRetVal= m_PacketEndpointCtrl->Send(a_PacketCtrl, a_OnSendDoneCallback);
@@ -242,8 +472,355 @@ public:
 
         return l_bRetVal;
     }
+
+    /*! \brief  Query the status of the serial port asynchronously
+     * 
+     *  Concurrent queries are merged: only the first one sends a port status request, all others wait for the same
+     *  response. As responses cannot be correlated with requests, any port status received afterwards completes all
+     *  pending queries. The request repeats the lock state requested last via Send(), thus queries never alter it.
+     * 
+     *  \param  a_OnPortStatusCallback the callback to be called with the result, a_bSuccess is false if the client
+     *          entity is not connected, was closed, the request could not be sent, or no port status was received within
+     *          five seconds
+     */
+    void AsyncGetPortStatus(std::function<void(bool a_bSuccess, const HdlcdPortStatus& a_PortStatus)> a_OnPortStatusCallback) {
+        assert(a_OnPortStatusCallback);
+        if (!m_PacketEndpointCtrl) {
+            m_IOService.post([a_OnPortStatusCallback]() { a_OnPortStatusCallback(false, HdlcdPortStatus()); });
+            return;
+        } // if
+
+        m_PortStatusCallbacks.push_back(a_OnPortStatusCallback);
+        if (m_PortStatusCallbacks.size() > 1) {
+            // Coalesced with the query in flight
+            return;
+        } // if
+
+        if (!m_PacketEndpointCtrl->Send(HdlcdPacketCtrl::CreatePortStatusRequest(m_bDesiredLockState))) {
+            // The send queue is full, no response will arrive
+            CompletePortStatusQuery(false);
+            return;
+        } // if
+
+        const uint64_t l_PortStatusQuery = m_PortStatusQuery;
+        m_PortStatusTimer.expires_from_now(boost::posix_time::seconds(5));
+        m_PortStatusTimer.async_wait([this, l_PortStatusQuery](const boost::system::error_code& a_ErrorCode) {
+            // The expiry may have been queued before the query was completed, it must not fail a later query
+            if ((!a_ErrorCode) && (l_PortStatusQuery == m_PortStatusQuery)) {
+                CompletePortStatusQuery(false);
+            } // if
+        }); // async_wait
+    }
+
+    /*! \brief  Query the port status received last, either solicited or unsolicited
+     * 
+     *  \return The cached port status, invalid if none was received yet
+     */
+    const HdlcdPortStatus& GetPortStatus() const {
+        return m_PortStatus;
+    }
+
+    /*! \brief  Provide a callback method to be called if the port status changed
+     * 
+     *  The callback is invoked for the first port status received and for each port status that differs from the
+     *  previous one. Repeated identical port status packets are suppressed.
+     * 
+     *  \param  a_OnPortStatusChangedCallback the method to be called if the port status changed
+     */
+    void SetOnPortStatusChangedCallback(std::function<void(const HdlcdPortStatus& a_PortStatus)> a_OnPortStatusChangedCallback) {
+        m_OnPortStatusChangedCallback = a_OnPortStatusChangedCallback;
+    }
+
+    /*! \brief  Poll the performance counters of the serial port periodically
+     * 
+     *  A port statistics request is sent immediately and then once per interval while connected. Each port statistics
+     *  response is delivered to the callback, regardless of whether it was requested by this helper or via Send().
+     * 
+     *  \param  a_IntervalMilliseconds the polling interval in milliseconds
+     *  \param  a_OnPortStatisticsCallback the callback to be called for each received port statistics response
+     */
+    void StartPortStatisticsPolling(unsigned int a_IntervalMilliseconds, std::function<void(const HdlcdPortStatistics& a_PortStatistics)> a_OnPortStatisticsCallback) {
+        assert(a_IntervalMilliseconds);
+        assert(a_OnPortStatisticsCallback);
+        StopPortStatisticsPolling();
+        m_PortStatisticsInterval = a_IntervalMilliseconds;
+        m_OnPortStatisticsCallback = a_OnPortStatisticsCallback;
+        PollPortStatistics();
+    }
+
+    /*! \brief  Stop polling the performance counters of the serial port
+     */
+    void StopPortStatisticsPolling() {
+        m_PortStatisticsInterval = 0;
+        m_OnPortStatisticsCallback = nullptr;
+        m_PortStatisticsTimer.cancel();
+    }
+
+    /*! \brief  Send a single data packet to the peer entity, bypassing all data packets held back by the pacer
+     * 
+     *  If the pacer is enabled, the provided data packet is put to the front of the queue of data packets that wait for the
+     *  serial line, which is bounded by SetPacedQueueLimit(). Otherwise, this method behaves like Send().
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     *  \param  a_OnSendDoneCallback the callback handler to be called if the provided data packet was sent (optional)
+     * 
+     *  \retval true the data packet was enqueued for transmission
+     *  \retval false the data packet was not enqueued, e.g., the send queue was full or a problem with one of the sockets occured
+     *  \return Indicates whether the provided data packet was successfully enqueued for transmitted
+     */
+    bool SendExpedited(const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        if ((m_PacketEndpointData) && ((m_Pacer.IsEnabled()) || (!m_PacedQueue.empty()))) {
+            if (m_PacedQueue.size() >= m_PacedQueueLimit) {
+                return false;
+            } // if
+
+            m_PacedQueue.emplace_front(a_PacketData, a_OnSendDoneCallback);
+            ReleasePacedData();
+            return true;
+        } // if
+
+        return Send(a_PacketData, a_OnSendDoneCallback);
+    }
+
+    /*! \brief  Let the HDLCd filter the data packets before delivery
+     * 
+     *  Only data packets matching the filter program are delivered to this client entity, which saves bandwidth and
+     *  processing if only a fraction of the traffic is of interest. Must be called before AsyncConnect(). A non-empty
+     *  filter program requires an HDLCd supporting version 1 of the session header.
+     * 
+     *  \param  a_PacketFilter the filter program, an empty program delivers all data packets
+     */
+    void SetPacketFilter(const HdlcdPacketFilter& a_PacketFilter) {
+        m_PacketFilter = a_PacketFilter;
+    }
+
+    /*! \brief  Turn the data session into a multi-port session
+     * 
+     *  A multi-port session delivers the data packets of all serial ports matching at least one of the patterns via a
+     *  single data socket. Each data packet carries a port index, which can be resolved via GetPortName(). The control
+     *  socket still refers to the serial port name passed to the constructor, which may be empty. Must be called before
+     *  AsyncConnect() and requires an HDLCd supporting version 1 of the session header.
+     * 
+     *  \param  a_PortPatterns the names or globs of the serial ports, see HdlcdPortPattern
+     * 
+     *  \retval true the patterns were set
+     *  \retval false there are more than HdlcdPortPattern::MAX_PATTERNS patterns or one is longer than HdlcdPortPattern::MAX_LENGTH
+     *  \return Indicates whether the patterns were set
+     */
+    bool SetPortPatterns(const std::vector<std::string>& a_PortPatterns) {
+        if (!HdlcdPortPattern::IsValid(a_PortPatterns)) {
+            return false;
+        } // if
+
+        m_PortPatterns = a_PortPatterns;
+        return true;
+    }
+
+    /*! \brief  Resolve the port index of a data packet received via a multi-port session
+     * 
+     *  \param  a_PortIndex the port index carried by the data packet
+     * 
+     *  \return The name of the serial port, empty if the port index is unknown
+     */
+    const std::string& GetPortName(uint8_t a_PortIndex) const {
+        static const std::string s_Unknown;
+        auto l_PortName = m_PortNames.find(a_PortIndex);
+        return ((l_PortName != m_PortNames.end()) ? l_PortName->second : s_Unknown);
+    }
+
+    /*! \brief  Limit the rate of outgoing data packets to the rate of the serial line
+     * 
+     *  Writing data packets faster than the serial line drains them only fills the queues of the HDLCd and increases the
+     *  latency of all subsequent data packets. If a line rate is specified, excess data packets are held back in a queue of
+     *  this client entity, where they can still be expedited or dropped. If pacing is disabled, the data packets held back
+     *  are flushed first, and subsequent data packets queue up behind them until the queue is drained.
+     * 
+     *  \param  a_BitsPerSecond the baud rate of the serial line in bits per second, zero disables pacing
+     *  \param  a_BitsPerOctet the number of bits each octet occupies on the serial line, e.g., 10 for 8N1
+     */
+    void SetLineRate(uint32_t a_BitsPerSecond, uint32_t a_BitsPerOctet = 10) {
+        m_Pacer.Configure(a_BitsPerSecond, a_BitsPerOctet);
+        if ((m_Pacer.IsEnabled() == false) && (m_PacketEndpointData)) {
+            // Flush all data packets that were held back, retried via the pacing timer if the send queue is full
+            m_PacingTimer.cancel();
+            m_bPacingTimerRunning = false;
+            ReleasePacedData();
+        } // if
+    }
+
+    /*! \brief  Specify the maximum number of data packets held back by the pacer
+     * 
+     *  Send() and SendExpedited() fail if the queue of data packets held back by the pacer is full
+     * 
+     *  \param  a_PacedQueueLimit the maximum number of data packets held back by the pacer
+     */
+    void SetPacedQueueLimit(size_t a_PacedQueueLimit) {
+        m_PacedQueueLimit = a_PacedQueueLimit;
+    }
+
+    /*! \brief  Query the number of data packets held back by the pacer
+     * 
+     *  \return The number of data packets waiting for the serial line
+     */
+    size_t GetPacedQueueSize() const {
+        return m_PacedQueue.size();
+    }
+
+    /*! \brief  Drop all data packets held back by the pacer
+     * 
+     *  The send done callbacks of all dropped data packets are invoked nevertheless
+     */
+    void DropPacedData() {
+        for (auto l_PacedData = m_PacedQueue.begin(); l_PacedData != m_PacedQueue.end(); ++l_PacedData) {
+            if (l_PacedData->m_OnSendDoneCallback) {
+                m_IOService.post(l_PacedData->m_OnSendDoneCallback);
+            } // if
+        } // for
+
+        m_PacedQueue.clear();
+    }
+
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    /*! \brief  Query the per-stage latency histograms
+     * 
+     *  Only available if HDLCD_ENABLE_LATENCY_TRACING is defined
+     * 
+     *  \return The latency tracer of this client entity
+     */
+    HdlcdLatencyTracer& GetLatencyTracer() {
+        return m_LatencyTracer;
+    }
+#endif
     
 private:
+    /*! \brief  Hand all data packets to the data socket that the serial line is able to take
+     * 
+     *  Internal helper: release data packets as long as the pacer allows, and start a timer to release the remainder later
+     */
+    void ReleasePacedData() {
+        if (m_bPacingTimerRunning) {
+            return;
+        } // if
+
+        while (!m_PacedQueue.empty()) {
+            // If pacing was disabled meanwhile, the remaining data packets are released without delay
+            std::chrono::microseconds l_Delay(0);
+            if (m_Pacer.IsEnabled()) {
+                l_Delay = m_Pacer.GetDelay(std::chrono::steady_clock::now());
+            } // if
+
+            if (l_Delay.count() == 0) {
+                if (!SendDataPacket(m_PacedQueue.front().m_PacketData, m_PacedQueue.front().m_OnSendDoneCallback)) {
+                    // The send queue is full, try again later
+                    l_Delay = std::chrono::milliseconds(10);
+                } else {
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+                    m_LatencyTracer.Record(LATENCY_STAGE_TX_QUEUE, m_PacedQueue.front().m_Enqueued, HdlcdLatencyTracer::Now());
+#endif
+                    m_Pacer.Consume(m_PacedQueue.front().m_PacketData.GetData());
+                    m_PacedQueue.pop_front();
+                    continue;
+                } // else
+            } // if
+
+            m_bPacingTimerRunning = true;
+            m_PacingTimer.expires_from_now(boost::posix_time::microseconds(l_Delay.count()));
+            m_PacingTimer.async_wait([this](const boost::system::error_code& a_ErrorCode) {
+                if (a_ErrorCode == boost::asio::error::operation_aborted) return;
+                m_bPacingTimerRunning = false;
+                ReleasePacedData();
+            }); // async_wait
+            break;
+        } // while
+    }
+
+    /*! \brief  Hand a single data packet to the data socket
+     * 
+     *  Internal helper: hand a single data packet to the packet endpoint responsible for the data socket
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     *  \param  a_OnSendDoneCallback the callback handler to be called if the provided data packet was sent (optional)
+     * 
+     *  \return Indicates whether the provided data packet was successfully enqueued for transmitted
+     */
+    bool SendDataPacket(const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback) {
+#ifdef HDLCD_ENABLE_SDT_PROBES
+        size_t l_Length = a_PacketData.GetData().size();
+        std::function<void()> l_OnProbedSendDoneCallback = a_OnSendDoneCallback;
+        a_OnSendDoneCallback = [this, l_Length, l_OnProbedSendDoneCallback]() {
+            HDLCD_PROBE2(send_completed, this, l_Length);
+            if (l_OnProbedSendDoneCallback) {
+                l_OnProbedSendDoneCallback();
+            } // if
+        };
+#endif
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+        HdlcdLatencyTracer::Timestamp l_HandedOver = HdlcdLatencyTracer::Now();
+        std::function<void()> l_OnSendDoneCallback = a_OnSendDoneCallback;
+        a_OnSendDoneCallback = [this, l_HandedOver, l_OnSendDoneCallback]() {
+            m_LatencyTracer.Record(LATENCY_STAGE_TX_WRITE, l_HandedOver, HdlcdLatencyTracer::Now());
+            if (l_OnSendDoneCallback) {
+                l_OnSendDoneCallback();
+            } // if
+        };
+
+        bool l_bRetVal = m_PacketEndpointData->Send(a_PacketData, a_OnSendDoneCallback);
+        m_LatencyTracer.Record(LATENCY_STAGE_TX_SERIALIZE, l_HandedOver, HdlcdLatencyTracer::Now());
+#else
+        bool l_bRetVal = m_PacketEndpointData->Send(a_PacketData, a_OnSendDoneCallback);
+#endif
+        HDLCD_PROBE3(send_queued, this, a_PacketData.GetData().size(), l_bRetVal);
+        return l_bRetVal;
+    }
+
+
+    /*! \brief  Connect a single TCP socket and send its session header
+     * 
+     *  Internal helper: try all endpoints in turn, with TCP Fast Open if available. The socket counts as connected after the
+     *  session header was written.
+     * 
+     *  \param  a_TcpSocket the TCP socket to connect
+     *  \param  a_EndpointIterator the boost endpoint iteratior referring to the next endpoint to try
+     *  \param  a_SessionHeader the serialized session header
+     *  \param  a_OnConnectedCallback the callback to be called with the result
+     */
+    void FastConnect(boost::asio::ip::tcp::socket& a_TcpSocket, boost::asio::ip::tcp::resolver::iterator a_EndpointIterator,
+                     std::shared_ptr<std::vector<unsigned char>> a_SessionHeader, std::function<void(bool a_bSuccess)> a_OnConnectedCallback) {
+        boost::system::error_code l_ErrorCode;
+        while (a_EndpointIterator != boost::asio::ip::tcp::resolver::iterator()) {
+            a_TcpSocket.close(l_ErrorCode);
+            a_TcpSocket.open(a_EndpointIterator->endpoint().protocol(), l_ErrorCode);
+            if (!l_ErrorCode) {
+                break;
+            } // if
+
+            ++a_EndpointIterator;
+        } // while
+
+        if (a_EndpointIterator == boost::asio::ip::tcp::resolver::iterator()) {
+            m_IOService.post([a_OnConnectedCallback]() { a_OnConnectedCallback(false); });
+            return;
+        } // if
+
+#ifdef TCP_FASTOPEN_CONNECT
+        // Optional, the kernel may not support it
+        a_TcpSocket.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_FASTOPEN_CONNECT>(true), l_ErrorCode);
+#endif
+        a_TcpSocket.async_connect(a_EndpointIterator->endpoint(), [this, &a_TcpSocket, a_EndpointIterator, a_SessionHeader, a_OnConnectedCallback](boost::system::error_code a_ErrorCode) {
+            if (a_ErrorCode == boost::asio::error::operation_aborted) return;
+            if (a_ErrorCode) {
+                boost::asio::ip::tcp::resolver::iterator l_EndpointIterator = a_EndpointIterator;
+                FastConnect(a_TcpSocket, ++l_EndpointIterator, a_SessionHeader, a_OnConnectedCallback);
+                return;
+            } // if
+
+            boost::asio::async_write(a_TcpSocket, boost::asio::buffer(*a_SessionHeader), [a_SessionHeader, a_OnConnectedCallback](boost::system::error_code a_ErrorCode, std::size_t) {
+                if (a_ErrorCode == boost::asio::error::operation_aborted) return;
+                a_OnConnectedCallback(!a_ErrorCode);
+            }); // async_write
+        }); // async_connect
+    }
+
     /*! \brief  Indicate that the data socket was established or that an error occured
      * 
      *  Internal helper: indicate that the data socket was established or that an error occured
@@ -295,18 +872,23 @@ private:
         if ((m_eTcpSocketDataState == SOCKET_STATE_CONNECTED) && (m_eTcpSocketCtrlState == SOCKET_STATE_CONNECTED)) {
             // Success!
             // Create and start the packet endpoint for the exchange of user data packets
-            m_PacketEndpointData = std::make_shared<HdlcdPacketEndpoint>(m_IOService, std::make_shared<FrameEndpoint>(m_IOService, m_TcpSocketData));
-            m_PacketEndpointData->SetOnDataCallback([this](std::shared_ptr<const HdlcdPacketData> a_PacketData){ return OnDataReceived(a_PacketData); });
-            m_PacketEndpointData->SetOnClosedCallback([this](){ OnClosed(); });
+            m_PacketEndpointData = std::make_shared<PacketEndpointData>(m_IOService, std::make_shared<FrameEndpoint>(m_IOService, m_TcpSocketData), m_DataSocketHandler);
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            m_PacketEndpointData->SetLatencyTracer(&m_LatencyTracer);
+#endif
+            m_SequenceTracker.Restart();
             m_PacketEndpointData->Start();
-            m_PacketEndpointData->Send(HdlcdSessionHeader::Create(m_HdlcdSessionDescriptor, m_SerialPortName));
+            if (!m_bFastConnect) {
+                m_PacketEndpointData->Send(HdlcdSessionHeader::Create(m_HdlcdSessionDescriptor, m_SerialPortName, m_PacketFilter, m_PortPatterns, m_bSequenceNumbers));
+            } // if
             
             // Create and start the packet endpoint for the exchange of control packets
-            m_PacketEndpointCtrl = std::make_shared<HdlcdPacketEndpoint>(m_IOService, std::make_shared<FrameEndpoint>(m_IOService, m_TcpSocketCtrl));
-            m_PacketEndpointCtrl->SetOnCtrlCallback([this](const HdlcdPacketCtrl& a_PacketCtrl){ return OnCtrlReceived(a_PacketCtrl); });
-            m_PacketEndpointCtrl->SetOnClosedCallback([this](){ OnClosed(); });
+            m_PacketEndpointCtrl = std::make_shared<PacketEndpointCtrl>(m_IOService, std::make_shared<FrameEndpoint>(m_IOService, m_TcpSocketCtrl), m_CtrlSocketHandler);
             m_PacketEndpointCtrl->Start();
-            m_PacketEndpointCtrl->Send(HdlcdSessionHeader::Create(HdlcdSessionDescriptor(SESSION_TYPE_TRX_STATUS, SESSION_FLAGS_NONE), m_SerialPortName));
+            if (!m_bFastConnect) {
+                m_PacketEndpointCtrl->Send(HdlcdSessionHeader::Create(HdlcdSessionDescriptor(SESSION_TYPE_TRX_STATUS, SESSION_FLAGS_NONE), m_SerialPortName));
+            } // if
+            HDLCD_PROBE4(session_connected, this, m_PacketEndpointData.get(), m_PacketEndpointCtrl.get(), m_SerialPortName.c_str());
             m_OnConnectedCallback(true);
             return;
         } // if
@@ -344,7 +926,7 @@ private:
     
     /*! \brief  Internal callback method to be called on reception of data packets
      * 
-     *  This is an internal callback method to be called on reception of data packets
+     *  This is an internal callback method to be called by the packet endpoints on reception of data packets
      * 
      *  \param  a_PacketData the received data packet
      * 
@@ -352,32 +934,178 @@ private:
      *  \retval false no subsequent packets must be delivered before the next explicit poll
      *  \return Indicates whether the receiver should be stalled
      */
-    bool OnDataReceived(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
-        if (m_OnDataCallback) {
-            m_OnDataCallback(*(a_PacketData.get()));
+    bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+        if ((m_EchoCorrelator) && (a_PacketData->GetWasSent())) {
+            m_EchoCorrelator->OnEcho(*a_PacketData, std::chrono::steady_clock::now());
         } // if
-        
-        /// \todo Implement asynchronous behavior: the receiver must be stalled
-        return true; // Do not stall the receiver
+
+        if (a_PacketData->HasSequenceNumber()) {
+            m_SequenceTracker.Update(a_PacketData->GetSequenceNumber());
+        } // if
+
+        return m_Handler.HandleData(a_PacketData);
     }
 
     /*! \brief  Internal callback method to be called on reception of control packets
      * 
-     *  This is an internal callback method to be called on reception of control packets
+     *  This is an internal callback method to be called by the packet endpoints on reception of control packets
      * 
      *  \param  a_PacketCtrl the received data packet
      */
-    void OnCtrlReceived(const HdlcdPacketCtrl& a_PacketCtrl) {
-        if (m_OnCtrlCallback) {
-            m_OnCtrlCallback(a_PacketCtrl);
+    void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+        if (a_PacketCtrl.GetPacketType() == HdlcdPacketCtrl::CTRL_TYPE_PORT_STATUS) {
+            const HdlcdPortStatus l_PortStatus(a_PacketCtrl);
+            const bool l_bChanged = (l_PortStatus != m_PortStatus);
+            m_PortStatus = l_PortStatus;
+            CompletePortStatusQuery(true);
+            if ((l_bChanged) && (m_OnPortStatusChangedCallback)) {
+                m_OnPortStatusChangedCallback(m_PortStatus);
+            } // if
+        } else if ((a_PacketCtrl.GetPacketType() == HdlcdPacketCtrl::CTRL_TYPE_PORT_STATISTICS) && (a_PacketCtrl.GetIsPortStatisticsResponse()) &&
+                   (m_OnPortStatisticsCallback)) {
+            // Invoke a copy, the callback may stop polling and thus reset the original
+            auto l_OnPortStatisticsCallback = m_OnPortStatisticsCallback;
+            l_OnPortStatisticsCallback(a_PacketCtrl.GetPortStatistics());
+        } // else if
+
+        if (a_PacketCtrl.GetPacketType() == HdlcdPacketCtrl::CTRL_TYPE_PORT_TABLE) {
+            // Learn the port names of a multi-port session, entries of a later table replace earlier ones
+            const std::vector<std::pair<uint8_t, std::string>>& l_PortTable = a_PacketCtrl.GetPortTable();
+            for (auto l_Entry = l_PortTable.begin(); l_Entry != l_PortTable.end(); ++l_Entry) {
+                m_PortNames[l_Entry->first] = l_Entry->second;
+            } // for
+        } // if
+
+        m_Handler.HandleCtrl(a_PacketCtrl);
+    }
+
+    /*! \brief  Complete all pending port status queries
+     * 
+     *  Internal helper: deliver the cached port status or a failure to all pending port status queries. The callbacks
+     *  are posted, thus they may issue new queries.
+     * 
+     *  \param  a_bSuccess indicates whether a port status was received
+     */
+    void CompletePortStatusQuery(bool a_bSuccess) {
+        if (m_PortStatusCallbacks.empty()) {
+            return;
+        } // if
+
+        m_PortStatusTimer.cancel();
+        ++m_PortStatusQuery;
+        const HdlcdPortStatus l_PortStatus(a_bSuccess ? m_PortStatus : HdlcdPortStatus());
+        for (auto l_Callback = m_PortStatusCallbacks.begin(); l_Callback != m_PortStatusCallbacks.end(); ++l_Callback) {
+            auto l_OnPortStatusCallback = *l_Callback;
+            m_IOService.post([l_OnPortStatusCallback, a_bSuccess, l_PortStatus]() { l_OnPortStatusCallback(a_bSuccess, l_PortStatus); });
+        } // for
+
+        m_PortStatusCallbacks.clear();
+    }
+
+    /*! \brief  Send a port statistics request and schedule the next one
+     * 
+     *  Internal helper: one step of polling the performance counters of the serial port
+     */
+    void PollPortStatistics() {
+        if (!m_PortStatisticsInterval) {
+            return;
+        } // if
+
+        if (m_PacketEndpointCtrl) {
+            m_PacketEndpointCtrl->Send(HdlcdPacketCtrl::CreatePortStatisticsRequest());
+        } // if
+
+        m_PortStatisticsTimer.expires_from_now(boost::posix_time::milliseconds(m_PortStatisticsInterval));
+        m_PortStatisticsTimer.async_wait([this](const boost::system::error_code& a_ErrorCode) {
+            if (!a_ErrorCode) {
+                PollPortStatistics();
+            } // if
+        }); // async_wait
+    }
+
+    /*! \brief  Pass submitted data packets to Send()
+     * 
+     *  Internal helper: drain the submission queue on the thread running the IOService. A data packet rejected by a full send
+     *  queue is held back and retried later. The number of data packets per run is limited to not starve other handlers.
+     */
+    void DrainSubmissionQueue() {
+        for (size_t l_Budget = 256; l_Budget; --l_Budget) {
+            if ((!m_bSubmittedPending) && (!m_SubmissionQueue->Pop(m_SubmittedPending))) {
+                if (m_SubmissionQueue->EndBatch()) {
+                    continue;
+                } // if
+
+                return;
+            } // if
+
+            m_bSubmittedPending = true;
+            if (!m_PacketEndpointData) {
+                // Dropped, similar to Send()
+                if (m_SubmittedPending.m_OnSendDoneCallback) {
+                    m_IOService.post(m_SubmittedPending.m_OnSendDoneCallback);
+                } // if
+            } else if (!Send(m_SubmittedPending.m_PacketData, m_SubmittedPending.m_OnSendDoneCallback)) {
+                // The send queue is full, try again later. Producers are not woken up meanwhile.
+                m_SubmissionTimer.expires_from_now(boost::posix_time::milliseconds(10));
+                m_SubmissionTimer.async_wait([this](const boost::system::error_code& a_ErrorCode) {
+                    if (a_ErrorCode == boost::asio::error::operation_aborted) return;
+                    DrainSubmissionQueue();
+                }); // async_wait
+                return;
+            } // else if
+
+            m_bSubmittedPending = false;
+            m_SubmittedPending = SubmittedData();
+        } // for
+
+        // Continue later
+        PostDrainSubmissionQueue();
+    }
+
+    /*! \brief  Schedule DrainSubmissionQueue() on the thread running the IOService, may be called by any thread
+     * 
+     *  Internal helper: the posted handler only holds a weak reference to the submission token, thus it does nothing if this
+     *  client entity was destroyed before the handler runs.
+     */
+    void PostDrainSubmissionQueue() {
+        std::weak_ptr<bool> l_SubmissionToken(m_SubmissionToken);
+        m_IOService.post([this, l_SubmissionToken]() {
+            if (l_SubmissionToken.lock()) {
+                DrainSubmissionQueue();
+            } // if
+        }); // post
+    }
+
+    /*! \brief  Internal callback method to be called if a data packet sent via SendSequenced() was written
+     * 
+     *  This is an internal callback method to be called if a data packet sent via SendSequenced() was written or dropped.
+     *  Written data packets complete in order, but dropped data packets may complete before data packets still in flight.
+     *  Such completions are parked until all data packets before them completed.
+     * 
+     *  \param  a_Sequence the sequence number of the completed data packet
+     */
+    void OnSequencedSendDone(uint64_t a_Sequence) {
+        if (a_Sequence != (m_CompletedSequence + 1)) {
+            m_CompletedOutOfOrder.insert(a_Sequence);
+            return;
+        } // if
+
+        ++m_CompletedSequence;
+        while ((!m_CompletedOutOfOrder.empty()) && (*m_CompletedOutOfOrder.begin() == (m_CompletedSequence + 1))) {
+            m_CompletedOutOfOrder.erase(m_CompletedOutOfOrder.begin());
+            ++m_CompletedSequence;
+        } // while
+
+        if (m_OnSendProgressCallback) {
+            m_OnSendProgressCallback(m_CompletedSequence);
         } // if
     }
 
     /*! \brief  Internal callback method to be called on close of one of the TCP sockets
      * 
-     *  This is an internal callback method to be called on close of one of the TCP sockets
+     *  This is an internal callback method to be called by the packet endpoints on close of one of the TCP sockets
      */
-    void OnClosed() {
+    void HandleClosed() {
         Close();
     }
     
@@ -385,7 +1113,14 @@ private:
     boost::asio::io_service& m_IOService; //!< The boost IOService object
     const std::string m_SerialPortName;   //!< The name of the serial port to connect to a device
     const HdlcdSessionDescriptor m_HdlcdSessionDescriptor; //!< The service access point specifier regarding the protocol specification
+    HdlcdPacketFilter m_PacketFilter; //!< The filter program the HDLCd applies to data packets of this session
+    std::vector<std::string> m_PortPatterns; //!< The port patterns of a multi-port session, empty otherwise
+    std::map<uint8_t, std::string> m_PortNames; //!< The port table of a multi-port session
     bool m_bClosed; //!< Indicates whether the HDLCd access protocol entity has already been closed
+    THandler& m_Handler; //!< The handler object to deliver all received packets and events to
+    bool m_bNotifyHandler; //!< Indicates whether the handler has to be notified if this entity is closing
+    bool m_bFastConnect; //!< Indicates whether each socket sends its session header right after its own connect
+    bool m_bSequenceNumbers; //!< Indicates whether data packets have to carry sequence numbers
     
     std::function<void(bool a_bSuccess)> m_OnConnectedCallback;
     boost::asio::ip::tcp::socket m_TcpSocketData; //!< The TCP socket dedicated to user data
@@ -398,13 +1133,196 @@ private:
     E_SOCKET_STATE m_eTcpSocketDataState; //!< The state of the TCP data socket
     E_SOCKET_STATE m_eTcpSocketCtrlState; //!< The state of the TCP control socket
     
-    std::shared_ptr<HdlcdPacketEndpoint> m_PacketEndpointData; //!< The packet endpoint class responsible for the connected data socket
-    std::shared_ptr<HdlcdPacketEndpoint> m_PacketEndpointCtrl; //!< The packet endpoint class responsible for the connected control socket
-    
+    /*! \class SocketHandler
+     *  \brief The handler of the packet endpoint of one of both TCP sockets
+     * 
+     *  Data packets are only accepted via the data socket, and control packets only via the control socket, except for the
+     *  port table of multi-port sessions that is sent via the data socket. Packets of the other kind are dropped. The type
+     *  of the socket is a template parameter, thus the check is resolved at compile time.
+     */
+    template <bool IsDataSocket>
+    class SocketHandler {
+    public:
+        explicit SocketHandler(HdlcdClientT& a_Client): m_Client(a_Client) {
+        }
+
+        bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+            if (!IsDataSocket) {
+                return true;
+            } // if
+
+            return m_Client.HandleData(a_PacketData);
+        }
+
+        void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+            if ((IsDataSocket) && (a_PacketCtrl.GetPacketType() != HdlcdPacketCtrl::CTRL_TYPE_PORT_TABLE)) {
+                return;
+            } // if
+
+            m_Client.HandleCtrl(a_PacketCtrl);
+        }
+
+        void HandleClosed() {
+            m_Client.HandleClosed();
+        }
+
+    private:
+        HdlcdClientT& m_Client; //!< The client entity to deliver to
+    };
+
+    SocketHandler<true>  m_DataSocketHandler; //!< The handler of the packet endpoint of the data socket
+    SocketHandler<false> m_CtrlSocketHandler; //!< The handler of the packet endpoint of the control socket
+    typedef HdlcdPacketEndpointT<SocketHandler<true>>  PacketEndpointData; //!< The packet endpoint of the data socket delivers directly to this client entity
+    typedef HdlcdPacketEndpointT<SocketHandler<false>> PacketEndpointCtrl; //!< The packet endpoint of the control socket delivers directly to this client entity
+    std::shared_ptr<PacketEndpointData> m_PacketEndpointData; //!< The packet endpoint class responsible for the connected data socket
+    std::shared_ptr<PacketEndpointCtrl> m_PacketEndpointCtrl; //!< The packet endpoint class responsible for the connected control socket
+
+    // Pacing of outgoing data packets
+    HdlcdPacer m_Pacer; //!< The token bucket that models the rate of the serial line
+    /*! \struct PacedData
+     *  \brief A data packet held back by the pacer
+     */
+    struct PacedData {
+        PacedData(const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback): m_PacketData(a_PacketData), m_OnSendDoneCallback(a_OnSendDoneCallback) {
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            m_Enqueued = HdlcdLatencyTracer::Now();
+#endif
+        }
+
+        HdlcdPacketData m_PacketData; //!< The data packet to be transmitted
+        std::function<void()> m_OnSendDoneCallback; //!< The callback handler to be called if the data packet was sent
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+        HdlcdLatencyTracer::Timestamp m_Enqueued; //!< The point in time the data packet was enqueued
+#endif
+    };
+    std::deque<PacedData> m_PacedQueue; //!< The data packets held back by the pacer
+    boost::asio::deadline_timer m_PacingTimer; //!< The timer to release data packets held back by the pacer
+    bool m_bPacingTimerRunning; //!< Indicates whether the pacing timer is running
+    size_t m_PacedQueueLimit; //!< The maximum number of data packets held back by the pacer
+
+    // Sequence numbers of data packets sent via SendSequenced()
+    uint64_t m_LastSequence; //!< The sequence number assigned to the last enqueued data packet
+    uint64_t m_CompletedSequence; //!< The sequence number of the last written data packet
+    std::set<uint64_t> m_CompletedOutOfOrder; //!< The sequence numbers of dropped data packets that completed ahead of others
+    std::function<void(uint64_t)> m_OnSendProgressCallback; //!< The callback function that is invoked if a data packet sent via SendSequenced() was written
+
+    // Port status
+    boost::asio::deadline_timer m_PortStatusTimer; //!< The timer to fail pending port status queries
+    uint64_t m_PortStatusQuery; //!< Identifies the pending port status query to ignore timer expiries of completed ones
+    bool m_bDesiredLockState; //!< The lock state requested last, repeated by port status queries
+    HdlcdPortStatus m_PortStatus; //!< The port status received last
+    std::vector<std::function<void(bool a_bSuccess, const HdlcdPortStatus& a_PortStatus)>> m_PortStatusCallbacks; //!< The pending port status queries
+    std::function<void(const HdlcdPortStatus& a_PortStatus)> m_OnPortStatusChangedCallback; //!< Invoked if the port status changed
+
+    // Port statistics
+    boost::asio::deadline_timer m_PortStatisticsTimer; //!< The timer to poll the performance counters of the serial port
+    unsigned int m_PortStatisticsInterval; //!< The polling interval in milliseconds, zero if not polling
+    std::function<void(const HdlcdPortStatistics& a_PortStatistics)> m_OnPortStatisticsCallback; //!< Invoked for each port statistics response
+
+    // Data packets submitted by other threads
+    std::unique_ptr<HdlcdSubmissionQueue<SubmittedData>> m_SubmissionQueue; //!< The submission queue, only if enabled
+    boost::asio::deadline_timer m_SubmissionTimer; //!< The timer to retry a submitted data packet rejected by the send queue
+    SubmittedData m_SubmittedPending; //!< The submitted data packet taken from the submission queue but not sent yet
+    bool m_bSubmittedPending; //!< Indicates whether m_SubmittedPending holds a data packet
+    std::shared_ptr<bool> m_SubmissionToken; //!< Expires with this client entity, see PostDrainSubmissionQueue()
+
+    std::unique_ptr<HdlcdEchoCorrelator> m_EchoCorrelator; //!< Correlates sent data packets with their echoes, only if enabled
+    HdlcdSequenceTracker m_SequenceTracker; //!< Detects gaps in the sequence numbers of received data packets
+
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    HdlcdLatencyTracer m_LatencyTracer; //!< The per-stage latency histograms of all packets passing this client entity
+#endif
+};
+
+
+
+/*! \class HdlcdClientCallbacks
+ *  \brief Class HdlcdClientCallbacks
+ * 
+ *  The handler of class HdlcdClient that forwards all received packets and events to std::function callbacks
+ */
+class HdlcdClientCallbacks {
+public:
+    bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+        if (m_OnDataCallback) {
+            m_OnDataCallback(*(a_PacketData.get()));
+        } // if
+
+        return true; // Do not stall the receiver
+    }
+
+    void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+        if (m_OnCtrlCallback) {
+            m_OnCtrlCallback(a_PacketCtrl);
+        } // if
+    }
+
+    void HandleClosed() {
+        if (m_OnClosedCallback) {
+            m_OnClosedCallback();
+        } // if
+    }
+
+protected:
     // All possible callbacks for a user of this class
     std::function<void(const HdlcdPacketData&)> m_OnDataCallback; //!< The callback function that is invoked on reception of a data packet
     std::function<void(const HdlcdPacketCtrl&)> m_OnCtrlCallback; //!< The callback function that is invoked on reception of a control packet
     std::function<void()> m_OnClosedCallback;  //!< The callback function that is invoked if the either this endpoint or that of the peer goes down
 };
 
+
+
+/*! \class HdlcdClient
+ *  \brief Class HdlcdClient
+ * 
+ *  The main helper class to easily implement clients of the HDLCd access protocol. It implements the HDLCd access protocol
+ *  and makes use of two TCP sockets: one TCP socket is dedicated to the exchange of user data, the second solely to the exchange
+ *  of control packets. However, all the socket handling is performed internally and is not visible to the user of this class.
+ *  
+ *  This class provides an asynchronous interface, but it can also be used in a quasi-synchronous way. All received packets and
+ *  events are delivered via std::function callbacks; see class template HdlcdClientT to bind a handler at compile time instead.
+ */
+class HdlcdClient: private HdlcdClientCallbacks, public HdlcdClientT<HdlcdClientCallbacks> {
+public:
+    /*! \brief  The constructor of HdlcdClient objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_SerialPortName the name of the serial port device
+     *  \param  a_HdlcdSessionDescriptor the indentifier of the session, see "service access point"
+     */
+    HdlcdClient(boost::asio::io_service& a_IOService, const std::string &a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor):
+        HdlcdClientT<HdlcdClientCallbacks>(a_IOService, a_SerialPortName, a_HdlcdSessionDescriptor, *this) {
+    }
+
+    /*! \brief  Provide a callback method to be called for received data packets
+     * 
+     *  Data packets are received in an asynchronous way. Use this method to specify a callback method to be called on reception of single data packets
+     * 
+     *  \param  a_OnDataCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
+     */
+    void SetOnDataCallback(std::function<void(const HdlcdPacketData& a_PacketData)> a_OnDataCallback) {
+        m_OnDataCallback = a_OnDataCallback;
+    }
+    
+    /*! \brief  Provide a callback method to be called for received control packets
+     * 
+     *  Control packets are received in an asynchronous way. Use this method to specify a callback method to be called on reception of single control packets
+     * 
+     *  \param  a_OnCtrlCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
+     */
+    void SetOnCtrlCallback(std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> a_OnCtrlCallback) {
+        m_OnCtrlCallback = a_OnCtrlCallback;
+    }
+    
+    /*! \brief  Provide a callback method to be called if this client entity is closing
+     * 
+     *  This method can be used to provide a function pointer callback to be called if this entoty is closing, e.g., the peer closed its endpoint
+     * 
+     *  \param  a_OnClosedCallback the funtion pointer to the callback method, may be an empty function pointer to remove the callback
+     */
+    void SetOnClosedCallback(std::function<void()> a_OnClosedCallback) {
+        m_OnClosedCallback = a_OnClosedCallback;
+    }
+};
+
 #endif // HDLCD_CLIENT_H
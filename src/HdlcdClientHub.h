@@ -0,0 +1,261 @@
+/**
+ * \file      HdlcdClientHub.h
+ * \brief     This file contains the header declaration of class HdlcdClientHub
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_CLIENT_HUB_H
+#define HDLCD_CLIENT_HUB_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+#include "HdlcdClient.h"
+#include "HdlcdHubSubscription.h"
+
+/*! \class HdlcdClientHub
+ *  \brief Class HdlcdClientHub
+ * 
+ *  Shares sessions to an HDLC daemon among in-process consumers. For each pair of serial port name and session descriptor
+ *  a single client entity is connected, regardless of the number of subscriptions. Each received data packet is
+ *  deserialized once and the same immutable instance is delivered to all subscriptions of the session.
+ *  
+ *  A session is connected on its first subscription and closed if its last subscription was removed via Unsubscribe().
+ *  If a session is closed by the peer or fails to connect, all its subscriptions are notified and the next subscription starts
+ *  a new session.
+ */
+class HdlcdClientHub {
+public:
+    /*! \brief  The constructor of HdlcdClientHub objects
+     * 
+     *  \param  a_IOService the boost IOService object
+     *  \param  a_EndpointIterator the boost endpoint iteratior referring to the HDLC daemon
+     */
+    HdlcdClientHub(boost::asio::io_service& a_IOService, boost::asio::ip::tcp::resolver::iterator a_EndpointIterator): m_IOService(a_IOService),
+        m_EndpointIterator(a_EndpointIterator) {
+    }
+
+    /*! \brief  The destructor of HdlcdClientHub objects
+     * 
+     *  All sessions are closed without notifying the subscriptions
+     */
+    ~HdlcdClientHub() {
+        for (auto l_Iterator = m_Sessions.begin(); l_Iterator != m_Sessions.end(); ++l_Iterator) {
+            l_Iterator->second->m_bNotify = false;
+        } // for
+    }
+
+    /*! \brief  Subscribe to a session, connecting it if required
+     * 
+     *  \param  a_SerialPortName the name of the serial port device
+     *  \param  a_HdlcdSessionDescriptor the indentifier of the session, see "service access point"
+     *  \param  a_QueueLimit the maximum number of data packets waiting in the queue of the subscription
+     * 
+     *  \return The subscription
+     */
+    std::shared_ptr<HdlcdHubSubscription> Subscribe(const std::string& a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor, size_t a_QueueLimit = 1000) {
+        const SessionKey l_Key(a_SerialPortName, uint8_t(a_HdlcdSessionDescriptor));
+        std::shared_ptr<Session>& l_Session = m_Sessions[l_Key];
+        if (!l_Session) {
+            l_Session = std::make_shared<Session>(*this, l_Key, a_SerialPortName, a_HdlcdSessionDescriptor);
+            std::weak_ptr<Session> l_WeakSession(l_Session);
+            l_Session->m_Client.AsyncConnect(m_EndpointIterator, [l_WeakSession](bool a_bSuccess) {
+                // A failed connect closes the session like a close by the peer
+                auto l_Session = l_WeakSession.lock();
+                if ((!a_bSuccess) && (l_Session)) {
+                    l_Session->HandleClosed();
+                } // if
+            });
+        } // if
+
+        auto l_Subscription = std::make_shared<HdlcdHubSubscription>(a_QueueLimit);
+        std::weak_ptr<Session> l_WeakSession(l_Session);
+        l_Subscription->m_DataSender = [l_WeakSession](const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback) {
+            auto l_Session = l_WeakSession.lock();
+            return (l_Session && l_Session->m_Client.Send(a_PacketData, a_OnSendDoneCallback));
+        };
+        l_Subscription->m_CtrlSender = [l_WeakSession](const HdlcdPacketCtrl& a_PacketCtrl, std::function<void()> a_OnSendDoneCallback) {
+            auto l_Session = l_WeakSession.lock();
+            return (l_Session && l_Session->m_Client.Send(a_PacketCtrl, a_OnSendDoneCallback));
+        };
+        l_Session->m_Subscriptions.push_back(l_Subscription);
+        return l_Subscription;
+    }
+
+    /*! \brief  Remove a subscription, closing its session if it was the last one
+     * 
+     *  \param  a_Subscription the subscription to remove
+     */
+    void Unsubscribe(const std::shared_ptr<HdlcdHubSubscription>& a_Subscription) {
+        for (auto l_Iterator = m_Sessions.begin(); l_Iterator != m_Sessions.end(); ++l_Iterator) {
+            std::shared_ptr<Session> l_Session = l_Iterator->second;
+            auto& l_Subscriptions = l_Session->m_Subscriptions;
+            for (auto l_SubIterator = l_Subscriptions.begin(); l_SubIterator != l_Subscriptions.end(); ++l_SubIterator) {
+                if (l_SubIterator->lock() == a_Subscription) {
+                    l_Subscriptions.erase(l_SubIterator);
+                    a_Subscription->m_DataSender = nullptr;
+                    a_Subscription->m_CtrlSender = nullptr;
+                    l_Session->Prune();
+                    return;
+                } // if
+            } // for
+        } // for
+    }
+
+    /*! \brief  Query the number of sessions currently shared
+     * 
+     *  \return The number of sessions
+     */
+    size_t GetSessionCount() const {
+        return m_Sessions.size();
+    }
+
+private:
+    typedef std::pair<std::string, uint8_t> SessionKey; //!< Serial port name and service access point specifier
+
+    /*! \class Session
+     *  \brief A single client entity and the subscriptions sharing it
+     */
+    class Session {
+    public:
+        Session(HdlcdClientHub& a_Hub, const SessionKey& a_Key, const std::string& a_SerialPortName, HdlcdSessionDescriptor a_HdlcdSessionDescriptor):
+            m_Hub(a_Hub), m_Key(a_Key), m_bNotify(true), m_Client(a_Hub.m_IOService, a_SerialPortName, a_HdlcdSessionDescriptor, *this) {
+        }
+
+        /*! \brief  Deliver a data packet to all subscriptions
+         * 
+         *  \param  a_PacketData the received data packet
+         * 
+         *  \return Always true, overflows are handled by each subscription
+         */
+        bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+            bool l_bExpired = false;
+            for (size_t l_Index = 0; l_Index < m_Subscriptions.size(); ++l_Index) {
+                if (auto l_Subscription = m_Subscriptions[l_Index].lock()) {
+                    l_Subscription->DeliverData(a_PacketData);
+                } else {
+                    l_bExpired = true;
+                } // else
+            } // for
+
+            if (l_bExpired) {
+                Prune();
+            } // if
+
+            return true;
+        }
+
+        /*! \brief  Deliver a control packet to all subscriptions
+         * 
+         *  \param  a_PacketCtrl the received control packet
+         */
+        void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+            for (size_t l_Index = 0; l_Index < m_Subscriptions.size(); ++l_Index) {
+                if (auto l_Subscription = m_Subscriptions[l_Index].lock()) {
+                    l_Subscription->DeliverCtrl(a_PacketCtrl);
+                } // if
+            } // for
+        }
+
+        /*! \brief  The client entity was closed: notify all subscriptions and remove this session from the hub
+         */
+        void HandleClosed() {
+            if (!m_bNotify) {
+                return;
+            } // if
+
+            m_bNotify = false;
+            std::vector<std::weak_ptr<HdlcdHubSubscription>> l_Subscriptions;
+            l_Subscriptions.swap(m_Subscriptions);
+            for (size_t l_Index = 0; l_Index < l_Subscriptions.size(); ++l_Index) {
+                if (auto l_Subscription = l_Subscriptions[l_Index].lock()) {
+                    l_Subscription->DeliverClosed();
+                } // if
+            } // for
+
+            Remove();
+        }
+
+        /*! \brief  Drop expired subscriptions and close the session if none is left
+         */
+        void Prune() {
+            for (auto l_Iterator = m_Subscriptions.begin(); l_Iterator != m_Subscriptions.end();) {
+                if (l_Iterator->expired()) {
+                    l_Iterator = m_Subscriptions.erase(l_Iterator);
+                } else {
+                    ++l_Iterator;
+                } // else
+            } // for
+
+            if (m_Subscriptions.empty()) {
+                m_bNotify = false;
+                Remove();
+            } // if
+        }
+
+        /*! \brief  Remove this session from the hub, deferred as this might be called from within the client entity
+         */
+        void Remove() {
+            auto l_Iterator = m_Hub.m_Sessions.find(m_Key);
+            if ((l_Iterator == m_Hub.m_Sessions.end()) || (l_Iterator->second.get() != this)) {
+                return;
+            } // if
+
+            std::shared_ptr<Session> l_Session = l_Iterator->second;
+            m_Hub.m_Sessions.erase(l_Iterator);
+            m_Hub.m_IOService.post([l_Session]() {
+                l_Session->m_Client.Close();
+            }); // post
+        }
+
+        // Members
+        HdlcdClientHub& m_Hub;
+        const SessionKey m_Key;
+        bool m_bNotify; //!< Indicates whether the subscriptions are to be notified if the client entity was closed
+        std::vector<std::weak_ptr<HdlcdHubSubscription>> m_Subscriptions;
+        HdlcdClientT<Session> m_Client;
+    };
+
+    // Members
+    boost::asio::io_service& m_IOService;
+    boost::asio::ip::tcp::resolver::iterator m_EndpointIterator;
+    std::map<SessionKey, std::shared_ptr<Session>> m_Sessions;
+};
+
+#endif // HDLCD_CLIENT_HUB_H
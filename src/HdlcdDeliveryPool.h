@@ -0,0 +1,288 @@
+/**
+ * \file      HdlcdDeliveryPool.h
+ * \brief     This file contains the header declaration of class HdlcdDeliveryPool
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_DELIVERY_POOL_H
+#define HDLCD_DELIVERY_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include "HdlcdPacketData.h"
+
+/*! \class HdlcdDeliveryPool
+ *  \brief Class HdlcdDeliveryPool
+ * 
+ *  A pool of worker threads that processes received data packets off the thread running the IOService, thus expensive
+ *  consumers, e.g., decoders, do not stall the reception of other sessions. Each data packet is delivered with a key, e.g.,
+ *  one per session or one per port of a multi-port session, and all data packets of the same key are processed by the same
+ *  worker thread in the order of delivery. Data packets of different keys are processed in parallel.
+ * 
+ *  The queue of each worker thread is bounded: if it is full, the data packet is still taken, but the receiver is asked to
+ *  stall until the worker thread caught up. This maps to the handler concept of HdlcdClientT directly:
+ * 
+ *      bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+ *          return m_DeliveryPool.Deliver(HdlcdDeliveryPool::GetKey(&m_Client), a_PacketData, [this]() {
+ *              m_IOService.post([this]() { m_Client.TriggerNextDataPacket(); });
+ *          });
+ *      }
+ */
+class HdlcdDeliveryPool {
+public:
+    typedef std::function<void(size_t a_Key, std::shared_ptr<const HdlcdPacketData> a_PacketData)> Consumer; //!< Processes a single data packet
+
+    /*! \brief  The constructor of HdlcdDeliveryPool objects
+     * 
+     *  \param  a_Workers the number of worker threads, at least one
+     *  \param  a_QueueLimit the number of data packets per worker thread before receivers are asked to stall
+     *  \param  a_Consumer the function to process data packets, called by the worker threads
+     */
+    HdlcdDeliveryPool(size_t a_Workers, size_t a_QueueLimit, Consumer a_Consumer): m_QueueLimit(a_QueueLimit ? a_QueueLimit : 1), m_Consumer(a_Consumer) {
+        assert(a_Workers);
+        assert(m_Consumer);
+        for (size_t l_Index = 0; l_Index < a_Workers; ++l_Index) {
+            m_Workers.emplace_back(new Worker);
+        } // for
+    }
+
+    /*! \brief  The destructor of HdlcdDeliveryPool objects
+     */
+    ~HdlcdDeliveryPool() {
+        Stop();
+    }
+
+    /*! \brief  Start the worker threads
+     */
+    void Start() {
+        for (auto l_Worker = m_Workers.begin(); l_Worker != m_Workers.end(); ++l_Worker) {
+            Worker* l_pWorker = l_Worker->get();
+            if (!l_pWorker->m_Thread.joinable()) {
+                l_pWorker->m_bShutdown = false;
+                l_pWorker->m_Thread = std::thread([this, l_pWorker]() { Run(*l_pWorker); });
+            } // if
+        } // for
+    }
+
+    /*! \brief  Process all queued data packets and stop the worker threads
+     * 
+     *  Stalled receivers are resumed, data packets delivered afterwards are queued until the next call to Start()
+     */
+    void Stop() {
+        for (auto l_Worker = m_Workers.begin(); l_Worker != m_Workers.end(); ++l_Worker) {
+            if ((*l_Worker)->m_Thread.joinable()) {
+                {
+                    std::lock_guard<std::mutex> l_Lock((*l_Worker)->m_Mutex);
+                    (*l_Worker)->m_bShutdown = true;
+                }
+                (*l_Worker)->m_Condition.notify_one();
+                (*l_Worker)->m_Thread.join();
+            } // if
+        } // for
+    }
+
+    /*! \brief  Derive a key from a session, e.g., the address of the client entity
+     * 
+     *  \param  a_pSession the session
+     * 
+     *  \return The key
+     */
+    static size_t GetKey(const void* a_pSession) {
+        return reinterpret_cast<size_t>(a_pSession);
+    }
+
+    /*! \brief  Derive a key from a port of a multi-port session
+     * 
+     *  \param  a_pSession the multi-port session
+     *  \param  a_PacketData the received data packet, carrying the port index
+     * 
+     *  \return The key
+     */
+    static size_t GetKey(const void* a_pSession, const HdlcdPacketData& a_PacketData) {
+        return (GetKey(a_pSession) ^ (a_PacketData.HasPortIndex() ? (size_t(a_PacketData.GetPortIndex()) + 1) : 0));
+    }
+
+    /*! \brief  Hand a received data packet to the worker thread responsible for the key
+     * 
+     *  The data packet is always taken. If the queue of the worker thread is full afterwards, the receiver has to stall, and
+     *  the provided callback is called by the worker thread as soon as the queue drained to half of its limit.
+     * 
+     *  \param  a_Key the key to preserve the order for, see GetKey()
+     *  \param  a_PacketData the received data packet
+     *  \param  a_OnResumeCallback the callback to resume the receiver, called by a worker thread
+     * 
+     *  \retval true the receiver may continue
+     *  \retval false the receiver has to stall until the callback is called
+     *  \return Indicates whether the receiver may continue
+     */
+    bool Deliver(size_t a_Key, std::shared_ptr<const HdlcdPacketData> a_PacketData, std::function<void()> a_OnResumeCallback) {
+        Worker& l_Worker = *m_Workers[Spread(a_Key) % m_Workers.size()];
+        bool l_bContinue = true;
+        bool l_bNotify = false;
+        {
+            std::lock_guard<std::mutex> l_Lock(l_Worker.m_Mutex);
+            l_bNotify = l_Worker.m_Queue.empty();
+            l_Worker.m_Queue.emplace_back(a_Key, std::move(a_PacketData));
+            if (l_Worker.m_Queue.size() >= m_QueueLimit) {
+                l_Worker.m_ResumeCallbacks.emplace_back(std::move(a_OnResumeCallback));
+                ++l_Worker.m_Stalls;
+                l_bContinue = false;
+            } // if
+        }
+
+        if (l_bNotify) {
+            l_Worker.m_Condition.notify_one();
+        } // if
+
+        return l_bContinue;
+    }
+
+    /*! \brief  Query the number of processed data packets
+     * 
+     *  \return The number of data packets passed to the consumer
+     */
+    uint64_t GetProcessed() const {
+        uint64_t l_Processed = 0;
+        for (auto l_Worker = m_Workers.begin(); l_Worker != m_Workers.end(); ++l_Worker) {
+            std::lock_guard<std::mutex> l_Lock((*l_Worker)->m_Mutex);
+            l_Processed += (*l_Worker)->m_Processed;
+        } // for
+
+        return l_Processed;
+    }
+
+    /*! \brief  Query the number of times a receiver was asked to stall
+     * 
+     *  \return The number of times a receiver was asked to stall
+     */
+    uint64_t GetStalls() const {
+        uint64_t l_Stalls = 0;
+        for (auto l_Worker = m_Workers.begin(); l_Worker != m_Workers.end(); ++l_Worker) {
+            std::lock_guard<std::mutex> l_Lock((*l_Worker)->m_Mutex);
+            l_Stalls += (*l_Worker)->m_Stalls;
+        } // for
+
+        return l_Stalls;
+    }
+
+    /*! \brief  Query the number of worker threads
+     * 
+     *  \return The number of worker threads
+     */
+    size_t GetWorkerCount() const {
+        return m_Workers.size();
+    }
+
+private:
+    /*! \struct Worker
+     *  \brief A worker thread and its queue
+     */
+    struct Worker {
+        Worker(): m_bShutdown(false), m_Processed(0), m_Stalls(0) {}
+
+        std::mutex              m_Mutex;     //!< Protects the queue, the callbacks, and the counters
+        std::condition_variable m_Condition; //!< Wakes up the worker thread
+        std::thread             m_Thread;    //!< The worker thread
+        bool                    m_bShutdown; //!< Indicates whether the worker thread has to stop if the queue is empty
+        std::deque<std::pair<size_t, std::shared_ptr<const HdlcdPacketData>>> m_Queue; //!< The data packets to be processed
+        std::vector<std::function<void()>> m_ResumeCallbacks; //!< The callbacks of the stalled receivers
+        uint64_t                m_Processed; //!< The number of processed data packets
+        uint64_t                m_Stalls;    //!< The number of times a receiver was asked to stall
+    };
+
+    /*! \brief  Spread the bits of a key, addresses used as keys are aligned and thus share their low bits
+     * 
+     *  \param  a_Key the key
+     * 
+     *  \return The spread key
+     */
+    static size_t Spread(size_t a_Key) {
+        return size_t((uint64_t(a_Key) * 0x9E3779B97F4A7C15ULL) >> 32);
+    }
+
+    /*! \brief  The main loop of a worker thread
+     * 
+     *  \param  a_Worker the worker thread
+     */
+    void Run(Worker& a_Worker) {
+        std::unique_lock<std::mutex> l_Lock(a_Worker.m_Mutex);
+        while (true) {
+            a_Worker.m_Condition.wait(l_Lock, [&a_Worker]() { return ((a_Worker.m_bShutdown) || (!a_Worker.m_Queue.empty())); });
+            if (a_Worker.m_Queue.empty()) {
+                // Shutdown requested and everything processed
+                break;
+            } // if
+
+            std::pair<size_t, std::shared_ptr<const HdlcdPacketData>> l_Entry(std::move(a_Worker.m_Queue.front()));
+            a_Worker.m_Queue.pop_front();
+            std::vector<std::function<void()>> l_ResumeCallbacks;
+            if (a_Worker.m_Queue.size() <= (m_QueueLimit / 2)) {
+                l_ResumeCallbacks.swap(a_Worker.m_ResumeCallbacks);
+            } // if
+
+            l_Lock.unlock();
+            for (auto l_Callback = l_ResumeCallbacks.begin(); l_Callback != l_ResumeCallbacks.end(); ++l_Callback) {
+                (*l_Callback)();
+            } // for
+
+            m_Consumer(l_Entry.first, std::move(l_Entry.second));
+            l_Lock.lock();
+            ++a_Worker.m_Processed;
+        } // while
+
+        // Do not leave receivers stalled
+        std::vector<std::function<void()>> l_ResumeCallbacks;
+        l_ResumeCallbacks.swap(a_Worker.m_ResumeCallbacks);
+        l_Lock.unlock();
+        for (auto l_Callback = l_ResumeCallbacks.begin(); l_Callback != l_ResumeCallbacks.end(); ++l_Callback) {
+            (*l_Callback)();
+        } // for
+    }
+
+    // Members
+    const size_t m_QueueLimit; //!< The number of data packets per worker thread before receivers are asked to stall
+    const Consumer m_Consumer; //!< The function to process data packets
+    std::vector<std::unique_ptr<Worker>> m_Workers; //!< The worker threads
+};
+
+#endif // HDLCD_DELIVERY_POOL_H
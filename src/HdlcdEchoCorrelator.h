@@ -0,0 +1,230 @@
+/**
+ * \file      HdlcdEchoCorrelator.h
+ * \brief     This file contains the header declaration of class HdlcdEchoCorrelator
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_ECHO_CORRELATOR_H
+#define HDLCD_ECHO_CORRELATOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <stdint.h>
+#include "HdlcdHistogram.h"
+#include "HdlcdPacketData.h"
+
+/*! \class HdlcdEchoCorrelator
+ *  \brief Class HdlcdEchoCorrelator
+ * 
+ *  Correlates the data packets sent by a client entity with their echoes, i.e., the data packets with the "was sent" flag
+ *  that the HDLCd delivers to sessions with SESSION_FLAGS_DELIVER_SENT after the frame was transmitted via the serial line.
+ *  For each correlated data packet the latencies between the submission to the client entity, the write to the TCP socket,
+ *  and the transmission via the serial line are collected in histograms, in nanoseconds. Thus, the time spent queueing in
+ *  the HDLCd and on the serial line can be told apart from the time spent in the client entity.
+ *  
+ *  Data packets are matched by a hash and the length of their payload in first-in first-out order. Echoes that match none of
+ *  the pending data packets, e.g., of other sessions writing to the same serial port, are ignored. Pending data packets
+ *  that are skipped by a matching echo are counted as lost, e.g., if the HDLCd dropped them.
+ */
+class HdlcdEchoCorrelator {
+public:
+    /*! \brief  The type of timestamps
+     */
+    typedef std::chrono::steady_clock::time_point Timestamp;
+
+    /*! \brief  The constructor of HdlcdEchoCorrelator objects
+     * 
+     *  \param  a_MaxPending the maximum number of data packets waiting for their echo, the oldest ones are counted as lost
+     */
+    explicit HdlcdEchoCorrelator(size_t a_MaxPending = 1024): m_MaxPending(a_MaxPending ? a_MaxPending : 1), m_NextId(0), m_Matched(0), m_Lost(0),
+        m_Foreign(0) {
+    }
+
+    /*! \brief  Start tracking a data packet submitted for transmission
+     * 
+     *  \param  a_Payload the payload of the data packet
+     *  \param  a_Submitted the point in time the data packet was submitted
+     * 
+     *  \return The identifier of the data packet, to be passed to OnWritten() or Untrack()
+     */
+    uint64_t Track(const std::vector<unsigned char>& a_Payload, Timestamp a_Submitted) {
+        if (m_Pending.size() >= m_MaxPending) {
+            m_Pending.pop_front();
+            ++m_Lost;
+        } // if
+
+        Pending l_Pending;
+        l_Pending.m_Id = m_NextId++;
+        l_Pending.m_Hash = Hash(a_Payload);
+        l_Pending.m_Length = a_Payload.size();
+        l_Pending.m_Submitted = a_Submitted;
+        l_Pending.m_bWritten = false;
+        m_Pending.push_back(l_Pending);
+        return l_Pending.m_Id;
+    }
+
+    /*! \brief  Stop tracking the data packet tracked last, e.g., because it could not be enqueued
+     * 
+     *  \param  a_Id the identifier of the data packet
+     */
+    void Untrack(uint64_t a_Id) {
+        if ((!m_Pending.empty()) && (m_Pending.back().m_Id == a_Id)) {
+            m_Pending.pop_back();
+        } // if
+    }
+
+    /*! \brief  A tracked data packet was written to the TCP socket
+     * 
+     *  \param  a_Id the identifier of the data packet
+     *  \param  a_Written the point in time the data packet was written
+     */
+    void OnWritten(uint64_t a_Id, Timestamp a_Written) {
+        // Identifiers of pending data packets are contiguous, except for the effects of Untrack()
+        if ((m_Pending.empty()) || (a_Id < m_Pending.front().m_Id)) {
+            return;
+        } // if
+
+        size_t l_Index = std::min(size_t(a_Id - m_Pending.front().m_Id), (m_Pending.size() - 1));
+        while ((l_Index > 0) && (m_Pending[l_Index].m_Id > a_Id)) {
+            --l_Index;
+        } // while
+
+        if (m_Pending[l_Index].m_Id == a_Id) {
+            m_Pending[l_Index].m_Written = a_Written;
+            m_Pending[l_Index].m_bWritten = true;
+            m_SubmitToWrite.Add(Nanoseconds(m_Pending[l_Index].m_Submitted, a_Written));
+        } // if
+    }
+
+    /*! \brief  Correlate a received echo with a tracked data packet
+     * 
+     *  \param  a_PacketData the received data packet with the "was sent" flag
+     *  \param  a_Received the point in time the echo was received
+     * 
+     *  \retval true the echo was correlated with a tracked data packet
+     *  \retval false the echo does not belong to any tracked data packet
+     *  \return Indicates whether the echo was correlated with a tracked data packet
+     */
+    bool OnEcho(const HdlcdPacketData& a_PacketData, Timestamp a_Received) {
+        const std::vector<unsigned char>& l_Payload = a_PacketData.GetData();
+        const uint64_t l_Hash = Hash(l_Payload);
+        for (size_t l_Index = 0; l_Index < m_Pending.size(); ++l_Index) {
+            const Pending& l_Pending = m_Pending[l_Index];
+            if ((l_Pending.m_Hash == l_Hash) && (l_Pending.m_Length == l_Payload.size())) {
+                m_SubmitToEcho.Add(Nanoseconds(l_Pending.m_Submitted, a_Received));
+                if (l_Pending.m_bWritten) {
+                    m_WriteToEcho.Add(Nanoseconds(l_Pending.m_Written, a_Received));
+                } // if
+
+                // All older data packets will never be echoed
+                m_Lost += l_Index;
+                m_Pending.erase(m_Pending.begin(), (m_Pending.begin() + l_Index + 1));
+                ++m_Matched;
+                return true;
+            } // if
+        } // for
+
+        ++m_Foreign;
+        return false;
+    }
+
+    /*! \brief  Forget all tracked data packets, e.g., after the session was closed
+     */
+    void Clear() {
+        m_Pending.clear();
+    }
+
+    const HdlcdHistogram& GetSubmitToWrite() const { return m_SubmitToWrite; } //!< Submission to write to the TCP socket, in nanoseconds
+    const HdlcdHistogram& GetWriteToEcho() const { return m_WriteToEcho; }     //!< Write to the TCP socket to reception of the echo, in nanoseconds
+    const HdlcdHistogram& GetSubmitToEcho() const { return m_SubmitToEcho; }   //!< Submission to reception of the echo, in nanoseconds
+    uint64_t GetMatched() const { return m_Matched; }                          //!< The number of correlated echoes
+    uint64_t GetLost() const { return m_Lost; }                                //!< The number of tracked data packets never echoed
+    uint64_t GetForeign() const { return m_Foreign; }                          //!< The number of echoes not matching any tracked data packet
+    size_t GetPending() const { return m_Pending.size(); }                     //!< The number of data packets waiting for their echo
+
+private:
+    /*! \struct Pending
+     *  \brief A data packet waiting for its echo
+     */
+    struct Pending {
+        uint64_t  m_Id;        //!< The identifier of the data packet
+        uint64_t  m_Hash;      //!< The hash of the payload
+        size_t    m_Length;    //!< The length of the payload
+        Timestamp m_Submitted; //!< The point in time the data packet was submitted
+        Timestamp m_Written;   //!< The point in time the data packet was written, only valid if m_bWritten is set
+        bool      m_bWritten;  //!< Indicates whether the data packet was written
+    };
+
+    /*! \brief  Calculate the FNV-1a hash of a payload
+     * 
+     *  \param  a_Payload the payload
+     * 
+     *  \return The hash
+     */
+    static uint64_t Hash(const std::vector<unsigned char>& a_Payload) {
+        uint64_t l_Hash = 0xCBF29CE484222325ULL;
+        for (auto l_Octet = a_Payload.begin(); l_Octet != a_Payload.end(); ++l_Octet) {
+            l_Hash = ((l_Hash ^ *l_Octet) * 0x100000001B3ULL);
+        } // for
+
+        return l_Hash;
+    }
+
+    /*! \brief  Calculate the nanoseconds between two timestamps
+     * 
+     *  \param  a_Begin the earlier timestamp
+     *  \param  a_End the later timestamp
+     * 
+     *  \return The nanoseconds between both timestamps, zero if not in order
+     */
+    static uint64_t Nanoseconds(Timestamp a_Begin, Timestamp a_End) {
+        return ((a_End > a_Begin) ? uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(a_End - a_Begin).count()) : 0);
+    }
+
+    // Members
+    const size_t m_MaxPending;     //!< The maximum number of data packets waiting for their echo
+    std::deque<Pending> m_Pending; //!< The data packets waiting for their echo, in order of submission
+    uint64_t m_NextId;             //!< The identifier of the next tracked data packet
+    uint64_t m_Matched;
+    uint64_t m_Lost;
+    uint64_t m_Foreign;
+    HdlcdHistogram m_SubmitToWrite;
+    HdlcdHistogram m_WriteToEcho;
+    HdlcdHistogram m_SubmitToEcho;
+};
+
+#endif // HDLCD_ECHO_CORRELATOR_H
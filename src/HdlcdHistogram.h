@@ -0,0 +1,183 @@
+/**
+ * \file      HdlcdHistogram.h
+ * \brief     This file contains the header declaration of class HdlcdHistogram
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_HISTOGRAM_H
+#define HDLCD_HISTOGRAM_H
+
+#include <stdint.h>
+
+/*! \class HdlcdHistogram
+ *  \brief Class HdlcdHistogram
+ * 
+ *  A histogram with logarithmic buckets to collect distributions of latencies or sizes cheaply. Bucket 0 counts the value 0,
+ *  and bucket n counts all values in the range [2^(n-1), 2^n - 1]. Percentiles are reported as the upper bound of the bucket
+ *  they fall into, thus they overestimate by less than a factor of two.
+ */
+class HdlcdHistogram {
+public:
+    /*! \brief  The number of buckets, sufficient to cover the full range of 64-bit values
+     */
+    static const unsigned int BUCKETS = 65;
+
+    /*! \brief  The constructor of HdlcdHistogram objects
+     */
+    HdlcdHistogram() {
+        Reset();
+    }
+
+    /*! \brief  Remove all collected samples
+     */
+    void Reset() {
+        for (unsigned int l_Index = 0; l_Index < BUCKETS; ++l_Index) {
+            m_Buckets[l_Index] = 0;
+        } // for
+
+        m_Count = 0;
+        m_Sum   = 0;
+        m_Min   = UINT64_MAX;
+        m_Max   = 0;
+    }
+
+    /*! \brief  Add a single sample
+     * 
+     *  \param  a_Value the value of the sample
+     */
+    void Add(uint64_t a_Value) {
+        ++m_Buckets[GetBucketIndex(a_Value)];
+        ++m_Count;
+        m_Sum += a_Value;
+        if (a_Value < m_Min) { m_Min = a_Value; }
+        if (a_Value > m_Max) { m_Max = a_Value; }
+    }
+
+    /*! \brief  Query the number of collected samples
+     * 
+     *  \return The number of collected samples
+     */
+    uint64_t GetCount() const {
+        return m_Count;
+    }
+
+    /*! \brief  Query the sum of all collected samples
+     * 
+     *  \return The sum of all collected samples
+     */
+    uint64_t GetSum() const {
+        return m_Sum;
+    }
+
+    /*! \brief  Query the smallest collected sample
+     * 
+     *  \return The smallest collected sample, or 0 if no samples were collected
+     */
+    uint64_t GetMin() const {
+        return (m_Count ? m_Min : 0);
+    }
+
+    /*! \brief  Query the largest collected sample
+     * 
+     *  \return The largest collected sample
+     */
+    uint64_t GetMax() const {
+        return m_Max;
+    }
+
+    /*! \brief  Query the number of samples in a single bucket
+     * 
+     *  \param  a_Index the index of the bucket, 0 to BUCKETS - 1
+     * 
+     *  \return The number of samples in the specified bucket
+     */
+    uint64_t GetBucket(unsigned int a_Index) const {
+        return ((a_Index < BUCKETS) ? m_Buckets[a_Index] : 0);
+    }
+
+    /*! \brief  Query the upper bound of a percentile
+     * 
+     *  \param  a_Percentile the percentile, e.g., 99.9
+     * 
+     *  \return The upper bound of the bucket that contains the specified percentile, or 0 if no samples were collected
+     */
+    uint64_t GetPercentile(double a_Percentile) const {
+        uint64_t l_Rank = uint64_t((a_Percentile / 100.0) * m_Count);
+        if (l_Rank >= m_Count) {
+            return m_Max;
+        } // if
+
+        uint64_t l_Seen = 0;
+        for (unsigned int l_Index = 0; l_Index < BUCKETS; ++l_Index) {
+            l_Seen += m_Buckets[l_Index];
+            if (l_Seen > l_Rank) {
+                uint64_t l_UpperBound = ((l_Index == 0) ? 0 : ((l_Index == 64) ? UINT64_MAX : ((uint64_t(1) << l_Index) - 1)));
+                return ((l_UpperBound < m_Max) ? l_UpperBound : m_Max);
+            } // if
+        } // for
+
+        return m_Max;
+    }
+
+private:
+    /*! \brief  Determine the bucket for a value
+     * 
+     *  \param  a_Value the value
+     * 
+     *  \return The index of the bucket the value belongs to
+     */
+    static unsigned int GetBucketIndex(uint64_t a_Value) {
+#if defined(__GNUC__)
+        return (a_Value ? (64 - __builtin_clzll(a_Value)) : 0);
+#else
+        unsigned int l_Index = 0;
+        while (a_Value) {
+            ++l_Index;
+            a_Value >>= 1;
+        } // while
+
+        return l_Index;
+#endif
+    }
+
+    // Members
+    uint64_t m_Buckets[BUCKETS]; //!< The number of samples per bucket
+    uint64_t m_Count;            //!< The number of collected samples
+    uint64_t m_Sum;              //!< The sum of all collected samples
+    uint64_t m_Min;              //!< The smallest collected sample
+    uint64_t m_Max;              //!< The largest collected sample
+};
+
+#endif // HDLCD_HISTOGRAM_H
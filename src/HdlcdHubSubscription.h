@@ -0,0 +1,243 @@
+/**
+ * \file      HdlcdHubSubscription.h
+ * \brief     This file contains the header declaration of class HdlcdHubSubscription
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_HUB_SUBSCRIPTION_H
+#define HDLCD_HUB_SUBSCRIPTION_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include "HdlcdPacketData.h"
+#include "HdlcdPacketCtrl.h"
+
+/*! \class HdlcdHubSubscription
+ *  \brief Class HdlcdHubSubscription
+ * 
+ *  The view of a single consumer onto a session shared via HdlcdClientHub. Each subscription owns a bounded queue of
+ *  received data packets. The data packets are immutable and shared by all subscriptions of the same session. If the
+ *  queue is full, further data packets are dropped and counted for this subscription only, thus a slow consumer never
+ *  stalls the session or other consumers.
+ *  
+ *  Pop() and the queries may be called from any thread. All callbacks are invoked and Send() must be called from the
+ *  thread running the io_service of the hub.
+ */
+class HdlcdHubSubscription {
+public:
+    /*! \brief  The constructor of HdlcdHubSubscription objects, created by HdlcdClientHub only
+     * 
+     *  \param  a_QueueLimit the maximum number of data packets waiting in the queue
+     */
+    explicit HdlcdHubSubscription(size_t a_QueueLimit): m_QueueLimit(a_QueueLimit), m_DeliveredPackets(0), m_DroppedPackets(0), m_bClosed(false) {
+    }
+
+    /*! \brief  Provide a callback method to be called if the queue is not empty anymore
+     * 
+     *  The callback is invoked once for each transition from an empty to a non-empty queue. The consumer is expected
+     *  to drain the queue via Pop() afterwards, either directly or from another thread.
+     * 
+     *  \param  a_OnDataCallback the method to be called if data packets are available
+     */
+    void SetOnDataCallback(std::function<void()> a_OnDataCallback) {
+        m_OnDataCallback = a_OnDataCallback;
+    }
+
+    /*! \brief  Provide a callback method to be called for received control packets
+     * 
+     *  \param  a_OnCtrlCallback the method to be called for received control packets
+     */
+    void SetOnCtrlCallback(std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> a_OnCtrlCallback) {
+        m_OnCtrlCallback = a_OnCtrlCallback;
+    }
+
+    /*! \brief  Provide a callback method to be called if the shared session was closed
+     * 
+     *  \param  a_OnClosedCallback the method to be called if the shared session was closed
+     */
+    void SetOnClosedCallback(std::function<void()> a_OnClosedCallback) {
+        m_OnClosedCallback = a_OnClosedCallback;
+    }
+
+    /*! \brief  Take the oldest data packet from the queue
+     * 
+     *  \param  a_PacketData the data packet taken from the queue
+     * 
+     *  \retval true a data packet was taken from the queue
+     *  \retval false the queue is empty
+     *  \return Indicates whether a data packet was taken from the queue
+     */
+    bool Pop(std::shared_ptr<const HdlcdPacketData>& a_PacketData) {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        if (m_Queue.empty()) {
+            return false;
+        } // if
+
+        a_PacketData = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        return true;
+    }
+
+    /*! \brief  Send a data packet via the shared session
+     * 
+     *  \param  a_PacketData the data packet to be transmitted
+     *  \param  a_OnSendDoneCallback the callback handler to be called if the provided data packet was sent (optional)
+     * 
+     *  \return Indicates whether the data packet was enqueued for transmission
+     */
+    bool Send(const HdlcdPacketData& a_PacketData, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        return ((m_DataSender) && (m_DataSender(a_PacketData, a_OnSendDoneCallback)));
+    }
+
+    /*! \brief  Send a control packet via the shared session
+     * 
+     *  \param  a_PacketCtrl the control packet to be transmitted
+     *  \param  a_OnSendDoneCallback the callback handler to be called if the provided control packet was sent (optional)
+     * 
+     *  \return Indicates whether the control packet was enqueued for transmission
+     */
+    bool Send(const HdlcdPacketCtrl& a_PacketCtrl, std::function<void()> a_OnSendDoneCallback = nullptr) {
+        return ((m_CtrlSender) && (m_CtrlSender(a_PacketCtrl, a_OnSendDoneCallback)));
+    }
+
+    /*! \brief  Query the number of data packets waiting in the queue
+     * 
+     *  \return The number of data packets waiting in the queue
+     */
+    size_t GetQueueSize() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_Queue.size();
+    }
+
+    /*! \brief  Query the number of data packets delivered to the queue
+     * 
+     *  \return The number of data packets delivered to the queue
+     */
+    uint64_t GetDeliveredPackets() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_DeliveredPackets;
+    }
+
+    /*! \brief  Query the number of data packets dropped because the queue was full
+     * 
+     *  \return The number of dropped data packets
+     */
+    uint64_t GetDroppedPackets() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_DroppedPackets;
+    }
+
+    /*! \brief  Query whether the shared session was closed
+     * 
+     *  \return Indicates whether the shared session was closed
+     */
+    bool IsClosed() const {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_bClosed;
+    }
+
+private:
+    friend class HdlcdClientHub;
+
+    /*! \brief  Enqueue a data packet, called by HdlcdClientHub
+     * 
+     *  \param  a_PacketData the received data packet
+     */
+    void DeliverData(const std::shared_ptr<const HdlcdPacketData>& a_PacketData) {
+        bool l_bWasEmpty = false;
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            if (m_Queue.size() >= m_QueueLimit) {
+                ++m_DroppedPackets;
+                return;
+            } // if
+
+            l_bWasEmpty = m_Queue.empty();
+            m_Queue.push_back(a_PacketData);
+            ++m_DeliveredPackets;
+        }
+
+        if ((l_bWasEmpty) && (m_OnDataCallback)) {
+            m_OnDataCallback();
+        } // if
+    }
+
+    /*! \brief  Deliver a control packet, called by HdlcdClientHub
+     * 
+     *  \param  a_PacketCtrl the received control packet
+     */
+    void DeliverCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+        if (m_OnCtrlCallback) {
+            m_OnCtrlCallback(a_PacketCtrl);
+        } // if
+    }
+
+    /*! \brief  Report that the shared session was closed, called by HdlcdClientHub
+     */
+    void DeliverClosed() {
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            if (m_bClosed) {
+                return;
+            } // if
+
+            m_bClosed = true;
+        }
+
+        m_DataSender = nullptr;
+        m_CtrlSender = nullptr;
+        if (m_OnClosedCallback) {
+            m_OnClosedCallback();
+        } // if
+    }
+
+    // Members
+    mutable std::mutex m_Mutex; //!< Protects the queue, the counters, and the closed flag
+    const size_t m_QueueLimit;
+    std::deque<std::shared_ptr<const HdlcdPacketData>> m_Queue;
+    uint64_t m_DeliveredPackets;
+    uint64_t m_DroppedPackets;
+    bool m_bClosed;
+    std::function<void()> m_OnDataCallback;
+    std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> m_OnCtrlCallback;
+    std::function<void()> m_OnClosedCallback;
+    std::function<bool(const HdlcdPacketData&, std::function<void()>)> m_DataSender; //!< Sends via the shared session
+    std::function<bool(const HdlcdPacketCtrl&, std::function<void()>)> m_CtrlSender; //!< Sends via the shared session
+};
+
+#endif // HDLCD_HUB_SUBSCRIPTION_H
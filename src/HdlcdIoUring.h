@@ -0,0 +1,69 @@
+/**
+ * \file      HdlcdIoUring.h
+ * \brief     This file contains the selection of the io_uring backend of boost::asio
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_IO_URING_H
+#define HDLCD_IO_URING_H
+
+// Opt-in: define HDLCD_ENABLE_IO_URING for all translation units of a program, e.g., via
+// "add_compile_definitions(HDLCD_ENABLE_IO_URING)" in CMake, to run all TCP sockets of the HDLCd entities on the io_uring
+// backend of boost::asio instead of the epoll reactor. This requires Linux, boost 1.78 or newer, and liburing; link with
+// "-luring". All HDLCd headers include this header before any boost::asio header; a translation unit including boost::asio
+// first, or a mismatching setting among translation units, violates the one definition rule.
+//
+// Only the backend is switched. Registered buffers and multishot receives are not used, as the socket I/O is done by
+// FrameEndpoint of the framing library, and the effect has not been measured by a benchmark.
+
+#ifdef HDLCD_ENABLE_IO_URING
+#include <boost/version.hpp>
+#if !defined(__linux__)
+#error "HDLCD_ENABLE_IO_URING requires Linux"
+#elif (BOOST_VERSION < 107800)
+#error "HDLCD_ENABLE_IO_URING requires boost 1.78 or newer"
+#endif
+#if defined(BOOST_ASIO_HPP) && !defined(BOOST_ASIO_HAS_IO_URING)
+#error "HDLCD_ENABLE_IO_URING: boost::asio was included before HdlcdIoUring.h without BOOST_ASIO_HAS_IO_URING"
+#endif
+#ifndef BOOST_ASIO_HAS_IO_URING
+#define BOOST_ASIO_HAS_IO_URING 1
+#endif
+#ifndef BOOST_ASIO_DISABLE_EPOLL
+#define BOOST_ASIO_DISABLE_EPOLL 1
+#endif
+#endif // HDLCD_ENABLE_IO_URING
+
+#endif // HDLCD_IO_URING_H
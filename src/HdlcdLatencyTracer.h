@@ -0,0 +1,118 @@
+/**
+ * \file      HdlcdLatencyTracer.h
+ * \brief     This file contains the header declaration of class HdlcdLatencyTracer
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_LATENCY_TRACER_H
+#define HDLCD_LATENCY_TRACER_H
+
+// Define HDLCD_ENABLE_LATENCY_TRACING before including any HDLCd header to enable per-packet latency tracing.
+// If it is not defined, all tracing code is removed at compile time.
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+
+#include <chrono>
+#include "HdlcdHistogram.h"
+
+/*! \enum E_LATENCY_STAGE
+ *  \brief The enum E_LATENCY_STAGE to specify the stages a packet passes on its way through a client entity
+ */
+typedef enum {
+    LATENCY_STAGE_TX_QUEUE       = 0, //!< From HdlcdClient::Send() to serialization, only for data packets held back by the pacer
+    LATENCY_STAGE_TX_SERIALIZE   = 1, //!< Serialization and handover to the send queue of the frame endpoint
+    LATENCY_STAGE_TX_WRITE       = 2, //!< From serialization to completion of the socket write, includes the serialization
+    LATENCY_STAGE_RX_READ        = 3, //!< From reception of the packet header to reception of the complete packet
+    LATENCY_STAGE_RX_DESERIALIZE = 4, //!< From the completely read packet to the packet endpoint
+    LATENCY_STAGE_RX_DELIVER     = 5, //!< Execution of the callback of the user
+    
+    // Book keeping
+    LATENCY_STAGE_ARITHMETIC_ENDMARKER = 6 //!< The number of stages
+} E_LATENCY_STAGE;
+
+/*! \class HdlcdLatencyTracer
+ *  \brief Class HdlcdLatencyTracer
+ * 
+ *  Collects per-stage latency histograms of the packets passing a client entity, in nanoseconds
+ */
+class HdlcdLatencyTracer {
+public:
+    /*! \brief  The type of timestamps taken at the boundaries of the stages
+     */
+    typedef std::chrono::steady_clock::time_point Timestamp;
+
+    /*! \brief  Take a timestamp
+     * 
+     *  \return The current timestamp
+     */
+    static Timestamp Now() {
+        return std::chrono::steady_clock::now();
+    }
+
+    /*! \brief  Record the latency of a single stage
+     * 
+     *  \param  a_eStage the stage
+     *  \param  a_Begin the timestamp taken when the packet entered the stage
+     *  \param  a_End the timestamp taken when the packet left the stage
+     */
+    void Record(E_LATENCY_STAGE a_eStage, Timestamp a_Begin, Timestamp a_End) {
+        m_Histograms[a_eStage].Add(std::chrono::duration_cast<std::chrono::nanoseconds>(a_End - a_Begin).count());
+    }
+
+    /*! \brief  Query the latency histogram of a single stage
+     * 
+     *  \param  a_eStage the stage
+     * 
+     *  \return The latency histogram of the specified stage, in nanoseconds
+     */
+    const HdlcdHistogram& GetHistogram(E_LATENCY_STAGE a_eStage) const {
+        return m_Histograms[a_eStage];
+    }
+
+    /*! \brief  Remove all collected samples of all stages
+     */
+    void Reset() {
+        for (unsigned int l_Index = 0; l_Index < LATENCY_STAGE_ARITHMETIC_ENDMARKER; ++l_Index) {
+            m_Histograms[l_Index].Reset();
+        } // for
+    }
+
+private:
+    // Members
+    HdlcdHistogram m_Histograms[LATENCY_STAGE_ARITHMETIC_ENDMARKER]; //!< One latency histogram per stage
+};
+
+#endif // HDLCD_ENABLE_LATENCY_TRACING
+
+#endif // HDLCD_LATENCY_TRACER_H
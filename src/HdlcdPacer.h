@@ -0,0 +1,144 @@
+/**
+ * \file      HdlcdPacer.h
+ * \brief     This file contains the header declaration of class HdlcdPacer
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PACER_H
+#define HDLCD_PACER_H
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdint.h>
+
+/*! \class HdlcdPacer
+ *  \brief Class HdlcdPacer
+ *
+ *  A token bucket that estimates how fast the serial line behind the HDLCd is able to drain data packets. The bucket is
+ *  refilled with the configured baud rate and each data packet consumes the number of bits it occupies on the serial line,
+ *  including the HDLC framing overhead and the octets added by byte stuffing. The bucket may run into debt, thus packets
+ *  larger than the bucket depth are released as well, but all subsequent packets have to wait until the debt is paid.
+ */
+class HdlcdPacer {
+public:
+    /*! \brief  The constructor of HdlcdPacer objects
+     *
+     *  A newly created pacer is disabled and releases all data packets immediately
+     */
+    HdlcdPacer(): m_BitsPerSecond(0), m_BitsPerOctet(10), m_FramingOverhead(6), m_BucketDepth(0), m_Tokens(0) {
+    }
+
+    /*! \brief  Configure the line rate of the serial line
+     *
+     *  \param  a_BitsPerSecond the baud rate of the serial line in bits per second, zero disables the pacer
+     *  \param  a_BitsPerOctet the number of bits each octet occupies on the serial line, e.g., 10 for 8N1
+     *  \param  a_FramingOverhead the number of octets added per HDLC frame: flags, address, control, and FCS
+     *  \param  a_BurstOctets the number of octets that may be released back-to-back after the line was idle
+     */
+    void Configure(uint32_t a_BitsPerSecond, uint32_t a_BitsPerOctet = 10, uint32_t a_FramingOverhead = 6, uint32_t a_BurstOctets = 64) {
+        m_BitsPerSecond   = a_BitsPerSecond;
+        m_BitsPerOctet    = a_BitsPerOctet;
+        m_FramingOverhead = a_FramingOverhead;
+        m_BucketDepth     = (int64_t(a_BurstOctets) * a_BitsPerOctet * 1000000);
+        m_Tokens          = m_BucketDepth;
+        m_LastRefill      = std::chrono::steady_clock::now();
+    }
+
+    /*! \brief  Query whether the pacer is enabled
+     *
+     *  \retval true the pacer is enabled
+     *  \retval false the pacer is disabled and all data packets are released immediately
+     *  \return Indicates whether the pacer is enabled
+     */
+    bool IsEnabled() const {
+        return (m_BitsPerSecond != 0);
+    }
+
+    /*! \brief  Query the time to wait until the next data packet may be released
+     *
+     *  \param  a_Now the current point in time
+     *
+     *  \return The time to wait, zero if the next data packet may be released immediately
+     */
+    std::chrono::microseconds GetDelay(std::chrono::steady_clock::time_point a_Now) {
+        Refill(a_Now);
+        if (m_Tokens >= 0) {
+            return std::chrono::microseconds(0);
+        } // if
+
+        // Round up to avoid waking up too early
+        return std::chrono::microseconds(((-m_Tokens) + m_BitsPerSecond - 1) / m_BitsPerSecond);
+    }
+
+    /*! \brief  Account for a data packet that was released
+     *
+     *  \param  a_Payload the payload of the released data packet
+     */
+    void Consume(const std::vector<unsigned char>& a_Payload) {
+        // Each flag or escape octet in the payload is transmitted as two octets on the serial line
+        int64_t l_Octets = (a_Payload.size() + m_FramingOverhead);
+        l_Octets += std::count_if(a_Payload.begin(), a_Payload.end(), [](unsigned char a_Octet) { return ((a_Octet == 0x7E) || (a_Octet == 0x7D)); });
+        m_Tokens -= (l_Octets * m_BitsPerOctet * 1000000);
+    }
+
+private:
+    /*! \brief  Refill the token bucket according to the elapsed time
+     *
+     *  \param  a_Now the current point in time
+     */
+    void Refill(std::chrono::steady_clock::time_point a_Now) {
+        if (a_Now <= m_LastRefill) {
+            return;
+        } // if
+
+        int64_t l_Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(a_Now - m_LastRefill).count();
+        m_LastRefill = a_Now;
+
+        // Limit the elapsed time to avoid overflows after long idle periods
+        const int64_t l_MaxElapsed = (((m_BucketDepth - m_Tokens) / m_BitsPerSecond) + 1);
+        m_Tokens = std::min(m_BucketDepth, (m_Tokens + (std::min(l_Elapsed, l_MaxElapsed) * m_BitsPerSecond)));
+    }
+
+    // Members
+    int64_t  m_BitsPerSecond;   //!< The line rate of the serial line in bits per second, zero if disabled
+    int64_t  m_BitsPerOctet;    //!< The number of bits each octet occupies on the serial line
+    int64_t  m_FramingOverhead; //!< The number of octets added by the HDLC framing of each data packet
+    int64_t  m_BucketDepth;     //!< The maximum amount of tokens, in units of microbits
+    int64_t  m_Tokens;          //!< The current amount of tokens, in units of microbits, negative if in debt
+    std::chrono::steady_clock::time_point m_LastRefill; //!< The point in time of the last refill
+};
+
+#endif // HDLCD_PACER_H
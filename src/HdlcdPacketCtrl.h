@@ -38,7 +38,14 @@
 #define HDLCD_PACKET_CTRL_H
 
 #include "HdlcdPacket.h"
+#include "HdlcdPortPattern.h"
+#include "HdlcdPortStatistics.h"
+#include "HdlcdWireSchema.h"
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 class HdlcdPacketCtrl: public HdlcdPacket {
 public:
@@ -48,6 +55,8 @@ public:
         CTRL_TYPE_ECHO        = 0x10,
         CTRL_TYPE_KEEP_ALIVE  = 0x20,
         CTRL_TYPE_PORT_KILL   = 0x30,
+        CTRL_TYPE_PORT_STATISTICS = 0x40,
+        CTRL_TYPE_PORT_TABLE  = 0x50,
         CTRL_TYPE_UNSET       = 0xFF
     } E_CTRL_TYPE;
 
@@ -55,7 +64,7 @@ public:
         // Called on reception: evaluate type field
         auto l_PacketCtrl(std::shared_ptr<HdlcdPacketCtrl>(new HdlcdPacketCtrl));
         l_PacketCtrl->m_eDeserialize   = DESERIALIZE_BODY; // Next: read body including the packet type byte
-        l_PacketCtrl->m_BytesRemaining = 2;
+        l_PacketCtrl->m_BytesRemaining = HeaderLayout::SIZE;
         return l_PacketCtrl;
     }
     
@@ -94,6 +103,29 @@ public:
         return l_PacketCtrl;
     }
     
+    static HdlcdPacketCtrl CreatePortStatisticsRequest() {
+        HdlcdPacketCtrl l_PacketCtrl;
+        l_PacketCtrl.m_eCtrlType = CTRL_TYPE_PORT_STATISTICS;
+        return l_PacketCtrl;
+    }
+    
+    static HdlcdPacketCtrl CreatePortStatisticsResponse(const HdlcdPortStatistics& a_PortStatistics) {
+        HdlcdPacketCtrl l_PacketCtrl;
+        l_PacketCtrl.m_eCtrlType = CTRL_TYPE_PORT_STATISTICS;
+        l_PacketCtrl.m_bIsResponse = true;
+        l_PacketCtrl.m_PortStatistics = a_PortStatistics;
+        return l_PacketCtrl;
+    }
+    
+    // Sent by the HDLCd on the data socket of multi-port sessions, maps port indices of data packets to port names.
+    // Port names longer than HdlcdPortPattern::MAX_LENGTH are not transmitted, their data packets cannot be resolved.
+    static HdlcdPacketCtrl CreatePortTable(const std::vector<std::pair<uint8_t, std::string>>& a_PortTable) {
+        HdlcdPacketCtrl l_PacketCtrl;
+        l_PacketCtrl.m_eCtrlType = CTRL_TYPE_PORT_TABLE;
+        l_PacketCtrl.m_PortTable = a_PortTable;
+        return l_PacketCtrl;
+    }
+    
     // Getters
     E_CTRL_TYPE GetPacketType() const {
         assert(m_eDeserialize == DESERIALIZE_FULL);
@@ -124,12 +156,46 @@ public:
         return m_bLockSerialPort;
     }
 
+    bool GetIsPortStatisticsResponse() const {
+        assert(m_eCtrlType == CTRL_TYPE_PORT_STATISTICS);
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_bIsResponse;
+    }
+
+    const HdlcdPortStatistics& GetPortStatistics() const {
+        assert(m_eCtrlType == CTRL_TYPE_PORT_STATISTICS);
+        assert(m_bIsResponse);
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_PortStatistics;
+    }
+
+    const std::vector<std::pair<uint8_t, std::string>>& GetPortTable() const {
+        assert(m_eCtrlType == CTRL_TYPE_PORT_TABLE);
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_PortTable;
+    }
+
 private:
     // Private CTOR
-    HdlcdPacketCtrl(): m_bAlive(false), m_bLockedByOthers(false), m_bLockedBySelf(false), m_bLockSerialPort(false),
+    HdlcdPacketCtrl(): m_bAlive(false), m_bLockedByOthers(false), m_bLockedBySelf(false), m_bLockSerialPort(false), m_bIsResponse(false),
                        m_eCtrlType(CTRL_TYPE_UNSET), m_eDeserialize(DESERIALIZE_FULL) {
     }
     
+    // The wire format: the fixed-size header, with a layout of the control octet per type of control packet
+    typedef HdlcdWireField<0, 1>   HeaderPacketType;
+    typedef HdlcdWireBits<1, 0xF0> HeaderCtrlType;
+    typedef HdlcdWireLayout<HeaderPacketType, HeaderCtrlType> HeaderLayout;
+    typedef HdlcdWireFlag<1, 0x04> PortStatusAlive;
+    typedef HdlcdWireFlag<1, 0x02> PortStatusLockedByOthers;
+    typedef HdlcdWireFlag<1, 0x01> PortStatusLocked; // Locked by self in responses, lock requested in requests
+    typedef HdlcdWireLayout<HeaderPacketType, HeaderCtrlType, PortStatusAlive, PortStatusLockedByOthers, PortStatusLocked> PortStatusLayout;
+    typedef HdlcdWireFlag<1, 0x01> PortStatisticsIsResponse;
+    typedef HdlcdWireLayout<HeaderPacketType, HeaderCtrlType, PortStatisticsIsResponse> PortStatisticsLayout;
+    typedef HdlcdWireField<0, 2>   BodyLength;
+    typedef HdlcdWireLayout<BodyLength> BodyLengthLayout;
+    static_assert(((PortStatusLayout::SIZE == HeaderLayout::SIZE) && (PortStatisticsLayout::SIZE == HeaderLayout::SIZE)),
+                  "The layouts of the control octet must not extend the fixed-size header");
+
     // Internal helpers
     E_HDLCD_PACKET GetHdlcdPacketType() const { return HDLCD_PACKET_CTRL; }
 
@@ -137,32 +203,52 @@ private:
     const std::vector<unsigned char> Serialize() const {
         assert(m_eDeserialize == DESERIALIZE_FULL);
         std::vector<unsigned char> l_Buffer;
-        l_Buffer.emplace_back(0x10);
         
-        // Prepare control field
-        unsigned char l_Control = 0x00;
+        // Prepare the packet type and the control field, the types of control packets are the values on the wire
+        unsigned char* l_Header = HeaderLayout::Append(l_Buffer);
+        HeaderLayout::Encode<HeaderPacketType>(l_Header, HDLCD_PACKET_CTRL);
+        HeaderLayout::Encode<HeaderCtrlType>(l_Header, m_eCtrlType);
         switch (m_eCtrlType) {
             case CTRL_TYPE_PORT_STATUS:
-                l_Control = 0x00;
-                if (m_bAlive)          { l_Control |= 0x04; }
-                if (m_bLockedByOthers) { l_Control |= 0x02; }
-                if (m_bLockedBySelf)   { l_Control |= 0x01; }
-                if (m_bLockSerialPort) { l_Control |= 0x01; } // for requests
+                PortStatusLayout::Encode<PortStatusAlive>(l_Header, m_bAlive);
+                PortStatusLayout::Encode<PortStatusLockedByOthers>(l_Header, m_bLockedByOthers);
+                PortStatusLayout::Encode<PortStatusLocked>(l_Header, (m_bLockedBySelf || m_bLockSerialPort)); // for responses and requests
                 break;
             case CTRL_TYPE_ECHO:
-                l_Control = 0x10;
-                break;
             case CTRL_TYPE_KEEP_ALIVE:
-                l_Control = 0x20;
-                break;
             case CTRL_TYPE_PORT_KILL:
-                l_Control = 0x30;
+            case CTRL_TYPE_PORT_TABLE:
+                break;
+            case CTRL_TYPE_PORT_STATISTICS:
+                PortStatisticsLayout::Encode<PortStatisticsIsResponse>(l_Header, m_bIsResponse);
                 break;
             default:
                 assert(false);
         } // switch
 
-        l_Buffer.emplace_back(l_Control);
+        if ((m_eCtrlType == CTRL_TYPE_PORT_STATISTICS) && (m_bIsResponse)) {
+            // Fixed-sized body
+            m_PortStatistics.Serialize(l_Buffer);
+        } // if
+
+        if (m_eCtrlType == CTRL_TYPE_PORT_TABLE) {
+            // Length-prefixed body: a sequence of port index, length of the port name, and the port name. Overlong names are
+            // skipped instead of truncated, as are entries not fitting into the body length anymore.
+            std::vector<unsigned char> l_Body;
+            for (auto l_Entry = m_PortTable.begin(); l_Entry != m_PortTable.end(); ++l_Entry) {
+                if ((l_Entry->second.size() > HdlcdPortPattern::MAX_LENGTH) || ((l_Body.size() + 2 + l_Entry->second.size()) > 0xFFFF)) {
+                    continue;
+                } // if
+
+                l_Body.emplace_back(l_Entry->first);
+                l_Body.emplace_back(static_cast<unsigned char>(l_Entry->second.size()));
+                l_Body.insert(l_Body.end(), l_Entry->second.begin(), l_Entry->second.end());
+            } // for
+
+            BodyLengthLayout::Encode<BodyLength>(BodyLengthLayout::Append(l_Buffer), l_Body.size());
+            l_Buffer.insert(l_Buffer.end(), l_Body.begin(), l_Body.end());
+        } // if
+
         return l_Buffer;
     }
     
@@ -171,44 +257,70 @@ private:
         // All requested bytes are available
         switch (m_eDeserialize) {
         case DESERIALIZE_BODY: {
-            // Deserialize the control byte
-            assert(m_Buffer.size() == 2);
-            if (m_Buffer[0] != HDLCD_PACKET_CTRL) {
+            // Deserialize the packet type and the control byte
+            assert(m_Buffer.size() == HeaderLayout::SIZE);
+            unsigned char l_Header[HeaderLayout::SIZE];
+            std::copy(m_Buffer.begin(), m_Buffer.end(), l_Header);
+            m_Buffer.clear();
+            if (HeaderLayout::Decode<HeaderPacketType>(l_Header) != HDLCD_PACKET_CTRL) {
                 // Wrong control field
                 m_eDeserialize = DESERIALIZE_ERROR;
                 return false;
             } // if
 
-            const unsigned char &l_Control = m_Buffer[1];
-            m_Buffer.clear();
-            switch (l_Control & 0xF0) {
-            case 0x00: {
+            switch (HeaderLayout::Decode<HeaderCtrlType>(l_Header)) {
+            case CTRL_TYPE_PORT_STATUS: {
                 m_eCtrlType = CTRL_TYPE_PORT_STATUS;
                 // For both requests and responses
-                if (l_Control & 0x08) {
+                if (PortStatusLayout::HasReservedBits(l_Header)) {
                     // The reserved bit was set... abort
                     m_eDeserialize = DESERIALIZE_ERROR;
                     return false;
                 } // if
 
-                m_bAlive          = (l_Control & 0x04);
-                m_bLockedByOthers = (l_Control & 0x02);
-                m_bLockedBySelf   = (l_Control & 0x01);
-                m_bLockSerialPort = (l_Control & 0x01); // for requests
+                m_bAlive          = PortStatusLayout::Decode<PortStatusAlive>(l_Header);
+                m_bLockedByOthers = PortStatusLayout::Decode<PortStatusLockedByOthers>(l_Header);
+                m_bLockedBySelf   = PortStatusLayout::Decode<PortStatusLocked>(l_Header);
+                m_bLockSerialPort = PortStatusLayout::Decode<PortStatusLocked>(l_Header); // for requests
                 break;
             }
-            case 0x10: {
+            case CTRL_TYPE_ECHO: {
                 m_eCtrlType = CTRL_TYPE_ECHO;
                 break;
             }
-            case 0x20: {
+            case CTRL_TYPE_KEEP_ALIVE: {
                 m_eCtrlType = CTRL_TYPE_KEEP_ALIVE;
                 break;
             }
-            case 0x30: {
+            case CTRL_TYPE_PORT_KILL: {
                 m_eCtrlType = CTRL_TYPE_PORT_KILL;
                 break;
             }
+            case CTRL_TYPE_PORT_STATISTICS: {
+                m_eCtrlType = CTRL_TYPE_PORT_STATISTICS;
+                if (PortStatisticsLayout::HasReservedBits(l_Header)) {
+                    // A reserved bit was set... abort
+                    m_eDeserialize = DESERIALIZE_ERROR;
+                    return false;
+                } // if
+
+                m_bIsResponse = PortStatisticsLayout::Decode<PortStatisticsIsResponse>(l_Header);
+                if (m_bIsResponse) {
+                    // The counters follow
+                    m_eDeserialize = DESERIALIZE_FIXED_BODY;
+                    m_BytesRemaining = HdlcdPortStatistics::SIZE;
+                    return true;
+                } // if
+
+                break;
+            }
+            case CTRL_TYPE_PORT_TABLE: {
+                // A length-prefixed body follows
+                m_eCtrlType = CTRL_TYPE_PORT_TABLE;
+                m_eDeserialize = DESERIALIZE_BODY_LENGTH;
+                m_BytesRemaining = BodyLengthLayout::SIZE;
+                return true;
+            }
             default:
                 m_eDeserialize = DESERIALIZE_ERROR;
                 return false;
@@ -218,6 +330,33 @@ private:
             m_eDeserialize = DESERIALIZE_FULL;
             break;
         }
+        case DESERIALIZE_FIXED_BODY: {
+            // Read of the counters completed
+            assert(m_Buffer.size() == HdlcdPortStatistics::SIZE);
+            m_PortStatistics.Deserialize(m_Buffer.data());
+            m_Buffer.clear();
+            m_eDeserialize = DESERIALIZE_FULL;
+            break;
+        }
+        case DESERIALIZE_BODY_LENGTH: {
+            // Deserialize the length field of the variable-sized body
+            assert(m_Buffer.size() == BodyLengthLayout::SIZE);
+            m_BytesRemaining = BodyLengthLayout::Decode<BodyLength>(m_Buffer.data());
+            m_Buffer.clear();
+            m_eDeserialize = (m_BytesRemaining ? DESERIALIZE_VARIABLE_BODY : DESERIALIZE_FULL);
+            break;
+        }
+        case DESERIALIZE_VARIABLE_BODY: {
+            // Read of the variable-sized body completed
+            if (!DeserializePortTable()) {
+                m_eDeserialize = DESERIALIZE_ERROR;
+                return false;
+            } // if
+
+            m_Buffer.clear();
+            m_eDeserialize = DESERIALIZE_FULL;
+            break;
+        }
         case DESERIALIZE_ERROR:
         case DESERIALIZE_FULL:
         default:
@@ -228,17 +367,45 @@ private:
         return true;
     }
 
+    // Parse the body of a port table
+    bool DeserializePortTable() {
+        size_t l_Offset = 0;
+        while (l_Offset < m_Buffer.size()) {
+            if ((m_Buffer.size() - l_Offset) < 2) {
+                return false;
+            } // if
+
+            const uint8_t l_PortIndex = m_Buffer[l_Offset];
+            const size_t l_NameLength = m_Buffer[l_Offset + 1];
+            l_Offset += 2;
+            if ((m_Buffer.size() - l_Offset) < l_NameLength) {
+                return false;
+            } // if
+
+            m_PortTable.emplace_back(l_PortIndex, std::string(m_Buffer.begin() + l_Offset, m_Buffer.begin() + l_Offset + l_NameLength));
+            l_Offset += l_NameLength;
+        } // while
+
+        return true;
+    }
+
     // Members
     bool m_bAlive;
     bool m_bLockedByOthers;
     bool m_bLockedBySelf;
     bool m_bLockSerialPort;
+    bool m_bIsResponse;
+    HdlcdPortStatistics m_PortStatistics;
+    std::vector<std::pair<uint8_t, std::string>> m_PortTable;
     
     E_CTRL_TYPE m_eCtrlType;
     typedef enum {
         DESERIALIZE_ERROR = 0,
         DESERIALIZE_BODY  = 1,
-        DESERIALIZE_FULL  = 2
+        DESERIALIZE_FULL  = 2,
+        DESERIALIZE_BODY_LENGTH   = 3,
+        DESERIALIZE_VARIABLE_BODY = 4,
+        DESERIALIZE_FIXED_BODY    = 5
     } E_DESERIALIZE;
     E_DESERIALIZE m_eDeserialize;
 };
@@ -38,6 +38,8 @@
 #define HDLCD_PACKET_DATA_H
 
 #include "HdlcdPacket.h"
+#include "HdlcdLatencyTracer.h"
+#include "HdlcdWireSchema.h"
 #include <memory>
 
 class HdlcdPacketData: public HdlcdPacket {
@@ -52,11 +54,22 @@ public:
         return l_PacketData;
     }
 
+    static const size_t MAX_PORT_INDEX = 0xFF; //!< Port indices are carried in a single octet
+
+    static HdlcdPacketData CreatePortPacket(size_t a_PortIndex, std::vector<unsigned char> a_Payload, bool a_bReliable, bool a_bInvalid = false, bool a_bWasSent = false) {
+        // Called for transmission via multi-port sessions, the port index must not exceed MAX_PORT_INDEX
+        assert(a_PortIndex <= MAX_PORT_INDEX);
+        HdlcdPacketData l_PacketData(CreatePacket(std::move(a_Payload), a_bReliable, a_bInvalid, a_bWasSent));
+        l_PacketData.m_bHasPortIndex = true;
+        l_PacketData.m_PortIndex = static_cast<uint8_t>(a_PortIndex);
+        return l_PacketData;
+    }
+
     static std::shared_ptr<HdlcdPacketData> CreateDeserializedPacket() {
         // Called on reception: evaluate type field
         auto l_PacketData(std::shared_ptr<HdlcdPacketData>(new HdlcdPacketData));
         l_PacketData->m_eDeserialize = DESERIALIZE_HEADER; // Next: read header including the packet type byte
-        l_PacketData->m_BytesRemaining = 3;
+        l_PacketData->m_BytesRemaining = HeaderLayout::SIZE;
         return l_PacketData;
     }
     
@@ -79,12 +92,69 @@ public:
         assert(m_eDeserialize == DESERIALIZE_FULL);
         return m_bWasSent;
     }
+
+    // Only present on multi-port sessions, see the port table of HdlcdPacketCtrl
+    bool HasPortIndex() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_bHasPortIndex;
+    }
+
+    uint8_t GetPortIndex() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_PortIndex;
+    }
+
+    // Only present on sessions with sequence numbers, assigned by the HDLCd per session and incremented per data packet
+    void SetSequenceNumber(uint32_t a_SequenceNumber) {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        m_bHasSequenceNumber = true;
+        m_SequenceNumber = a_SequenceNumber;
+    }
+
+    bool HasSequenceNumber() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_bHasSequenceNumber;
+    }
+
+    uint32_t GetSequenceNumber() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_SequenceNumber;
+    }
+
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    HdlcdLatencyTracer::Timestamp GetReadTimestamp() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_ReadTimestamp;
+    }
+
+    HdlcdLatencyTracer::Timestamp GetDeserializedTimestamp() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_DeserializedTimestamp;
+    }
+#endif // HDLCD_ENABLE_LATENCY_TRACING
     
 private:
     // Private CTOR
-    HdlcdPacketData(): m_bReliable(false), m_bInvalid(false), m_bWasSent(false), m_eDeserialize(DESERIALIZE_FULL) {
+    HdlcdPacketData(): m_bReliable(false), m_bInvalid(false), m_bWasSent(false), m_bHasPortIndex(false), m_PortIndex(0),
+                     m_bHasSequenceNumber(false), m_SequenceNumber(0), m_PayloadLength(0), m_eDeserialize(DESERIALIZE_FULL) {
     }
     
+    // The wire format: the fixed-size header, the optional extension octet, and the optional fields announced by it
+    typedef HdlcdWireBits<0, 0xF0> HeaderPacketType;
+    typedef HdlcdWireFlag<0, 0x08> HeaderHasExtension;
+    typedef HdlcdWireFlag<0, 0x04> HeaderReliable;
+    typedef HdlcdWireFlag<0, 0x02> HeaderInvalid;
+    typedef HdlcdWireFlag<0, 0x01> HeaderWasSent;
+    typedef HdlcdWireField<1, 2>   HeaderPayloadLength;
+    typedef HdlcdWireLayout<HeaderPacketType, HeaderHasExtension, HeaderReliable, HeaderInvalid, HeaderWasSent, HeaderPayloadLength> HeaderLayout;
+    typedef HdlcdWireFlag<0, 0x01> ExtensionPortIndex;
+    typedef HdlcdWireFlag<0, 0x02> ExtensionSequenceNumber;
+    typedef HdlcdWireLayout<ExtensionPortIndex, ExtensionSequenceNumber> ExtensionLayout;
+    typedef HdlcdWireField<0, 1>   PortIndexValue;
+    typedef HdlcdWireLayout<PortIndexValue> PortIndexLayout;
+    typedef HdlcdWireField<0, 4>   SequenceNumberValue;
+    typedef HdlcdWireLayout<SequenceNumberValue> SequenceNumberLayout;
+
     // Internal helpers
     E_HDLCD_PACKET GetHdlcdPacketType() const { return HDLCD_PACKET_DATA; }
 
@@ -92,17 +162,29 @@ private:
     const std::vector<unsigned char> Serialize() const {
         assert(m_eDeserialize == DESERIALIZE_FULL);
         std::vector<unsigned char> l_Buffer;
+        l_Buffer.reserve(HeaderLayout::SIZE + ExtensionLayout::SIZE + PortIndexLayout::SIZE + SequenceNumberLayout::SIZE + m_Buffer.size());
         
-        // Prepare type field
-        unsigned char l_Type = 0x00;
-        if (m_bReliable) { l_Type |= 0x04; }
-        if (m_bInvalid)  { l_Type |= 0x02; }
-        if (m_bWasSent)  { l_Type |= 0x01; }
-        l_Buffer.emplace_back(l_Type);
+        // Prepare the fixed-size header
+        const unsigned char l_Extension = GetExtension();
+        unsigned char* l_Header = HeaderLayout::Append(l_Buffer);
+        HeaderLayout::Encode<HeaderPacketType>(l_Header, HDLCD_PACKET_DATA);
+        HeaderLayout::Encode<HeaderHasExtension>(l_Header, (l_Extension != 0x00));
+        HeaderLayout::Encode<HeaderReliable>(l_Header, m_bReliable);
+        HeaderLayout::Encode<HeaderInvalid>(l_Header, m_bInvalid);
+        HeaderLayout::Encode<HeaderWasSent>(l_Header, m_bWasSent);
+        HeaderLayout::Encode<HeaderPayloadLength>(l_Header, m_Buffer.size());
         
-        // Prepare length field
-        l_Buffer.emplace_back((m_Buffer.size() >> 8) & 0xFF);
-        l_Buffer.emplace_back((m_Buffer.size() >> 0) & 0xFF);
+        // Prepare the optional extension octet and the fields announced by it
+        if (l_Extension) {
+            l_Buffer.emplace_back(l_Extension);
+            if (m_bHasPortIndex) {
+                PortIndexLayout::Encode<PortIndexValue>(PortIndexLayout::Append(l_Buffer), m_PortIndex);
+            } // if
+
+            if (m_bHasSequenceNumber) {
+                SequenceNumberLayout::Encode<SequenceNumberValue>(SequenceNumberLayout::Append(l_Buffer), m_SequenceNumber);
+            } // if
+        } // if
         
         // Add payload
         l_Buffer.insert(l_Buffer.end(), m_Buffer.begin(), m_Buffer.end());
@@ -114,36 +196,73 @@ private:
         // All requested bytes are available
         switch (m_eDeserialize) {
         case DESERIALIZE_HEADER: {
-            // Deserialize the length field
-            assert(m_Buffer.size() == 3);
+            // Deserialize the fixed-size header
+            assert(m_Buffer.size() == HeaderLayout::SIZE);
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            m_ReadTimestamp = HdlcdLatencyTracer::Now();
+#endif
+
+            // Deserialize the control byte and the length field
+            const unsigned char* l_Header = m_Buffer.data();
+            m_bReliable = HeaderLayout::Decode<HeaderReliable>(l_Header);
+            m_bInvalid  = HeaderLayout::Decode<HeaderInvalid>(l_Header);
+            m_bWasSent  = HeaderLayout::Decode<HeaderWasSent>(l_Header);
+            m_PayloadLength = HeaderLayout::Decode<HeaderPayloadLength>(l_Header);
+            const bool l_bHasExtension = HeaderLayout::Decode<HeaderHasExtension>(l_Header);
+            m_Buffer.clear();
+            if (l_bHasExtension) {
+                // The extension octet follows
+                m_eDeserialize = DESERIALIZE_EXTENSION;
+                m_BytesRemaining = ExtensionLayout::SIZE;
+            } else {
+                ExpectBody();
+            } // else
 
-            // Deserialize the control byte
-            const unsigned char &l_Control = m_Buffer[0];
-            if (l_Control & 0x08) {
-                // The reserved bit was set... abort
+            break;
+        }
+        case DESERIALIZE_EXTENSION: {
+            // Deserialize the extension octet, which announces further fields
+            assert(m_Buffer.size() == ExtensionLayout::SIZE);
+            if (ExtensionLayout::HasReservedBits(m_Buffer.data())) {
+                // Unknown fields of unknown size... abort
                 m_eDeserialize = DESERIALIZE_ERROR;
                 return false;
             } // if
 
-            m_bReliable = (l_Control & 0x04);
-            m_bInvalid  = (l_Control & 0x02);
-            m_bWasSent  = (l_Control & 0x01);
-            
-            // Parse length field
-            m_BytesRemaining = ntohs(*(reinterpret_cast<const uint16_t*>(&m_Buffer[1])));
+            m_bHasPortIndex = ExtensionLayout::Decode<ExtensionPortIndex>(m_Buffer.data());
+            m_bHasSequenceNumber = ExtensionLayout::Decode<ExtensionSequenceNumber>(m_Buffer.data());
             m_Buffer.clear();
+            m_BytesRemaining = ((m_bHasPortIndex ? PortIndexLayout::SIZE : 0) + (m_bHasSequenceNumber ? SequenceNumberLayout::SIZE : 0));
             if (m_BytesRemaining) {
-                m_eDeserialize = DESERIALIZE_BODY;
+                m_eDeserialize = DESERIALIZE_EXTENSION_FIELDS;
             } else {
-                // An empty data packet... may happen
-                m_eDeserialize = DESERIALIZE_FULL;
+                ExpectBody();
             } // else
 
             break;
         }
+        case DESERIALIZE_EXTENSION_FIELDS: {
+            // Deserialize the fields announced by the extension octet
+            const unsigned char* l_Fields = m_Buffer.data();
+            if (m_bHasPortIndex) {
+                m_PortIndex = PortIndexLayout::Decode<PortIndexValue>(l_Fields);
+                l_Fields += PortIndexLayout::SIZE;
+            } // if
+
+            if (m_bHasSequenceNumber) {
+                m_SequenceNumber = SequenceNumberLayout::Decode<SequenceNumberValue>(l_Fields);
+            } // if
+
+            m_Buffer.clear();
+            ExpectBody();
+            break;
+        }
         case DESERIALIZE_BODY: {
             // Read of payload completed
             m_eDeserialize = DESERIALIZE_FULL;
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            m_DeserializedTimestamp = HdlcdLatencyTracer::Now();
+#endif
             break;
         }
         case DESERIALIZE_ERROR:
@@ -155,18 +274,51 @@ private:
         // No error
         return true;
     }
+
+    // The extension octet to transmit, zero if none is required
+    unsigned char GetExtension() const {
+        unsigned char l_Extension = 0x00;
+        ExtensionLayout::Encode<ExtensionPortIndex>(&l_Extension, m_bHasPortIndex);
+        ExtensionLayout::Encode<ExtensionSequenceNumber>(&l_Extension, m_bHasSequenceNumber);
+        return l_Extension;
+    }
+
+    // Continue with the payload after the header and the optional extension were deserialized
+    void ExpectBody() {
+        m_BytesRemaining = m_PayloadLength;
+        if (m_BytesRemaining) {
+            m_eDeserialize = DESERIALIZE_BODY;
+        } else {
+            // An empty data packet... may happen
+            m_eDeserialize = DESERIALIZE_FULL;
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            m_DeserializedTimestamp = m_ReadTimestamp;
+#endif
+        } // else
+    }
     
     // Members
     bool m_bReliable;
     bool m_bInvalid;
     bool m_bWasSent;
+    bool m_bHasPortIndex;
+    uint8_t m_PortIndex;
+    bool m_bHasSequenceNumber;
+    uint32_t m_SequenceNumber;
+    size_t m_PayloadLength;
     typedef enum {
         DESERIALIZE_ERROR  = 0,
         DESERIALIZE_HEADER = 1,
         DESERIALIZE_BODY   = 2,
-        DESERIALIZE_FULL   = 3
+        DESERIALIZE_FULL   = 3,
+        DESERIALIZE_EXTENSION = 4,
+        DESERIALIZE_EXTENSION_FIELDS = 5
     } E_DESERIALIZE;
     E_DESERIALIZE m_eDeserialize;
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    HdlcdLatencyTracer::Timestamp m_ReadTimestamp;
+    HdlcdLatencyTracer::Timestamp m_DeserializedTimestamp;
+#endif
 };
 
 #endif // HDLCD_PACKET_DATA_H
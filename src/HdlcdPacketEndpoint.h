@@ -40,21 +40,40 @@
 #include <iostream>
 #include <memory>
 #include <utility>
+#include "HdlcdIoUring.h"
 #include <boost/asio.hpp>
 #include "FrameEndpoint.h"
 #include "HdlcdPacketData.h"
 #include "HdlcdPacketCtrl.h"
+#include "HdlcdLatencyTracer.h"
+#include "HdlcdProbes.h"
 #include <assert.h>
 
-class HdlcdPacketEndpoint: public std::enable_shared_from_this<HdlcdPacketEndpoint> {
+/*! \class HdlcdPacketEndpointT
+ *  \brief Class template HdlcdPacketEndpointT
+ * 
+ *  Exchanges packets of the HDLCd access protocol via a frame endpoint. Received packets are delivered to a handler object
+ *  whose type is known at compile time, thus the compiler is able to inline the delivery. The handler has to provide:
+ *  - bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData), returns false to stall the receiver
+ *  - void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl)
+ *  - void HandleClosed()
+ * 
+ *  The handler must outlive the packet endpoint. See class HdlcdPacketEndpoint for a variant based on std::function callbacks.
+ */
+template <class THandler>
+class HdlcdPacketEndpointT: public std::enable_shared_from_this<HdlcdPacketEndpointT<THandler>> {
 public:
-    HdlcdPacketEndpoint(boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint): m_IOService(a_IOService), m_FrameEndpoint(a_FrameEndpoint), m_KeepAliveTimer(a_IOService) {
+    HdlcdPacketEndpointT(boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint, THandler& a_Handler): m_IOService(a_IOService), m_FrameEndpoint(a_FrameEndpoint), m_Handler(a_Handler), m_KeepAliveTimer(a_IOService) {
         // Checks
         assert(m_FrameEndpoint);
 
         // Initialize remaining components
         m_bStarted = false;
         m_bStopped = false;
+        m_bNotifyHandler = true;
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+        m_LatencyTracer = nullptr;
+#endif
         m_FrameEndpoint->ResetFrameFactories(0xF0); // 0xF0 = type byte filter regarding the HLDCd access protocol specification
         m_FrameEndpoint->RegisterFrameFactory(HDLCD_PACKET_DATA, []()->std::shared_ptr<Frame>{ return HdlcdPacketData::CreateDeserializedPacket(); });
         m_FrameEndpoint->RegisterFrameFactory(HDLCD_PACKET_CTRL, []()->std::shared_ptr<Frame>{ return HdlcdPacketCtrl::CreateDeserializedPacket(); });
@@ -62,25 +81,16 @@ public:
         m_FrameEndpoint->SetOnClosedCallback ([this](){ OnClosed(); });
     }
     
-    ~HdlcdPacketEndpoint() {
-        m_OnDataCallback   = nullptr;
-        m_OnCtrlCallback   = nullptr;
-        m_OnClosedCallback = nullptr;
+    ~HdlcdPacketEndpointT() {
+        m_bNotifyHandler = false;
         Close();
     }
-            
-    // Callback methods
-    void SetOnDataCallback(std::function<bool(std::shared_ptr<const HdlcdPacketData> a_PacketData)> a_OnDataCallback) {
-        m_OnDataCallback = a_OnDataCallback;
-    }
-    
-    void SetOnCtrlCallback(std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> a_OnCtrlCallback) {
-        m_OnCtrlCallback = a_OnCtrlCallback;
-    }
-    
-    void SetOnClosedCallback(std::function<void()> a_OnClosedCallback) {
-        m_OnClosedCallback = a_OnClosedCallback;
+
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    void SetLatencyTracer(HdlcdLatencyTracer* a_LatencyTracer) {
+        m_LatencyTracer = a_LatencyTracer;
     }
+#endif
     
     bool Send(const Frame& a_Frame, std::function<void()> a_OnSendDoneCallback = nullptr) {
         return (m_FrameEndpoint->SendFrame(a_Frame, a_OnSendDoneCallback));
@@ -90,7 +100,7 @@ public:
         assert(m_bStarted == false);
         assert(m_bStopped == false);
         m_bStarted = true;
-        auto self(shared_from_this());
+        auto self(this->shared_from_this());
         if (m_FrameEndpoint->GetWasStarted()) {
             m_IOService.post([this, self](){ m_FrameEndpoint->TriggerNextFrame(); });
         } else {
@@ -108,26 +118,29 @@ public:
     void Close() {
         if (m_bStarted && (!m_bStopped)) {
             m_bStopped = true;
+            HDLCD_PROBE1(endpoint_closed, this);
             m_KeepAliveTimer.cancel();
             m_FrameEndpoint->Close();
-            if (m_OnClosedCallback) {
-                m_OnClosedCallback();
+            if (m_bNotifyHandler) {
+                m_Handler.HandleClosed();
             } // if
         } // if
     }
     
     void TriggerNextDataPacket() {
+        HDLCD_PROBE1(receiver_resumed, this);
         m_FrameEndpoint->TriggerNextFrame();
     }
 
 private:
     void StartKeepAliveTimer() {
-        auto self(shared_from_this());
+        auto self(this->shared_from_this());
         m_KeepAliveTimer.expires_from_now(boost::posix_time::minutes(1));
         m_KeepAliveTimer.async_wait([this, self](const boost::system::error_code& a_ErrorCode) {
             if (!a_ErrorCode) {
                 // Periodically send keep alive packets
                 m_FrameEndpoint->SendFrame(HdlcdPacketCtrl::CreateKeepAliveRequest());
+                HDLCD_PROBE1(keepalive_sent, this);
                 StartKeepAliveTimer();
             } // if
         }); // async_wait
@@ -140,48 +153,128 @@ private:
     }
     
     bool OnFrame(std::shared_ptr<Frame> a_Frame) {
-        // Reception completed, deliver the packet
+        // Reception completed, deliver the packet. Only the factories of HdlcdPacketData and HdlcdPacketCtrl are registered,
+        // thus the packet type is sufficient to determine the class of the received frame.
         bool l_bReceiving = true;
-        auto l_PacketData = std::dynamic_pointer_cast<HdlcdPacketData>(a_Frame);
-        if (l_PacketData) {
-            if (m_OnDataCallback) {
-                // Deliver the data packet but stall the receiver
-                l_bReceiving = m_OnDataCallback(l_PacketData);
+        switch (std::static_pointer_cast<HdlcdPacket>(a_Frame)->GetHdlcdPacketType()) {
+        case HDLCD_PACKET_DATA: {
+            std::shared_ptr<const HdlcdPacketData> l_PacketData = std::static_pointer_cast<HdlcdPacketData>(a_Frame);
+            HDLCD_PROBE4(frame_received, this, HDLCD_PACKET_DATA, l_PacketData->GetData().size(),
+                         ((l_PacketData->GetReliable() << 2) | (l_PacketData->GetInvalid() << 1) | l_PacketData->GetWasSent()));
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            HdlcdLatencyTracer::Timestamp l_Dispatched = HdlcdLatencyTracer::Now();
+#endif
+            // Deliver the data packet, the handler may stall the receiver
+            l_bReceiving = m_Handler.HandleData(l_PacketData);
+            HDLCD_PROBE2(data_delivered, this, l_PacketData->GetData().size());
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+            if (m_LatencyTracer) {
+                m_LatencyTracer->Record(LATENCY_STAGE_RX_READ, l_PacketData->GetReadTimestamp(), l_PacketData->GetDeserializedTimestamp());
+                m_LatencyTracer->Record(LATENCY_STAGE_RX_DESERIALIZE, l_PacketData->GetDeserializedTimestamp(), l_Dispatched);
+                m_LatencyTracer->Record(LATENCY_STAGE_RX_DELIVER, l_Dispatched, HdlcdLatencyTracer::Now());
             } // if
-        } else {
-            auto l_PacketCtrl = std::dynamic_pointer_cast<HdlcdPacketCtrl>(a_Frame);
-            if (l_PacketCtrl) {
-                bool l_bDeliver = true;
-                if (l_PacketCtrl->GetPacketType() == HdlcdPacketCtrl::CTRL_TYPE_KEEP_ALIVE) {
-                    // This is a keep alive packet, simply drop it.
-                    l_bDeliver = false;
-                } // if
-                
-                if ((l_bDeliver) && (m_OnCtrlCallback)) {
-                    m_OnCtrlCallback(*(l_PacketCtrl.get()));
-                } // if
-            } else {
-                assert(false);
-            } // else
-        } // else
+#endif
+            break;
+        }
+        case HDLCD_PACKET_CTRL: {
+            const HdlcdPacketCtrl& l_PacketCtrl = static_cast<const HdlcdPacketCtrl&>(*a_Frame);
+            HDLCD_PROBE4(frame_received, this, HDLCD_PACKET_CTRL, 0, l_PacketCtrl.GetPacketType());
+            if (l_PacketCtrl.GetPacketType() != HdlcdPacketCtrl::CTRL_TYPE_KEEP_ALIVE) {
+                // Keep alive packets are simply dropped
+                m_Handler.HandleCtrl(l_PacketCtrl);
+            } // if
+
+            break;
+        }
+        default:
+            assert(false);
+        } // switch
         
+        if (!l_bReceiving) {
+            HDLCD_PROBE1(receiver_stalled, this);
+        } // if
+
         return l_bReceiving;
     }
     
     boost::asio::io_service& m_IOService;
     std::shared_ptr<FrameEndpoint> m_FrameEndpoint;
     
+    // The receiver of all packets and events
+    THandler& m_Handler;
+    bool m_bNotifyHandler;
     
+    bool m_bStarted;
+    bool m_bStopped;
+#ifdef HDLCD_ENABLE_LATENCY_TRACING
+    HdlcdLatencyTracer* m_LatencyTracer;
+#endif
+    
+    // The keep alive timer
+    boost::asio::deadline_timer m_KeepAliveTimer;
+};
+
+
+
+/*! \class HdlcdPacketEndpointCallbacks
+ *  \brief Class HdlcdPacketEndpointCallbacks
+ * 
+ *  The handler of class HdlcdPacketEndpoint that forwards all received packets and events to std::function callbacks
+ */
+class HdlcdPacketEndpointCallbacks {
+public:
+    bool HandleData(std::shared_ptr<const HdlcdPacketData> a_PacketData) {
+        if (m_OnDataCallback) {
+            return m_OnDataCallback(a_PacketData);
+        } // if
+
+        return true;
+    }
+
+    void HandleCtrl(const HdlcdPacketCtrl& a_PacketCtrl) {
+        if (m_OnCtrlCallback) {
+            m_OnCtrlCallback(a_PacketCtrl);
+        } // if
+    }
+
+    void HandleClosed() {
+        if (m_OnClosedCallback) {
+            m_OnClosedCallback();
+        } // if
+    }
+
+protected:
     // All possible callbacks for a user of this class
     std::function<bool(std::shared_ptr<const HdlcdPacketData> a_PacketData)> m_OnDataCallback;
     std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> m_OnCtrlCallback;
     std::function<void()> m_OnClosedCallback;
+};
+
+
+
+/*! \class HdlcdPacketEndpoint
+ *  \brief Class HdlcdPacketEndpoint
+ * 
+ *  A packet endpoint that delivers all received packets and events via std::function callbacks
+ */
+class HdlcdPacketEndpoint: private HdlcdPacketEndpointCallbacks, public HdlcdPacketEndpointT<HdlcdPacketEndpointCallbacks> {
+public:
+    HdlcdPacketEndpoint(boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint):
+        HdlcdPacketEndpointT<HdlcdPacketEndpointCallbacks>(a_IOService, a_FrameEndpoint, *this) {
+    }
+            
+    // Callback methods
+    void SetOnDataCallback(std::function<bool(std::shared_ptr<const HdlcdPacketData> a_PacketData)> a_OnDataCallback) {
+        m_OnDataCallback = a_OnDataCallback;
+    }
     
-    bool m_bStarted;
-    bool m_bStopped;
+    void SetOnCtrlCallback(std::function<void(const HdlcdPacketCtrl& a_PacketCtrl)> a_OnCtrlCallback) {
+        m_OnCtrlCallback = a_OnCtrlCallback;
+    }
     
-    // The keep alive timer
-    boost::asio::deadline_timer m_KeepAliveTimer;
+    void SetOnClosedCallback(std::function<void()> a_OnClosedCallback) {
+        m_OnClosedCallback = a_OnClosedCallback;
+    }
 };
 
 #endif // HDLCD_PACKET_ENDPOINT_H
@@ -0,0 +1,189 @@
+/**
+ * \file      HdlcdPacketFilter.h
+ * \brief     This file contains the header declaration of class HdlcdPacketFilter
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PACKET_FILTER_H
+#define HDLCD_PACKET_FILTER_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "HdlcdPacketData.h"
+
+/*! \class HdlcdPacketFilter
+ *  \brief Class HdlcdPacketFilter
+ * 
+ *  A filter program that decides whether a data packet is delivered to a session. The program is a list of rules, each
+ *  matching a single octet of the payload: the octet at the given offset, masked with the given mask, must be equal to
+ *  the given value. A data packet matches if it matches all rules, thus an empty program matches all data packets. A rule
+ *  referring to an offset beyond the end of the payload does not match.
+ *  
+ *  The program is transferred in the extension of HdlcdSessionHeader version 1 and evaluated by the HDLC daemon before
+ *  sending. Both sides use this class to guarantee identical matching. Each rule is encoded as four octets: the offset
+ *  in network byte order, the mask, and the value.
+ */
+class HdlcdPacketFilter {
+public:
+    static const size_t MAX_RULES = 32; //!< The maximum number of rules of a filter program
+
+    /*! \brief  The constructor of HdlcdPacketFilter objects, creating an empty program that matches all data packets
+     */
+    HdlcdPacketFilter() {
+    }
+
+    /*! \brief  Add a rule to the program
+     * 
+     *  \param  a_Offset the offset of the octet in the payload
+     *  \param  a_Mask the mask to apply to the octet
+     *  \param  a_Value the value the masked octet must be equal to
+     * 
+     *  \retval true the rule was added
+     *  \retval false the program already contains MAX_RULES rules or the value has bits set outside the mask
+     *  \return Indicates whether the rule was added
+     */
+    bool AddRule(uint16_t a_Offset, uint8_t a_Mask, uint8_t a_Value) {
+        if ((m_Rules.size() >= MAX_RULES) || (a_Value & ~a_Mask)) {
+            return false;
+        } // if
+
+        Rule l_Rule;
+        l_Rule.m_Offset = a_Offset;
+        l_Rule.m_Mask   = a_Mask;
+        l_Rule.m_Value  = a_Value;
+        m_Rules.push_back(l_Rule);
+        return true;
+    }
+
+    /*! \brief  Query whether the program is empty
+     * 
+     *  \return Indicates whether the program is empty and thus matches all data packets
+     */
+    bool IsEmpty() const {
+        return m_Rules.empty();
+    }
+
+    /*! \brief  Query the number of rules of the program
+     * 
+     *  \return The number of rules
+     */
+    size_t GetRuleCount() const {
+        return m_Rules.size();
+    }
+
+    /*! \brief  Evaluate the program against a payload
+     * 
+     *  \param  a_Payload the payload
+     *  \param  a_Length the number of octets of the payload
+     * 
+     *  \return Indicates whether the payload matches all rules
+     */
+    bool Matches(const unsigned char* a_Payload, size_t a_Length) const {
+        for (size_t l_Index = 0; l_Index < m_Rules.size(); ++l_Index) {
+            const Rule& l_Rule = m_Rules[l_Index];
+            if ((l_Rule.m_Offset >= a_Length) || ((a_Payload[l_Rule.m_Offset] & l_Rule.m_Mask) != l_Rule.m_Value)) {
+                return false;
+            } // if
+        } // for
+
+        return true;
+    }
+
+    /*! \brief  Evaluate the program against a data packet
+     * 
+     *  \param  a_PacketData the data packet
+     * 
+     *  \return Indicates whether the payload of the data packet matches all rules
+     */
+    bool Matches(const HdlcdPacketData& a_PacketData) const {
+        const std::vector<unsigned char>& l_Payload = a_PacketData.GetData();
+        return Matches(l_Payload.data(), l_Payload.size());
+    }
+
+    /*! \brief  Append the encoded program to a buffer
+     * 
+     *  \param  a_Buffer the buffer to append to
+     */
+    void Serialize(std::vector<unsigned char>& a_Buffer) const {
+        for (size_t l_Index = 0; l_Index < m_Rules.size(); ++l_Index) {
+            const Rule& l_Rule = m_Rules[l_Index];
+            a_Buffer.emplace_back(l_Rule.m_Offset >> 8);
+            a_Buffer.emplace_back(l_Rule.m_Offset & 0xFF);
+            a_Buffer.emplace_back(l_Rule.m_Mask);
+            a_Buffer.emplace_back(l_Rule.m_Value);
+        } // for
+    }
+
+    /*! \brief  Replace the program by a decoded one
+     * 
+     *  \param  a_Buffer the encoded program
+     *  \param  a_Length the number of octets of the encoded program
+     * 
+     *  \retval true the program was decoded
+     *  \retval false the encoded program is malformed, the program is left empty
+     *  \return Indicates whether the program was decoded
+     */
+    bool Deserialize(const unsigned char* a_Buffer, size_t a_Length) {
+        m_Rules.clear();
+        if ((a_Length % 4) || ((a_Length / 4) > MAX_RULES)) {
+            return false;
+        } // if
+
+        for (size_t l_Offset = 0; l_Offset < a_Length; l_Offset += 4) {
+            if (!AddRule(((uint16_t(a_Buffer[l_Offset]) << 8) | a_Buffer[l_Offset + 1]), a_Buffer[l_Offset + 2], a_Buffer[l_Offset + 3])) {
+                m_Rules.clear();
+                return false;
+            } // if
+        } // for
+
+        return true;
+    }
+
+private:
+    /*! \struct Rule
+     *  \brief A single rule matching one octet of the payload
+     */
+    struct Rule {
+        uint16_t m_Offset; //!< The offset of the octet in the payload
+        uint8_t  m_Mask;   //!< The mask to apply to the octet
+        uint8_t  m_Value;  //!< The value the masked octet must be equal to
+    };
+
+    // Members
+    std::vector<Rule> m_Rules; //!< The rules, all of them must match
+};
+
+#endif // HDLCD_PACKET_FILTER_H
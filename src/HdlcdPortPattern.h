@@ -0,0 +1,133 @@
+/**
+ * \file      HdlcdPortPattern.h
+ * \brief     This file contains the header declaration of class HdlcdPortPattern
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PORT_PATTERN_H
+#define HDLCD_PORT_PATTERN_H
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+/*! \class HdlcdPortPattern
+ *  \brief Class HdlcdPortPattern
+ * 
+ *  Matching of serial port names against the port patterns of multi-port sessions, used by the HDLCd to select the
+ *  serial ports of a session. A pattern is either a literal port name or a glob: '*' matches any sequence of characters,
+ *  including the empty one, and '?' matches any single character. There is no escaping.
+ */
+class HdlcdPortPattern {
+public:
+    static const size_t MAX_LENGTH   = 255; //!< The maximum length of a port name or pattern, encoded in a single octet
+    static const size_t MAX_PATTERNS = 128; //!< The maximum number of patterns of a multi-port session
+
+    /*! \brief  Check whether a set of patterns can be transmitted via a session header
+     * 
+     *  \param  a_Patterns the patterns
+     * 
+     *  \retval true there are at most MAX_PATTERNS patterns, none of them longer than MAX_LENGTH
+     *  \retval false there are too many patterns or at least one is too long
+     *  \return Indicates whether the patterns can be transmitted
+     */
+    static bool IsValid(const std::vector<std::string>& a_Patterns) {
+        if (a_Patterns.size() > MAX_PATTERNS) {
+            return false;
+        } // if
+
+        for (auto l_Pattern = a_Patterns.begin(); l_Pattern != a_Patterns.end(); ++l_Pattern) {
+            if (l_Pattern->size() > MAX_LENGTH) {
+                return false;
+            } // if
+        } // for
+
+        return true;
+    }
+
+    /*! \brief  Match a serial port name against a single pattern
+     * 
+     *  \param  a_Pattern the pattern
+     *  \param  a_SerialPortName the name of the serial port
+     * 
+     *  \return Indicates whether the name matches the pattern
+     */
+    static bool Matches(const std::string& a_Pattern, const std::string& a_SerialPortName) {
+        // Iterative matching with backtracking to the most recent '*' only, linear in practice
+        size_t l_Pattern = 0;
+        size_t l_Name = 0;
+        size_t l_Star = std::string::npos;
+        size_t l_StarName = 0;
+        while (l_Name < a_SerialPortName.size()) {
+            if ((l_Pattern < a_Pattern.size()) && ((a_Pattern[l_Pattern] == '?') || (a_Pattern[l_Pattern] == a_SerialPortName[l_Name]))) {
+                ++l_Pattern;
+                ++l_Name;
+            } else if ((l_Pattern < a_Pattern.size()) && (a_Pattern[l_Pattern] == '*')) {
+                l_Star = l_Pattern++;
+                l_StarName = l_Name;
+            } else if (l_Star != std::string::npos) {
+                l_Pattern = (l_Star + 1);
+                l_Name = ++l_StarName;
+            } else {
+                return false;
+            } // else
+        } // while
+
+        while ((l_Pattern < a_Pattern.size()) && (a_Pattern[l_Pattern] == '*')) {
+            ++l_Pattern;
+        } // while
+
+        return (l_Pattern == a_Pattern.size());
+    }
+
+    /*! \brief  Match a serial port name against a set of patterns
+     * 
+     *  \param  a_Patterns the patterns
+     *  \param  a_SerialPortName the name of the serial port
+     * 
+     *  \return Indicates whether the name matches at least one of the patterns
+     */
+    static bool Matches(const std::vector<std::string>& a_Patterns, const std::string& a_SerialPortName) {
+        for (auto l_Pattern = a_Patterns.begin(); l_Pattern != a_Patterns.end(); ++l_Pattern) {
+            if (Matches(*l_Pattern, a_SerialPortName)) {
+                return true;
+            } // if
+        } // for
+
+        return false;
+    }
+};
+
+#endif // HDLCD_PORT_PATTERN_H
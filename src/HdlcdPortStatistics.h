@@ -0,0 +1,142 @@
+/**
+ * \file      HdlcdPortStatistics.h
+ * \brief     This file contains the header declaration of class HdlcdPortStatistics
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PORT_STATISTICS_H
+#define HDLCD_PORT_STATISTICS_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "HdlcdWireSchema.h"
+
+/*! \class HdlcdPortStatistics
+ *  \brief Class HdlcdPortStatistics
+ * 
+ *  The performance counters of a serial port as reported by the HDLCd via port statistics control packets. All counters
+ *  refer to the time since the serial port was opened by the HDLCd.
+ *  
+ *  The counters are transferred in a fixed layout of SIZE octets, all fields in network byte order: received HDLC frames,
+ *  transmitted HDLC frames, received octets, and transmitted octets as 64 bit fields, followed by the number of CRC
+ *  errors, the number of retransmissions, the current depth of the transmit queue, and the uptime of the serial port in
+ *  seconds as 32 bit fields.
+ */
+class HdlcdPortStatistics {
+public:
+    static const size_t SIZE = 48; //!< The number of octets of the serialized counters
+
+    /*! \brief  The constructor of HdlcdPortStatistics objects, all counters are zero
+     */
+    HdlcdPortStatistics(): m_RxFrames(0), m_TxFrames(0), m_RxOctets(0), m_TxOctets(0), m_CrcErrors(0), m_Retransmissions(0), m_TxQueueDepth(0), m_Uptime(0) {
+    }
+
+    // Getters
+    uint64_t GetRxFrames() const { return m_RxFrames; }               //!< The number of received HDLC frames
+    uint64_t GetTxFrames() const { return m_TxFrames; }               //!< The number of transmitted HDLC frames
+    uint64_t GetRxOctets() const { return m_RxOctets; }               //!< The number of received octets on the serial line
+    uint64_t GetTxOctets() const { return m_TxOctets; }               //!< The number of transmitted octets on the serial line
+    uint32_t GetCrcErrors() const { return m_CrcErrors; }             //!< The number of received HDLC frames with a broken FCS
+    uint32_t GetRetransmissions() const { return m_Retransmissions; } //!< The number of retransmitted HDLC frames
+    uint32_t GetTxQueueDepth() const { return m_TxQueueDepth; }       //!< The number of HDLC frames waiting for transmission
+    uint32_t GetUptime() const { return m_Uptime; }                   //!< The number of seconds since the serial port was opened
+
+    // Setters, used by the HDLCd
+    void SetRxFrames(uint64_t a_RxFrames) { m_RxFrames = a_RxFrames; }
+    void SetTxFrames(uint64_t a_TxFrames) { m_TxFrames = a_TxFrames; }
+    void SetRxOctets(uint64_t a_RxOctets) { m_RxOctets = a_RxOctets; }
+    void SetTxOctets(uint64_t a_TxOctets) { m_TxOctets = a_TxOctets; }
+    void SetCrcErrors(uint32_t a_CrcErrors) { m_CrcErrors = a_CrcErrors; }
+    void SetRetransmissions(uint32_t a_Retransmissions) { m_Retransmissions = a_Retransmissions; }
+    void SetTxQueueDepth(uint32_t a_TxQueueDepth) { m_TxQueueDepth = a_TxQueueDepth; }
+    void SetUptime(uint32_t a_Uptime) { m_Uptime = a_Uptime; }
+
+    /*! \brief  Append the serialized counters to a buffer
+     * 
+     *  \param  a_Buffer the buffer to append SIZE octets to
+     */
+    void Serialize(std::vector<unsigned char>& a_Buffer) const {
+        unsigned char* l_Counters = CountersLayout::Append(a_Buffer);
+        CountersLayout::Encode<RxFrames>(l_Counters, m_RxFrames);
+        CountersLayout::Encode<TxFrames>(l_Counters, m_TxFrames);
+        CountersLayout::Encode<RxOctets>(l_Counters, m_RxOctets);
+        CountersLayout::Encode<TxOctets>(l_Counters, m_TxOctets);
+        CountersLayout::Encode<CrcErrors>(l_Counters, m_CrcErrors);
+        CountersLayout::Encode<Retransmissions>(l_Counters, m_Retransmissions);
+        CountersLayout::Encode<TxQueueDepth>(l_Counters, m_TxQueueDepth);
+        CountersLayout::Encode<Uptime>(l_Counters, m_Uptime);
+    }
+
+    /*! \brief  Read the counters from a buffer
+     * 
+     *  \param  a_Buffer the buffer containing SIZE octets of serialized counters
+     */
+    void Deserialize(const unsigned char* a_Buffer) {
+        m_RxFrames        = CountersLayout::Decode<RxFrames>(a_Buffer);
+        m_TxFrames        = CountersLayout::Decode<TxFrames>(a_Buffer);
+        m_RxOctets        = CountersLayout::Decode<RxOctets>(a_Buffer);
+        m_TxOctets        = CountersLayout::Decode<TxOctets>(a_Buffer);
+        m_CrcErrors       = CountersLayout::Decode<CrcErrors>(a_Buffer);
+        m_Retransmissions = CountersLayout::Decode<Retransmissions>(a_Buffer);
+        m_TxQueueDepth    = CountersLayout::Decode<TxQueueDepth>(a_Buffer);
+        m_Uptime          = CountersLayout::Decode<Uptime>(a_Buffer);
+    }
+
+private:
+    // The wire format of the counters
+    typedef HdlcdWireField< 0, 8> RxFrames;
+    typedef HdlcdWireField< 8, 8> TxFrames;
+    typedef HdlcdWireField<16, 8> RxOctets;
+    typedef HdlcdWireField<24, 8> TxOctets;
+    typedef HdlcdWireField<32, 4> CrcErrors;
+    typedef HdlcdWireField<36, 4> Retransmissions;
+    typedef HdlcdWireField<40, 4> TxQueueDepth;
+    typedef HdlcdWireField<44, 4> Uptime;
+    typedef HdlcdWireLayout<RxFrames, TxFrames, RxOctets, TxOctets, CrcErrors, Retransmissions, TxQueueDepth, Uptime> CountersLayout;
+    static_assert((CountersLayout::SIZE == SIZE), "The layout of the counters does not match the announced size");
+
+    // Members
+    uint64_t m_RxFrames;
+    uint64_t m_TxFrames;
+    uint64_t m_RxOctets;
+    uint64_t m_TxOctets;
+    uint32_t m_CrcErrors;
+    uint32_t m_Retransmissions;
+    uint32_t m_TxQueueDepth;
+    uint32_t m_Uptime;
+};
+
+#endif // HDLCD_PORT_STATISTICS_H
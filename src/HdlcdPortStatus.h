@@ -0,0 +1,125 @@
+/**
+ * \file      HdlcdPortStatus.h
+ * \brief     This file contains the header declaration of class HdlcdPortStatus
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PORT_STATUS_H
+#define HDLCD_PORT_STATUS_H
+
+#include "HdlcdPacketCtrl.h"
+
+/*! \class HdlcdPortStatus
+ *  \brief Class HdlcdPortStatus
+ * 
+ *  The status of a serial port as reported by the HDLCd via port status control packets.
+ */
+class HdlcdPortStatus {
+public:
+    /*! \brief  The constructor of HdlcdPortStatus objects, creating an unknown port status
+     */
+    HdlcdPortStatus(): m_bValid(false), m_bAlive(false), m_bLockedByOthers(false), m_bLockedBySelf(false) {
+    }
+
+    /*! \brief  The constructor of HdlcdPortStatus objects, taking the port status from a received control packet
+     * 
+     *  \param  a_PacketCtrl the received port status control packet
+     */
+    explicit HdlcdPortStatus(const HdlcdPacketCtrl& a_PacketCtrl): m_bValid(true), m_bAlive(a_PacketCtrl.GetIsAlive()),
+        m_bLockedByOthers(a_PacketCtrl.GetIsLockedByOthers()), m_bLockedBySelf(a_PacketCtrl.GetIsLockedBySelf()) {
+    }
+
+    /*! \brief  Query whether the port status is known
+     * 
+     *  \return Indicates whether a port status was received
+     */
+    bool IsValid() const {
+        return m_bValid;
+    }
+
+    /*! \brief  Query whether the serial port is alive
+     * 
+     *  \return Indicates whether the HDLCd is able to exchange HDLC frames via the serial port
+     */
+    bool GetIsAlive() const {
+        return m_bAlive;
+    }
+
+    /*! \brief  Query whether the serial port is locked by other clients
+     * 
+     *  \return Indicates whether the serial port is locked by other clients
+     */
+    bool GetIsLockedByOthers() const {
+        return m_bLockedByOthers;
+    }
+
+    /*! \brief  Query whether the serial port is locked by this client
+     * 
+     *  \return Indicates whether the serial port is locked by this client
+     */
+    bool GetIsLockedBySelf() const {
+        return m_bLockedBySelf;
+    }
+
+    /*! \brief  Compare two port status objects
+     * 
+     *  \param  a_Other the other port status object
+     * 
+     *  \return Indicates whether both port status objects are equal
+     */
+    bool operator==(const HdlcdPortStatus& a_Other) const {
+        return ((m_bValid == a_Other.m_bValid) && (m_bAlive == a_Other.m_bAlive) && (m_bLockedByOthers == a_Other.m_bLockedByOthers) &&
+                (m_bLockedBySelf == a_Other.m_bLockedBySelf));
+    }
+
+    /*! \brief  Compare two port status objects
+     * 
+     *  \param  a_Other the other port status object
+     * 
+     *  \return Indicates whether both port status objects differ
+     */
+    bool operator!=(const HdlcdPortStatus& a_Other) const {
+        return (!(*this == a_Other));
+    }
+
+private:
+    // Members
+    bool m_bValid;          //!< Indicates whether the port status is known
+    bool m_bAlive;          //!< The serial port is alive
+    bool m_bLockedByOthers; //!< The serial port is locked by other clients
+    bool m_bLockedBySelf;   //!< The serial port is locked by this client
+};
+
+#endif // HDLCD_PORT_STATUS_H
@@ -0,0 +1,72 @@
+/**
+ * \file      HdlcdProbes.h
+ * \brief     This file contains the static user-space probes of the HDLCd access protocol entities
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_PROBES_H
+#define HDLCD_PROBES_H
+
+// Define HDLCD_ENABLE_SDT_PROBES before including any HDLCd header to place static user-space probes (SystemTap SDT
+// markers, provider "hdlcd") at the hot paths of HdlcdPacketEndpoint and HdlcdClient. The probes are nops until they are
+// attached, e.g., by "perf probe" or "bpftrace", and require the header <sys/sdt.h>, e.g., package "systemtap-sdt-dev".
+// All probes are removed at compile time if HDLCD_ENABLE_SDT_PROBES is not defined.
+//
+// Available probes and their arguments:
+// - session_connected (client, data endpoint, control endpoint, serial port name)
+// - session_closed    (client)
+// - frame_received    (endpoint, packet type, payload length, flags or control packet type)
+// - data_delivered    (endpoint, payload length)
+// - send_queued       (client, payload length, enqueued)
+// - send_completed    (client, payload length)
+// - keepalive_sent    (endpoint)
+// - receiver_stalled  (endpoint)
+// - receiver_resumed  (endpoint)
+// - endpoint_closed   (endpoint)
+
+#ifdef HDLCD_ENABLE_SDT_PROBES
+#include <sys/sdt.h>
+#define HDLCD_PROBE1(name, a1)             DTRACE_PROBE1(hdlcd, name, a1)
+#define HDLCD_PROBE2(name, a1, a2)         DTRACE_PROBE2(hdlcd, name, a1, a2)
+#define HDLCD_PROBE3(name, a1, a2, a3)     DTRACE_PROBE3(hdlcd, name, a1, a2, a3)
+#define HDLCD_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(hdlcd, name, a1, a2, a3, a4)
+#else
+#define HDLCD_PROBE1(name, a1)
+#define HDLCD_PROBE2(name, a1, a2)
+#define HDLCD_PROBE3(name, a1, a2, a3)
+#define HDLCD_PROBE4(name, a1, a2, a3, a4)
+#endif // HDLCD_ENABLE_SDT_PROBES
+
+#endif // HDLCD_PROBES_H
@@ -0,0 +1,151 @@
+/**
+ * \file      HdlcdSequenceTracker.h
+ * \brief     This file contains the header declaration of class HdlcdSequenceTracker
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_SEQUENCE_TRACKER_H
+#define HDLCD_SEQUENCE_TRACKER_H
+
+#include <stdint.h>
+#include "HdlcdHistogram.h"
+
+/*! \class HdlcdSequenceTracker
+ *  \brief Class HdlcdSequenceTracker
+ * 
+ *  Detects data packets dropped on their way from the HDLCd to a client entity by inspecting the sequence numbers of data
+ *  sessions that requested them, see HdlcdSessionHeader. The HDLCd increments the sequence number per data packet of a
+ *  session, thus each gap is a burst of lost data packets. The length of each burst is collected in a histogram. Sequence
+ *  numbers are compared modulo 2^32, so wrap-arounds are handled. Data packets behind the expected sequence number, e.g.,
+ *  duplicates, are counted separately and do not move the expected sequence number back.
+ */
+class HdlcdSequenceTracker {
+public:
+    /*! \brief  The constructor of HdlcdSequenceTracker objects
+     */
+    HdlcdSequenceTracker(): m_bSynchronized(false), m_ExpectedSequenceNumber(0), m_Received(0), m_Lost(0), m_Gaps(0), m_Late(0) {
+    }
+
+    /*! \brief  Start over with a new session
+     * 
+     *  The first data packet of the new session determines the expected sequence number. The counters are kept.
+     */
+    void Restart() {
+        m_bSynchronized = false;
+    }
+
+    /*! \brief  Account for a received data packet
+     * 
+     *  \param  a_SequenceNumber the sequence number of the received data packet
+     * 
+     *  \return The number of data packets lost directly before the received one
+     */
+    uint32_t Update(uint32_t a_SequenceNumber) {
+        ++m_Received;
+        if (!m_bSynchronized) {
+            m_bSynchronized = true;
+            m_ExpectedSequenceNumber = (a_SequenceNumber + 1);
+            return 0;
+        } // if
+
+        const uint32_t l_Distance = (a_SequenceNumber - m_ExpectedSequenceNumber);
+        if (l_Distance >= 0x80000000) {
+            // Behind the expected sequence number
+            ++m_Late;
+            return 0;
+        } // if
+
+        m_ExpectedSequenceNumber = (a_SequenceNumber + 1);
+        if (l_Distance) {
+            m_Lost += l_Distance;
+            ++m_Gaps;
+            m_Bursts.Add(l_Distance);
+        } // if
+
+        return l_Distance;
+    }
+
+    /*! \brief  Query the number of data packets with a sequence number
+     * 
+     *  \return The number of data packets with a sequence number
+     */
+    uint64_t GetReceived() const {
+        return m_Received;
+    }
+
+    /*! \brief  Query the number of lost data packets
+     * 
+     *  \return The number of data packets skipped by the sequence numbers
+     */
+    uint64_t GetLost() const {
+        return m_Lost;
+    }
+
+    /*! \brief  Query the number of gaps
+     * 
+     *  \return The number of bursts of lost data packets
+     */
+    uint64_t GetGaps() const {
+        return m_Gaps;
+    }
+
+    /*! \brief  Query the number of late data packets
+     * 
+     *  \return The number of data packets behind the expected sequence number
+     */
+    uint64_t GetLate() const {
+        return m_Late;
+    }
+
+    /*! \brief  Query the histogram of the bursts of lost data packets
+     * 
+     *  \return The histogram of the number of data packets lost per gap
+     */
+    const HdlcdHistogram& GetBursts() const {
+        return m_Bursts;
+    }
+
+private:
+    // Members
+    bool m_bSynchronized; //!< Indicates whether the expected sequence number is known
+    uint32_t m_ExpectedSequenceNumber; //!< The sequence number of the next data packet
+    uint64_t m_Received; //!< The number of data packets with a sequence number
+    uint64_t m_Lost; //!< The number of lost data packets
+    uint64_t m_Gaps; //!< The number of bursts of lost data packets
+    uint64_t m_Late; //!< The number of data packets behind the expected sequence number
+    HdlcdHistogram m_Bursts; //!< The number of data packets lost per gap
+};
+
+#endif // HDLCD_SEQUENCE_TRACKER_H
@@ -0,0 +1,359 @@
+/**
+ * \file      HdlcdSessionAcceptor.h
+ * \brief     This file contains the header declaration of class HdlcdSessionAcceptor
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_SESSION_ACCEPTOR_H
+#define HDLCD_SESSION_ACCEPTOR_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include "HdlcdIoUring.h"
+#include <boost/asio.hpp>
+#include "HdlcdSessionDescriptor.h"
+#include "HdlcdSessionHeader.h"
+#include "FrameEndpoint.h"
+
+/*! \class HdlcdSessionAcceptor
+ *  \brief Class HdlcdSessionAcceptor
+ * 
+ *  The server-side counterpart of the session setup of HdlcdClient: accepts TCP connections, reads the session header of
+ *  each one, and hands the fully parsed session to the handler registered for its session type. The handler takes over
+ *  the frame endpoint, e.g., to create an HdlcdPacketEndpoint on it. The frame endpoint is handed over stalled, i.e., no
+ *  further frames are read until the handler resumes it: HdlcdPacketEndpoint::Start() does so, a handler using the frame
+ *  endpoint directly has to call TriggerNextFrame() after registering its callbacks. Connections that do not deliver a
+ *  valid session header within the handshake timeout, or that request a session type without a handler, are closed.
+ *  
+ *  To use multiple threads, provide one IOService per thread. On platforms offering SO_REUSEPORT each IOService gets its
+ *  own listening socket bound to the same port, thus the kernel distributes new connections among the threads and no lock
+ *  is shared among them. Otherwise, a single listening socket hands accepted connections to the IOServices round-robin.
+ *  A session is always handed to its handler by the thread running the IOService the connection belongs to.
+ */
+class HdlcdSessionAcceptor {
+public:
+    typedef std::function<void(boost::asio::io_service& a_IOService, std::shared_ptr<FrameEndpoint> a_FrameEndpoint,
+                               std::shared_ptr<HdlcdSessionHeader> a_SessionHeader)> SessionHandler; //!< Takes over an accepted session, its frame endpoint is stalled
+
+    /*! \brief  The constructor of HdlcdSessionAcceptor objects using a single thread
+     * 
+     *  \param  a_IOService the boost IOService object
+     */
+    explicit HdlcdSessionAcceptor(boost::asio::io_service& a_IOService): m_HandshakeTimeout(2000), m_FastOpenQueueLength(0), m_NextShard(0), m_Accepted(0), m_Dispatched(0),
+        m_TimedOut(0), m_Rejected(0), m_SessionHandlers(SESSION_TYPE_MASK / 0x10 + 1) {
+        m_Shards.emplace_back(new Shard(a_IOService));
+    }
+
+    /*! \brief  The constructor of HdlcdSessionAcceptor objects using multiple threads
+     * 
+     *  \param  a_IOServices the boost IOService objects, each one run by a dedicated thread
+     */
+    explicit HdlcdSessionAcceptor(const std::vector<boost::asio::io_service*>& a_IOServices): m_HandshakeTimeout(2000), m_FastOpenQueueLength(0), m_NextShard(0), m_Accepted(0),
+        m_Dispatched(0), m_TimedOut(0), m_Rejected(0), m_SessionHandlers(SESSION_TYPE_MASK / 0x10 + 1) {
+        assert(!a_IOServices.empty());
+        for (auto l_IOService = a_IOServices.begin(); l_IOService != a_IOServices.end(); ++l_IOService) {
+            m_Shards.emplace_back(new Shard(**l_IOService));
+        } // for
+    }
+
+    /*! \brief  The destructor of HdlcdSessionAcceptor objects
+     * 
+     *  Must not be called before all IOServices stopped using this acceptor
+     */
+    ~HdlcdSessionAcceptor() {
+        CloseAcceptors();
+    }
+
+    /*! \brief  Register the handler for a session type, must be called before Open()
+     * 
+     *  \param  a_eSessionType the session type
+     *  \param  a_SessionHandler the handler to take over sessions of this type, an empty function pointer rejects them
+     */
+    void SetSessionHandler(E_SESSION_TYPE a_eSessionType, SessionHandler a_SessionHandler) {
+        assert(a_eSessionType < SESSION_TYPE_ARITHMETIC_ENDMARKER);
+        m_SessionHandlers[a_eSessionType >> 4] = a_SessionHandler;
+    }
+
+    /*! \brief  Specify the time a new connection has to deliver its session header, must be called before Open()
+     * 
+     *  \param  a_Milliseconds the handshake timeout in milliseconds
+     */
+    void SetHandshakeTimeout(unsigned int a_Milliseconds) {
+        m_HandshakeTimeout = a_Milliseconds;
+    }
+
+    /*! \brief  Accept session headers sent within the SYN via TCP Fast Open, must be called before Open()
+     * 
+     *  See HdlcdClientT::SetFastConnect(). Ignored if the platform does not support TCP Fast Open.
+     * 
+     *  \param  a_QueueLength the maximum number of pending TCP Fast Open requests, zero disables TCP Fast Open
+     */
+    void SetFastOpen(int a_QueueLength) {
+        m_FastOpenQueueLength = a_QueueLength;
+    }
+
+    /*! \brief  Start accepting connections
+     * 
+     *  \param  a_Endpoint the local endpoint to listen at, the port number may be zero to pick an unused one
+     *  \param  a_ErrorCode the reason of a failure
+     * 
+     *  \retval true the acceptor is listening
+     *  \retval false the local endpoint could not be bound
+     *  \return Indicates whether the acceptor is listening
+     */
+    bool Open(boost::asio::ip::tcp::endpoint a_Endpoint, boost::system::error_code& a_ErrorCode) {
+        for (size_t l_Index = 0; l_Index < m_Shards.size(); ++l_Index) {
+            Shard& l_Shard = *m_Shards[l_Index];
+#ifdef SO_REUSEPORT
+            const bool l_bListen = true;
+#else
+            const bool l_bListen = (l_Index == 0);
+#endif
+            if (!l_bListen) {
+                continue;
+            } // if
+
+            l_Shard.m_Acceptor.open(a_Endpoint.protocol(), a_ErrorCode);
+            if (!a_ErrorCode) {
+                l_Shard.m_Acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), a_ErrorCode);
+            } // if
+
+#ifdef SO_REUSEPORT
+            if ((!a_ErrorCode) && (m_Shards.size() > 1)) {
+                l_Shard.m_Acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), a_ErrorCode);
+            } // if
+#endif
+            if (!a_ErrorCode) {
+                l_Shard.m_Acceptor.bind(a_Endpoint, a_ErrorCode);
+            } // if
+
+#ifdef TCP_FASTOPEN
+            if ((!a_ErrorCode) && (m_FastOpenQueueLength > 0)) {
+                // Optional, the kernel may not support it
+                boost::system::error_code l_ErrorCode;
+                l_Shard.m_Acceptor.set_option(boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN>(m_FastOpenQueueLength), l_ErrorCode);
+            } // if
+#endif
+
+            if (!a_ErrorCode) {
+                l_Shard.m_Acceptor.listen(boost::asio::socket_base::max_listen_connections, a_ErrorCode);
+            } // if
+
+            if (a_ErrorCode) {
+                // Nothing was posted to the IOServices yet
+                CloseAcceptors();
+                return false;
+            } // if
+
+            // All further listening sockets have to share the port picked for the first one
+            a_Endpoint = l_Shard.m_Acceptor.local_endpoint();
+        } // for
+
+        for (size_t l_Index = 0; l_Index < m_Shards.size(); ++l_Index) {
+            if (m_Shards[l_Index]->m_Acceptor.is_open()) {
+                Shard* l_pShard = m_Shards[l_Index].get();
+                l_pShard->m_IOService.post([this, l_pShard]() { Accept(*l_pShard); });
+            } // if
+        } // for
+
+        return true;
+    }
+
+    /*! \brief  Stop accepting connections, may be called by any thread
+     * 
+     *  Each listening socket is used by the thread running its IOService, thus closing it is posted to that IOService.
+     *  Sessions already handed to their handlers are not affected, pending handshakes are aborted by their timeout.
+     */
+    void Close() {
+        for (auto l_Shard = m_Shards.begin(); l_Shard != m_Shards.end(); ++l_Shard) {
+            Shard* l_pShard = l_Shard->get();
+            l_pShard->m_IOService.post([l_pShard]() {
+                boost::system::error_code l_ErrorCode;
+                l_pShard->m_Acceptor.close(l_ErrorCode);
+            }); // post
+        } // for
+    }
+
+    /*! \brief  Query the local endpoint the acceptor is listening at
+     * 
+     *  \return The local endpoint
+     */
+    boost::asio::ip::tcp::endpoint GetLocalEndpoint() const {
+        boost::system::error_code l_ErrorCode;
+        return m_Shards.front()->m_Acceptor.local_endpoint(l_ErrorCode);
+    }
+
+    uint64_t GetAccepted() const { return m_Accepted.load(); }     //!< The number of accepted connections
+    uint64_t GetDispatched() const { return m_Dispatched.load(); } //!< The number of sessions handed to their handlers
+    uint64_t GetTimedOut() const { return m_TimedOut.load(); }     //!< The number of connections closed by the handshake timeout
+    uint64_t GetRejected() const { return m_Rejected.load(); }     //!< The number of connections closed due to an unhandled session type
+
+private:
+    /*! \struct Shard
+     *  \brief An IOService and its listening socket
+     */
+    struct Shard {
+        explicit Shard(boost::asio::io_service& a_IOService): m_IOService(a_IOService), m_Acceptor(a_IOService) {}
+        boost::asio::io_service& m_IOService;      //!< The boost IOService object
+        boost::asio::ip::tcp::acceptor m_Acceptor; //!< The listening socket, only opened if used
+    };
+
+    /*! \struct Handshake
+     *  \brief A connection waiting for its session header
+     */
+    struct Handshake {
+        Handshake(boost::asio::io_service& a_IOService, boost::asio::ip::tcp::socket& a_TcpSocket): m_IOService(a_IOService),
+            m_FrameEndpoint(std::make_shared<FrameEndpoint>(a_IOService, a_TcpSocket, 0xFF)), m_Timer(a_IOService), m_bDone(false) {}
+        boost::asio::io_service& m_IOService;         //!< The boost IOService object the connection belongs to
+        std::shared_ptr<FrameEndpoint> m_FrameEndpoint; //!< The frame endpoint reading the session header
+        boost::asio::deadline_timer m_Timer;          //!< The handshake timeout
+        bool m_bDone;                                 //!< Indicates whether the session header was received or the connection was closed
+    };
+
+    /*! \brief  Close all listening sockets directly, only if no IOService uses them
+     */
+    void CloseAcceptors() {
+        for (auto l_Shard = m_Shards.begin(); l_Shard != m_Shards.end(); ++l_Shard) {
+            boost::system::error_code l_ErrorCode;
+            (*l_Shard)->m_Acceptor.close(l_ErrorCode);
+        } // for
+    }
+
+    /*! \brief  Accept the next connection
+     * 
+     *  \param  a_Shard the listening shard
+     */
+    void Accept(Shard& a_Shard) {
+        // The accepted connection belongs to this shard, or to the next one round-robin if SO_REUSEPORT is not available
+        Shard* l_pTarget = &a_Shard;
+#ifndef SO_REUSEPORT
+        l_pTarget = m_Shards[m_NextShard++ % m_Shards.size()].get();
+#endif
+        auto l_TcpSocket = std::make_shared<boost::asio::ip::tcp::socket>(l_pTarget->m_IOService);
+        a_Shard.m_Acceptor.async_accept(*l_TcpSocket, [this, &a_Shard, l_pTarget, l_TcpSocket](const boost::system::error_code& a_ErrorCode) {
+            if (a_ErrorCode == boost::asio::error::operation_aborted) {
+                return;
+            } // if
+
+            if (!a_ErrorCode) {
+                ++m_Accepted;
+                l_pTarget->m_IOService.post([this, l_pTarget, l_TcpSocket]() { StartHandshake(*l_pTarget, *l_TcpSocket); });
+            } // if
+
+            if (a_Shard.m_Acceptor.is_open()) {
+                Accept(a_Shard);
+            } // if
+        }); // async_accept
+    }
+
+    /*! \brief  Read the session header of an accepted connection
+     * 
+     *  \param  a_Shard the shard the connection belongs to
+     *  \param  a_TcpSocket the accepted connection
+     */
+    void StartHandshake(Shard& a_Shard, boost::asio::ip::tcp::socket& a_TcpSocket) {
+        // Only the timer keeps the handshake alive, thus all other callbacks refer to it weakly
+        auto l_Handshake = std::make_shared<Handshake>(a_Shard.m_IOService, a_TcpSocket);
+        std::weak_ptr<Handshake> l_WeakHandshake(l_Handshake);
+        l_Handshake->m_FrameEndpoint->RegisterFrameFactory(0x00, []()->std::shared_ptr<Frame>{ return HdlcdSessionHeader::CreateDeserializedFrame(); });
+        l_Handshake->m_FrameEndpoint->RegisterFrameFactory(0x01, []()->std::shared_ptr<Frame>{ return HdlcdSessionHeader::CreateDeserializedFrame(); });
+        l_Handshake->m_FrameEndpoint->SetOnFrameCallback([this, l_WeakHandshake](std::shared_ptr<Frame> a_Frame)->bool {
+            auto l_Handshake = l_WeakHandshake.lock();
+            if ((l_Handshake) && (!l_Handshake->m_bDone)) {
+                l_Handshake->m_bDone = true;
+                l_Handshake->m_Timer.cancel();
+
+                // The handler replaces the callbacks of the frame endpoint, thus it must not be called from within one of them
+                auto l_SessionHeader = std::dynamic_pointer_cast<HdlcdSessionHeader>(a_Frame);
+                l_Handshake->m_IOService.post([this, l_Handshake, l_SessionHeader]() { Dispatch(*l_Handshake, l_SessionHeader); });
+            } // if
+
+            return false; // Stall until the handler takes over
+        });
+        l_Handshake->m_FrameEndpoint->SetOnClosedCallback([l_WeakHandshake]() {
+            auto l_Handshake = l_WeakHandshake.lock();
+            if ((l_Handshake) && (!l_Handshake->m_bDone)) {
+                l_Handshake->m_bDone = true;
+                l_Handshake->m_Timer.cancel();
+            } // if
+        });
+
+        l_Handshake->m_Timer.expires_from_now(boost::posix_time::milliseconds(m_HandshakeTimeout));
+        l_Handshake->m_Timer.async_wait([this, l_Handshake](const boost::system::error_code& a_ErrorCode) {
+            if ((!a_ErrorCode) && (!l_Handshake->m_bDone)) {
+                l_Handshake->m_bDone = true;
+                ++m_TimedOut;
+                l_Handshake->m_FrameEndpoint->Close();
+            } // if
+        }); // async_wait
+
+        l_Handshake->m_FrameEndpoint->Start();
+    }
+
+    /*! \brief  Hand a received session header to the handler of its session type
+     * 
+     *  \param  a_Handshake the completed handshake
+     *  \param  a_SessionHeader the received session header
+     */
+    void Dispatch(Handshake& a_Handshake, std::shared_ptr<HdlcdSessionHeader> a_SessionHeader) {
+        const uint8_t l_ServiceAccessPointSpecifier = a_SessionHeader->GetServiceAccessPointSpecifier();
+        const HdlcdSessionDescriptor l_SessionDescriptor(l_ServiceAccessPointSpecifier);
+        if ((uint8_t(l_SessionDescriptor) == SESSION_TYPE_UNSET) || (!m_SessionHandlers[l_SessionDescriptor.GetSessionType() >> 4])) {
+            ++m_Rejected;
+            a_Handshake.m_FrameEndpoint->Close();
+            return;
+        } // if
+
+        ++m_Dispatched;
+        m_SessionHandlers[l_SessionDescriptor.GetSessionType() >> 4](a_Handshake.m_IOService, a_Handshake.m_FrameEndpoint, a_SessionHeader);
+    }
+
+    // Members
+    unsigned int m_HandshakeTimeout; //!< The time a new connection has to deliver its session header, in milliseconds
+    int m_FastOpenQueueLength;       //!< The maximum number of pending TCP Fast Open requests, zero if disabled
+    std::atomic<size_t> m_NextShard; //!< The shard to hand the next connection to, if SO_REUSEPORT is not available
+    std::atomic<uint64_t> m_Accepted;
+    std::atomic<uint64_t> m_Dispatched;
+    std::atomic<uint64_t> m_TimedOut;
+    std::atomic<uint64_t> m_Rejected;
+    std::vector<SessionHandler> m_SessionHandlers; //!< The handlers, indexed by the session type
+    std::vector<std::unique_ptr<Shard>> m_Shards;  //!< The IOServices and their listening sockets
+};
+
+#endif // HDLCD_SESSION_ACCEPTOR_H
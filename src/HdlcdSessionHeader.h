@@ -42,13 +42,23 @@
 #include "Frame.h"
 #include <memory>
 #include <string>
+#include <vector>
 #include "HdlcdSessionDescriptor.h"
+#include "HdlcdPacketFilter.h"
+#include "HdlcdPortPattern.h"
+#include "HdlcdWireSchema.h"
 
 /*! \class HdlcdSessionHeader
  *  \brief Class HdlcdSessionHeader
  * 
  *  This class implements the session header as specified in the HDLCd access protocol. It inherits from
  *  the Frame class and thus allows easy exchange via FrameEndpoint entities.
+ * 
+ *  Version 0 consists of the version octet, the service access point specifier, and the length-prefixed serial port
+ *  name. Version 1 appends an extension: a 16 bit length in network byte order followed by a sequence of TLVs, each
+ *  consisting of a type octet, a 16 bit length in network byte order, and the value. Unknown TLVs are skipped. Version 1
+ *  is only used if an extension is present, thus peers unaware of it are not affected. As the version octet is the
+ *  first octet, receivers must register frame factories for both 0x00 and 0x01.
  */
 class HdlcdSessionHeader: public Frame {
 public:
@@ -67,6 +77,64 @@ public:
         return l_HdlcdSessionHeader;
     }
 
+    /*! \brief  Static creator to create an object in the process of transmission, carrying a filter program
+     *
+     *  \param  a_HdlcdSessionDescriptor the service access point specifier octett
+     *  \param  a_SerialPortName the file name of the serial port
+     *  \param  a_PacketFilter the filter program the HDLCd has to apply to data packets before sending
+     * 
+     *  \return The created HDLCd session header object
+     */
+    static HdlcdSessionHeader Create(HdlcdSessionDescriptor a_HdlcdSessionDescriptor, const std::string& a_SerialPortName, const HdlcdPacketFilter& a_PacketFilter) {
+        // Called for transmission
+        HdlcdSessionHeader l_HdlcdSessionHeader(Create(a_HdlcdSessionDescriptor, a_SerialPortName));
+        l_HdlcdSessionHeader.m_PacketFilter = a_PacketFilter;
+        return l_HdlcdSessionHeader;
+    }
+
+    /*! \brief  Static creator to create an object in the process of transmission, opening a multi-port session
+     *
+     *  Data packets of multi-port sessions carry a port index, which is resolved via a port table sent by the HDLCd on
+     *  the data socket at session start. The serial port name may be left empty.
+     *
+     *  \param  a_HdlcdSessionDescriptor the service access point specifier octett
+     *  \param  a_SerialPortName the file name of the serial port
+     *  \param  a_PacketFilter the filter program the HDLCd has to apply to data packets before sending
+     *  \param  a_PortPatterns the names or globs of all serial ports of the session, see HdlcdPortPattern::IsValid() for the limits
+     * 
+     *  \return The created HDLCd session header object
+     */
+    static HdlcdSessionHeader Create(HdlcdSessionDescriptor a_HdlcdSessionDescriptor, const std::string& a_SerialPortName, const HdlcdPacketFilter& a_PacketFilter,
+                                     const std::vector<std::string>& a_PortPatterns) {
+        // Called for transmission. Patterns exceeding the limits are not transmitted, see Serialize()
+        assert(HdlcdPortPattern::IsValid(a_PortPatterns));
+        HdlcdSessionHeader l_HdlcdSessionHeader(Create(a_HdlcdSessionDescriptor, a_SerialPortName, a_PacketFilter));
+        l_HdlcdSessionHeader.m_PortPatterns = a_PortPatterns;
+        return l_HdlcdSessionHeader;
+    }
+
+    /*! \brief  Static creator to create an object in the process of transmission, requesting sequence numbers
+     *
+     *  Data packets of sessions with sequence numbers carry a sequence number assigned by the HDLCd, thus a client is able
+     *  to detect data packets dropped on the way. Requesting sequence numbers requires an HDLCd supporting version 1 of
+     *  the session header.
+     *
+     *  \param  a_HdlcdSessionDescriptor the service access point specifier octett
+     *  \param  a_SerialPortName the file name of the serial port
+     *  \param  a_PacketFilter the filter program the HDLCd has to apply to data packets before sending
+     *  \param  a_PortPatterns the names or globs of all serial ports of the session, see HdlcdPortPattern
+     *  \param  a_bSequenceNumbers indicates whether data packets of this session have to carry sequence numbers
+     * 
+     *  \return The created HDLCd session header object
+     */
+    static HdlcdSessionHeader Create(HdlcdSessionDescriptor a_HdlcdSessionDescriptor, const std::string& a_SerialPortName, const HdlcdPacketFilter& a_PacketFilter,
+                                     const std::vector<std::string>& a_PortPatterns, bool a_bSequenceNumbers) {
+        // Called for transmission
+        HdlcdSessionHeader l_HdlcdSessionHeader(Create(a_HdlcdSessionDescriptor, a_SerialPortName, a_PacketFilter, a_PortPatterns));
+        l_HdlcdSessionHeader.m_bSequenceNumbers = a_bSequenceNumbers;
+        return l_HdlcdSessionHeader;
+    }
+
     /*! \brief  Static creator to create an object in the process of reception
      * 
      *  \return The created but empty HDLCd session header object
@@ -75,7 +143,7 @@ public:
         // Called on reception
         auto l_HdlcdSessionHeader(std::shared_ptr<HdlcdSessionHeader>(new HdlcdSessionHeader));
         l_HdlcdSessionHeader->m_eDeserialize = DESERIALIZE_HEADER; // Next: read fixed-sized part of the session header
-        l_HdlcdSessionHeader->m_BytesRemaining = 3;
+        l_HdlcdSessionHeader->m_BytesRemaining = HeaderLayout::SIZE;
         return l_HdlcdSessionHeader;
     }
     
@@ -97,12 +165,137 @@ public:
         return m_SerialPortName;
     }
 
+    /*! \brief  Query the version of the session header
+     * 
+     *  \return The version of the session header, 1 if an extension is present, 0 otherwise
+     */
+    uint8_t GetVersion() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_Version;
+    }
+
+    /*! \brief  Query the filter program to apply to data packets before sending
+     * 
+     *  \return The filter program, empty if all data packets are to be delivered
+     */
+    const HdlcdPacketFilter& GetPacketFilter() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_PacketFilter;
+    }
+
+    /*! \brief  Query the port patterns of a multi-port session
+     * 
+     *  \return The names or globs of all serial ports of the session, empty if this is not a multi-port session
+     */
+    const std::vector<std::string>& GetPortPatterns() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_PortPatterns;
+    }
+
+    /*! \brief  Query whether data packets of this session have to carry sequence numbers
+     * 
+     *  \return Indicates whether data packets of this session have to carry sequence numbers
+     */
+    bool GetSequenceNumbers() const {
+        assert(m_eDeserialize == DESERIALIZE_FULL);
+        return m_bSequenceNumbers;
+    }
+
+    /*! \enum E_TLV_TYPE
+     *  \brief The enum E_TLV_TYPE to specify the TLVs of the extension of version 1
+     */
+    typedef enum {
+        TLV_TYPE_PACKET_FILTER = 0x01, //!< The filter program, see HdlcdPacketFilter
+        TLV_TYPE_PORT_PATTERNS = 0x02, //!< The port patterns of a multi-port session, each prefixed by its length octet
+        TLV_TYPE_SEQUENCE_NUMBERS = 0x03 //!< Request sequence numbers in data packets, without a value
+    } E_TLV_TYPE;
+
 private:
+    // The wire format: the fixed-size header, the length field of the extension, and the header of each TLV
+    typedef HdlcdWireField<0, 1> HeaderVersion;
+    typedef HdlcdWireField<1, 1> HeaderServiceAccessPointSpecifier;
+    typedef HdlcdWireField<2, 1> HeaderPortNameLength;
+    typedef HdlcdWireLayout<HeaderVersion, HeaderServiceAccessPointSpecifier, HeaderPortNameLength> HeaderLayout;
+    typedef HdlcdWireField<0, 2> ExtensionLength;
+    typedef HdlcdWireLayout<ExtensionLength> ExtensionLengthLayout;
+    typedef HdlcdWireField<0, 1> TlvType;
+    typedef HdlcdWireField<1, 2> TlvLength;
+    typedef HdlcdWireLayout<TlvType, TlvLength> TlvLayout;
+
     /*! \brief  The default constructor
      * 
      *  The default constructor is private. To create an object one has to use one of the static creator methods
      */
-    HdlcdSessionHeader(): m_ServiceAccessPointSpecifier(0x00), m_eDeserialize(DESERIALIZE_FULL) {
+    HdlcdSessionHeader(): m_Version(0x00), m_ServiceAccessPointSpecifier(0x00), m_bSequenceNumbers(false), m_eDeserialize(DESERIALIZE_FULL) {
+    }
+
+    /*! \brief  Query whether an extension has to be transmitted
+     * 
+     *  \return Indicates whether version 1 with an extension has to be transmitted
+     */
+    bool HasExtension() const {
+        return ((!m_PacketFilter.IsEmpty()) || (!m_PortPatterns.empty()) || (m_bSequenceNumbers));
+    }
+
+    /*! \brief  Append a TLV to a buffer
+     * 
+     *  \param  a_Buffer the buffer to append to
+     *  \param  a_eTlvType the type of the TLV
+     *  \param  a_Value the value of the TLV
+     */
+    static void AppendTlv(std::vector<unsigned char>& a_Buffer, E_TLV_TYPE a_eTlvType, const std::vector<unsigned char>& a_Value) {
+        unsigned char* l_Tlv = TlvLayout::Append(a_Buffer);
+        TlvLayout::Encode<TlvType>(l_Tlv, a_eTlvType);
+        TlvLayout::Encode<TlvLength>(l_Tlv, a_Value.size());
+        a_Buffer.insert(a_Buffer.end(), a_Value.begin(), a_Value.end());
+    }
+
+    /*! \brief  Parse the TLVs of the extension
+     * 
+     *  \retval true the extension was parsed, unknown TLVs were skipped
+     *  \retval false the extension is malformed
+     *  \return Indicates whether the extension was parsed
+     */
+    bool DeserializeExtension() {
+        size_t l_Offset = 0;
+        while (l_Offset < m_Buffer.size()) {
+            if ((m_Buffer.size() - l_Offset) < TlvLayout::SIZE) {
+                return false;
+            } // if
+
+            const uint8_t l_TlvType = TlvLayout::Decode<TlvType>(m_Buffer.data() + l_Offset);
+            const size_t l_TlvLength = TlvLayout::Decode<TlvLength>(m_Buffer.data() + l_Offset);
+            l_Offset += TlvLayout::SIZE;
+            if ((m_Buffer.size() - l_Offset) < l_TlvLength) {
+                return false;
+            } // if
+
+            const unsigned char* l_Value = (m_Buffer.data() + l_Offset);
+            switch (l_TlvType) {
+            case TLV_TYPE_PACKET_FILTER:
+                if (!m_PacketFilter.Deserialize(l_Value, l_TlvLength)) {
+                    return false;
+                } // if
+
+                break;
+            case TLV_TYPE_PORT_PATTERNS:
+                if (!DeserializePortPatterns(l_Value, l_TlvLength)) {
+                    return false;
+                } // if
+
+                break;
+            case TLV_TYPE_SEQUENCE_NUMBERS:
+                m_bSequenceNumbers = true;
+                break;
+            default:
+                // Unknown TLV, skip it
+                break;
+            } // switch
+
+            l_Offset += l_TlvLength;
+        } // while
+
+        return true;
     }
 
     /*! \brief  The serializer
@@ -114,10 +307,45 @@ private:
     const std::vector<unsigned char> Serialize() const {
         assert(m_eDeserialize == DESERIALIZE_FULL);
         std::vector<unsigned char> l_Buffer;
-        l_Buffer.emplace_back(0x00); // Version
-        l_Buffer.emplace_back(m_ServiceAccessPointSpecifier);
-        l_Buffer.emplace_back(m_SerialPortName.size());
+        const bool l_bHasExtension = HasExtension();
+        unsigned char* l_Header = HeaderLayout::Append(l_Buffer);
+        HeaderLayout::Encode<HeaderVersion>(l_Header, (l_bHasExtension ? 0x01 : 0x00));
+        HeaderLayout::Encode<HeaderServiceAccessPointSpecifier>(l_Header, m_ServiceAccessPointSpecifier);
+        HeaderLayout::Encode<HeaderPortNameLength>(l_Header, m_SerialPortName.size());
         l_Buffer.insert(l_Buffer.end(), m_SerialPortName.data(), (m_SerialPortName.data() + m_SerialPortName.size()));
+        if (l_bHasExtension) {
+            std::vector<unsigned char> l_Extension;
+            if (!m_PacketFilter.IsEmpty()) {
+                std::vector<unsigned char> l_Value;
+                m_PacketFilter.Serialize(l_Value);
+                AppendTlv(l_Extension, TLV_TYPE_PACKET_FILTER, l_Value);
+            } // if
+
+            if (!m_PortPatterns.empty()) {
+                // Patterns are length-prefixed by a single octet: skip overlong ones instead of truncating them, and stop at MAX_PATTERNS
+                std::vector<unsigned char> l_Value;
+                size_t l_Count = 0;
+                for (auto l_PortPattern = m_PortPatterns.begin(); (l_PortPattern != m_PortPatterns.end()) && (l_Count < HdlcdPortPattern::MAX_PATTERNS); ++l_PortPattern) {
+                    if (l_PortPattern->size() > HdlcdPortPattern::MAX_LENGTH) {
+                        continue;
+                    } // if
+
+                    ++l_Count;
+                    l_Value.emplace_back(static_cast<unsigned char>(l_PortPattern->size()));
+                    l_Value.insert(l_Value.end(), l_PortPattern->begin(), l_PortPattern->end());
+                } // for
+
+                AppendTlv(l_Extension, TLV_TYPE_PORT_PATTERNS, l_Value);
+            } // if
+
+            if (m_bSequenceNumbers) {
+                AppendTlv(l_Extension, TLV_TYPE_SEQUENCE_NUMBERS, std::vector<unsigned char>());
+            } // if
+
+            ExtensionLengthLayout::Encode<ExtensionLength>(ExtensionLengthLayout::Append(l_Buffer), l_Extension.size());
+            l_Buffer.insert(l_Buffer.end(), l_Extension.begin(), l_Extension.end());
+        } // if
+
         return l_Buffer;
     }
 
@@ -133,25 +361,26 @@ private:
         // All requested bytes are available
         switch (m_eDeserialize) {
         case DESERIALIZE_HEADER: {
-            // Deserialize the length field
-            assert(m_Buffer.size() == 3);
+            // Deserialize the fixed-size header
+            assert(m_Buffer.size() == HeaderLayout::SIZE);
 
             // Deserialize the version field
-            if (m_Buffer[0] != 0) {
+            if (HeaderLayout::Decode<HeaderVersion>(m_Buffer.data()) > 0x01) {
                 // Wrong version field
                 m_eDeserialize = DESERIALIZE_ERROR;
                 return false;
             } // if
             
             // Deserialize the service access point identifier and the length field of the serial port name
-            m_ServiceAccessPointSpecifier = m_Buffer[1];
-            m_BytesRemaining = m_Buffer[2];
+            m_Version = HeaderLayout::Decode<HeaderVersion>(m_Buffer.data());
+            m_ServiceAccessPointSpecifier = HeaderLayout::Decode<HeaderServiceAccessPointSpecifier>(m_Buffer.data());
+            m_BytesRemaining = HeaderLayout::Decode<HeaderPortNameLength>(m_Buffer.data());
             m_Buffer.clear();
             if (m_BytesRemaining) {
                 m_eDeserialize = DESERIALIZE_BODY;
             } else {
                 // An empty serial port specifier... may happen
-                m_eDeserialize = DESERIALIZE_FULL;
+                ExpectExtension();
             } // else
 
             break;
@@ -159,6 +388,26 @@ private:
         case DESERIALIZE_BODY: {
             // Read of payload completed
             m_SerialPortName.append(m_Buffer.begin(), m_Buffer.end());
+            m_Buffer.clear();
+            ExpectExtension();
+            break;
+        }
+        case DESERIALIZE_EXTENSION_LENGTH: {
+            // Deserialize the length field of the extension
+            assert(m_Buffer.size() == ExtensionLengthLayout::SIZE);
+            m_BytesRemaining = ExtensionLengthLayout::Decode<ExtensionLength>(m_Buffer.data());
+            m_Buffer.clear();
+            m_eDeserialize = (m_BytesRemaining ? DESERIALIZE_EXTENSION : DESERIALIZE_FULL);
+            break;
+        }
+        case DESERIALIZE_EXTENSION: {
+            // Read of the extension completed
+            if (!DeserializeExtension()) {
+                m_eDeserialize = DESERIALIZE_ERROR;
+                return false;
+            } // if
+
+            m_Buffer.clear();
             m_eDeserialize = DESERIALIZE_FULL;
             break;
         }
@@ -171,10 +420,48 @@ private:
         // No error
         return true;
     }
+
+    /*! \brief  Parse the port patterns of a multi-port session
+     * 
+     *  \param  a_Value the value of the TLV
+     *  \param  a_Length the length of the value
+     * 
+     *  \return Indicates whether the port patterns were parsed
+     */
+    bool DeserializePortPatterns(const unsigned char* a_Value, size_t a_Length) {
+        m_PortPatterns.clear();
+        size_t l_Offset = 0;
+        while (l_Offset < a_Length) {
+            const size_t l_PatternLength = a_Value[l_Offset++];
+            if ((a_Length - l_Offset) < l_PatternLength) {
+                return false;
+            } // if
+
+            m_PortPatterns.emplace_back(reinterpret_cast<const char*>(a_Value + l_Offset), l_PatternLength);
+            l_Offset += l_PatternLength;
+        } // while
+
+        return true;
+    }
+
+    /*! \brief  Continue with the extension if announced by the version field, otherwise the session header is complete
+     */
+    void ExpectExtension() {
+        if (m_Version == 0x01) {
+            m_eDeserialize = DESERIALIZE_EXTENSION_LENGTH;
+            m_BytesRemaining = ExtensionLengthLayout::SIZE;
+        } else {
+            m_eDeserialize = DESERIALIZE_FULL;
+        } // else
+    }
     
     // Internal members
+    uint8_t m_Version;                     //!< The version of the session header
     uint8_t m_ServiceAccessPointSpecifier; //!< The service access point specifier octett
     std::string m_SerialPortName;          //!< The file name of the serial port
+    HdlcdPacketFilter m_PacketFilter;      //!< The filter program to apply to data packets, part of the extension
+    std::vector<std::string> m_PortPatterns; //!< The port patterns of a multi-port session, part of the extension
+    bool m_bSequenceNumbers;               //!< Indicates whether data packets have to carry sequence numbers, part of the extension
     
     /*! \enum E_DESERIALIZE
      *  \brief The enum E_DESERIALIZE to specify the progress of deserialization
@@ -183,7 +470,9 @@ private:
         DESERIALIZE_ERROR  = 0,            //!< An error occured
         DESERIALIZE_HEADER = 1,            //!< Currently the header of the HDLCd session header is deserialized
         DESERIALIZE_BODY   = 2,            //!< Currently the body of the HDLCd session header is deserialized
-        DESERIALIZE_FULL   = 3             //!< The HDLCd session header is complete
+        DESERIALIZE_FULL   = 3,            //!< The HDLCd session header is complete
+        DESERIALIZE_EXTENSION_LENGTH = 4,  //!< Currently the length field of the extension is deserialized
+        DESERIALIZE_EXTENSION = 5          //!< Currently the TLVs of the extension are deserialized
     } E_DESERIALIZE;
     E_DESERIALIZE m_eDeserialize;          //!< The state in the progress of deserialization
 };
@@ -0,0 +1,235 @@
+/**
+ * \file      HdlcdSubmissionQueue.h
+ * \brief     This file contains the header declaration of class HdlcdSubmissionQueue
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_SUBMISSION_QUEUE_H
+#define HDLCD_SUBMISSION_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \class HdlcdSubmissionQueue
+ *  \brief Class HdlcdSubmissionQueue
+ * 
+ *  A bounded lock-free queue for multiple producer threads and a single consumer thread, based on the array-based
+ *  queue by Dmitry Vyukov: each slot carries a sequence number that tells producers and the consumer whether the slot
+ *  is free or filled, thus a push costs a single compare-and-swap in the uncontended case and no memory is allocated.
+ *  
+ *  Additionally, the queue keeps track of whether the consumer was already woken up, so that producers schedule only
+ *  one wakeup per batch of items, and it provides counters to measure depth and contention.
+ */
+template <class T>
+class HdlcdSubmissionQueue {
+public:
+    /*! \brief  The constructor of HdlcdSubmissionQueue objects
+     * 
+     *  \param  a_Capacity the minimum number of items the queue can hold, rounded up to the next power of two
+     */
+    explicit HdlcdSubmissionQueue(size_t a_Capacity): m_Mask(RoundUp(a_Capacity) - 1), m_Cells(new Cell[m_Mask + 1]), m_EnqueuePosition(0),
+        m_DequeuePosition(0), m_bWakeupPending(false), m_MaxDepth(0), m_Contention(0), m_Rejected(0), m_Wakeups(0) {
+        for (size_t l_Index = 0; l_Index <= m_Mask; ++l_Index) {
+            m_Cells[l_Index].m_Sequence.store(l_Index, std::memory_order_relaxed);
+        } // for
+    }
+
+    /*! \brief  Append an item, may be called by any thread
+     * 
+     *  \param  a_Item the item to append, moved into the queue on success only
+     * 
+     *  \retval true the item was appended
+     *  \retval false the queue is full
+     *  \return Indicates whether the item was appended
+     */
+    bool Push(T&& a_Item) {
+        Cell* l_Cell;
+        size_t l_Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            l_Cell = &m_Cells[l_Position & m_Mask];
+            const size_t l_Sequence = l_Cell->m_Sequence.load(std::memory_order_acquire);
+            const intptr_t l_Difference = (intptr_t(l_Sequence) - intptr_t(l_Position));
+            if (l_Difference == 0) {
+                if (m_EnqueuePosition.compare_exchange_weak(l_Position, (l_Position + 1), std::memory_order_relaxed)) {
+                    break;
+                } // if
+
+                m_Contention.fetch_add(1, std::memory_order_relaxed);
+            } else if (l_Difference < 0) {
+                m_Rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // Another producer claimed this slot meanwhile
+                m_Contention.fetch_add(1, std::memory_order_relaxed);
+                l_Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+            } // else
+        } // while
+
+        l_Cell->m_Item = std::move(a_Item);
+        l_Cell->m_Sequence.store((l_Position + 1), std::memory_order_release);
+
+        // Track the high-water mark
+        const size_t l_Depth = std::min(((l_Position + 1) - m_DequeuePosition.load(std::memory_order_relaxed)), (m_Mask + 1));
+        size_t l_MaxDepth = m_MaxDepth.load(std::memory_order_relaxed);
+        while ((l_Depth > l_MaxDepth) && (!m_MaxDepth.compare_exchange_weak(l_MaxDepth, l_Depth, std::memory_order_relaxed))) {
+        } // while
+
+        return true;
+    }
+
+    /*! \brief  Take the oldest item, must only be called by the consumer thread
+     * 
+     *  \param  a_Item the item taken from the queue
+     * 
+     *  \retval true an item was taken from the queue
+     *  \retval false the queue is empty, or the oldest item is still being written by its producer
+     *  \return Indicates whether an item was taken from the queue
+     */
+    bool Pop(T& a_Item) {
+        const size_t l_Position = m_DequeuePosition.load(std::memory_order_relaxed);
+        Cell* l_Cell = &m_Cells[l_Position & m_Mask];
+        const size_t l_Sequence = l_Cell->m_Sequence.load(std::memory_order_acquire);
+        if (intptr_t(l_Sequence) - intptr_t(l_Position + 1) < 0) {
+            return false;
+        } // if
+
+        a_Item = std::move(l_Cell->m_Item);
+        l_Cell->m_Item = T();
+        l_Cell->m_Sequence.store((l_Position + m_Mask + 1), std::memory_order_release);
+        m_DequeuePosition.store((l_Position + 1), std::memory_order_relaxed);
+        return true;
+    }
+
+    /*! \brief  Mark the consumer as woken up, called by producers after a successful push
+     * 
+     *  The push and the check of the flag must not be reordered against EndBatch() clearing the flag and checking for
+     *  items, thus both sides are separated by a sequentially consistent fence.
+     * 
+     *  \retval true the caller has to wake up the consumer
+     *  \retval false the consumer was already woken up and will see the item
+     *  \return Indicates whether the caller has to wake up the consumer
+     */
+    bool RequestWakeup() {
+        // Pairs with the fence in EndBatch(): either the consumer sees the pushed item, or this producer sees the cleared flag
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_bWakeupPending.load(std::memory_order_relaxed) || m_bWakeupPending.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        } // if
+
+        m_Wakeups.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*! \brief  End a batch of the consumer after the queue was drained
+     * 
+     *  Items pushed concurrently with this call are never lost: either their producer schedules a new wakeup or the
+     *  consumer is told to continue.
+     * 
+     *  \retval true items arrived meanwhile, the consumer has to continue draining
+     *  \retval false the consumer may go to sleep
+     *  \return Indicates whether the consumer has to continue
+     */
+    bool EndBatch() {
+        m_bWakeupPending.store(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const size_t l_Position = m_DequeuePosition.load(std::memory_order_relaxed);
+        if (intptr_t(m_Cells[l_Position & m_Mask].m_Sequence.load(std::memory_order_seq_cst)) - intptr_t(l_Position + 1) < 0) {
+            return false;
+        } // if
+
+        // Take over the wakeup again, unless a producer did so already
+        return (!m_bWakeupPending.exchange(true, std::memory_order_acq_rel));
+    }
+
+    /*! \brief  Query the number of items in the queue, approximate while producers are active
+     * 
+     *  \return The number of items in the queue
+     */
+    size_t GetDepth() const {
+        const size_t l_DequeuePosition = m_DequeuePosition.load(std::memory_order_relaxed);
+        const size_t l_EnqueuePosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+        return ((l_EnqueuePosition >= l_DequeuePosition) ? (l_EnqueuePosition - l_DequeuePosition) : 0);
+    }
+
+    size_t GetCapacity() const { return (m_Mask + 1); }                                            //!< The number of slots
+    size_t GetMaxDepth() const { return m_MaxDepth.load(std::memory_order_relaxed); }              //!< The highest depth observed
+    uint64_t GetContention() const { return m_Contention.load(std::memory_order_relaxed); }        //!< The number of retries of producers due to other producers
+    uint64_t GetRejected() const { return m_Rejected.load(std::memory_order_relaxed); }            //!< The number of pushes failed due to a full queue
+    uint64_t GetWakeups() const { return m_Wakeups.load(std::memory_order_relaxed); }              //!< The number of wakeups scheduled by producers
+
+private:
+    /*! \struct Cell
+     *  \brief A slot of the queue
+     */
+    struct Cell {
+        std::atomic<size_t> m_Sequence; //!< Equal to the position if free, the position plus one if filled
+        T m_Item;
+    };
+
+    /*! \brief  Round up to the next power of two
+     * 
+     *  \param  a_Value the value to round up, at least 2 is returned
+     * 
+     *  \return The next power of two
+     */
+    static size_t RoundUp(size_t a_Value) {
+        size_t l_Power = 2;
+        while (l_Power < a_Value) {
+            l_Power <<= 1;
+        } // while
+
+        return l_Power;
+    }
+
+    // Members, positions of producers and the consumer on separate cache lines to avoid false sharing
+    const size_t m_Mask;
+    std::unique_ptr<Cell[]> m_Cells;
+    char m_Padding1[64];
+    std::atomic<size_t> m_EnqueuePosition;
+    char m_Padding2[64];
+    std::atomic<size_t> m_DequeuePosition;
+    char m_Padding3[64];
+    std::atomic<bool> m_bWakeupPending;
+    std::atomic<size_t> m_MaxDepth;
+    std::atomic<uint64_t> m_Contention;
+    std::atomic<uint64_t> m_Rejected;
+    std::atomic<uint64_t> m_Wakeups;
+};
+
+#endif // HDLCD_SUBMISSION_QUEUE_H
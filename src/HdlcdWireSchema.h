@@ -0,0 +1,291 @@
+/**
+ * \file      HdlcdWireSchema.h
+ * \brief     This file contains the declaration of the compile-time wire format schema of the HDLCd access protocol
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HDLCD_WIRE_SCHEMA_H
+#define HDLCD_WIRE_SCHEMA_H
+
+#include <type_traits>
+#include <vector>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \class HdlcdWireUint
+ *  \brief Class HdlcdWireUint
+ * 
+ *  Selects the smallest unsigned integer type able to hold a field of the specified number of octets
+ */
+template<size_t Octets> struct HdlcdWireUint { typedef uint64_t Type; };
+template<> struct HdlcdWireUint<1> { typedef uint8_t  Type; };
+template<> struct HdlcdWireUint<2> { typedef uint16_t Type; };
+template<> struct HdlcdWireUint<3> { typedef uint32_t Type; };
+template<> struct HdlcdWireUint<4> { typedef uint32_t Type; };
+
+/*! \class HdlcdWireOctets
+ *  \brief Class HdlcdWireOctets
+ * 
+ *  Encodes and decodes unsigned integers of a fixed number of octets in network byte order. The recursion is resolved at
+ *  compile time, thus each access is unrolled to single octet operations without loops and without alignment requirements.
+ */
+template<size_t Octets> struct HdlcdWireOctets {
+    static void Encode(unsigned char* a_Buffer, uint64_t a_Value) {
+        a_Buffer[Octets - 1] = static_cast<unsigned char>(a_Value & 0xFF);
+        HdlcdWireOctets<Octets - 1>::Encode(a_Buffer, (a_Value >> 8));
+    }
+
+    static uint64_t Decode(const unsigned char* a_Buffer) {
+        return ((HdlcdWireOctets<Octets - 1>::Decode(a_Buffer) << 8) | a_Buffer[Octets - 1]);
+    }
+};
+
+template<> struct HdlcdWireOctets<0> {
+    static void Encode(unsigned char*, uint64_t) {}
+    static uint64_t Decode(const unsigned char*) { return 0; }
+};
+
+/*! \class HdlcdWireField
+ *  \brief Class HdlcdWireField
+ * 
+ *  An unsigned integer field of a fixed-size block in network byte order
+ * 
+ *  \tparam Offset the offset of the first octet of the field within the block
+ *  \tparam Octets the number of octets of the field
+ */
+template<size_t Offset, size_t Octets> struct HdlcdWireField {
+    static_assert(((Octets >= 1) && (Octets <= 8)), "A field must occupy between 1 and 8 octets");
+    typedef typename HdlcdWireUint<Octets>::Type ValueType;
+    static const size_t  OFFSET = Offset;
+    static const size_t  SIZE   = Octets;
+    static const uint8_t MASK   = 0xFF;
+
+    static void Encode(unsigned char* a_Buffer, ValueType a_Value) {
+        HdlcdWireOctets<Octets>::Encode((a_Buffer + Offset), a_Value);
+    }
+
+    static ValueType Decode(const unsigned char* a_Buffer) {
+        return static_cast<ValueType>(HdlcdWireOctets<Octets>::Decode(a_Buffer + Offset));
+    }
+};
+
+/*! \class HdlcdWireBits
+ *  \brief Class HdlcdWireBits
+ * 
+ *  A group of bits within a single octet of a fixed-size block. Values are not shifted, i.e., they are given as masked octets.
+ * 
+ *  \tparam Offset the offset of the octet within the block
+ *  \tparam Mask the bits of the octet occupied by the field
+ */
+template<size_t Offset, uint8_t Mask> struct HdlcdWireBits {
+    static_assert((Mask != 0), "A bit field must occupy at least one bit");
+    typedef uint8_t ValueType;
+    static const size_t  OFFSET = Offset;
+    static const size_t  SIZE   = 1;
+    static const uint8_t MASK   = Mask;
+
+    static void Encode(unsigned char* a_Buffer, ValueType a_Value) {
+        assert((a_Value & ~Mask) == 0);
+        a_Buffer[Offset] = static_cast<unsigned char>((a_Buffer[Offset] & ~Mask) | (a_Value & Mask));
+    }
+
+    static ValueType Decode(const unsigned char* a_Buffer) {
+        return (a_Buffer[Offset] & Mask);
+    }
+};
+
+/*! \class HdlcdWireFlag
+ *  \brief Class HdlcdWireFlag
+ * 
+ *  A single bit within a single octet of a fixed-size block
+ * 
+ *  \tparam Offset the offset of the octet within the block
+ *  \tparam Mask the bit of the octet occupied by the flag
+ */
+template<size_t Offset, uint8_t Mask> struct HdlcdWireFlag {
+    static_assert(((Mask != 0) && ((Mask & (Mask - 1)) == 0)), "A flag must occupy exactly one bit");
+    typedef bool ValueType;
+    static const size_t  OFFSET = Offset;
+    static const size_t  SIZE   = 1;
+    static const uint8_t MASK   = Mask;
+
+    static void Encode(unsigned char* a_Buffer, ValueType a_bValue) {
+        a_Buffer[Offset] = static_cast<unsigned char>((a_Buffer[Offset] & ~Mask) | (a_bValue ? Mask : 0x00));
+    }
+
+    static ValueType Decode(const unsigned char* a_Buffer) {
+        return ((a_Buffer[Offset] & Mask) != 0);
+    }
+};
+
+/*! \class HdlcdWireFields
+ *  \brief Class HdlcdWireFields
+ * 
+ *  Internal helper of HdlcdWireLayout: compile-time queries regarding a list of fields
+ */
+template<class... TFields> struct HdlcdWireFields {
+    static constexpr size_t GetSize() { return 0; }
+    static constexpr uint8_t GetUsedBits(size_t) { return 0x00; }
+    template<class TField> static constexpr bool Overlaps() { return false; }
+    template<class TField> static constexpr bool Contains() { return false; }
+    static constexpr bool IsDisjoint() { return true; }
+};
+
+template<class TField, class... TFields> struct HdlcdWireFields<TField, TFields...> {
+    typedef HdlcdWireFields<TFields...> Tail;
+
+    // The number of octets up to and including the last octet of any field
+    static constexpr size_t GetSize() {
+        return (((TField::OFFSET + TField::SIZE) > Tail::GetSize()) ? (TField::OFFSET + TField::SIZE) : Tail::GetSize());
+    }
+
+    // The bits of an octet occupied by any field
+    static constexpr uint8_t GetUsedBits(size_t a_Offset) {
+        return static_cast<uint8_t>((((a_Offset >= TField::OFFSET) && (a_Offset < (TField::OFFSET + TField::SIZE))) ? TField::MASK : 0x00) |
+                                    Tail::GetUsedBits(a_Offset));
+    }
+
+    // Whether any field occupies a bit that is also occupied by the specified one
+    template<class TOther> static constexpr bool Overlaps() {
+        return (((TField::OFFSET < (TOther::OFFSET + TOther::SIZE)) && (TOther::OFFSET < (TField::OFFSET + TField::SIZE)) &&
+                 ((TField::MASK & TOther::MASK) != 0)) || Tail::template Overlaps<TOther>());
+    }
+
+    // Whether the specified field is part of the list
+    template<class TOther> static constexpr bool Contains() {
+        return (std::is_same<TField, TOther>::value || Tail::template Contains<TOther>());
+    }
+
+    // Whether no bit is occupied by two fields
+    static constexpr bool IsDisjoint() {
+        return ((!Tail::template Overlaps<TField>()) && Tail::IsDisjoint());
+    }
+};
+
+/*! \brief  Internal helper of HdlcdWireLayout: query whether each octet of a list of fields is occupied by at least one field
+ * 
+ *  \param  a_Octets the number of octets to check, starting at offset zero
+ * 
+ *  \return Indicates whether no octet is left unused
+ */
+template<class TFields> constexpr bool HdlcdWireIsCovered(size_t a_Octets) {
+    return ((a_Octets == 0) || ((TFields::GetUsedBits(a_Octets - 1) != 0) && HdlcdWireIsCovered<TFields>(a_Octets - 1)));
+}
+
+/*! \class HdlcdWireLayout
+ *  \brief Class HdlcdWireLayout
+ * 
+ *  The schema of a fixed-size block of a packet on the wire, composed of HdlcdWireField, HdlcdWireBits, and HdlcdWireFlag
+ *  descriptors. The size of the block is derived from the fields, and layout mistakes are detected at compile time:
+ *  fields sharing a bit, octets not covered by any field, and accesses to fields that are not part of the layout. Bits
+ *  within covered octets that are not occupied by any field are reserved and have to be zero on the wire.
+ * 
+ *  All offsets and masks are compile-time constants, thus encoding and decoding a block is unrolled to single octet
+ *  operations. A new packet type is added by declaring its fields and its layout.
+ * 
+ *  \tparam TFields the fields of the block
+ */
+template<class... TFields> class HdlcdWireLayout {
+    typedef HdlcdWireFields<TFields...> Fields;
+    static_assert((sizeof...(TFields) > 0), "A layout must contain at least one field");
+    static_assert(Fields::IsDisjoint(), "Two fields of a layout occupy the same bits");
+    static_assert(HdlcdWireIsCovered<Fields>(Fields::GetSize()), "An octet of a layout is not covered by any field");
+
+public:
+    static const size_t SIZE = Fields::GetSize(); //!< The number of octets of the block
+
+    /*! \brief  Query the reserved bits of an octet of the block
+     * 
+     *  \param  a_Offset the offset of the octet within the block
+     * 
+     *  \return The bits of the octet not occupied by any field
+     */
+    static constexpr uint8_t GetReservedBits(size_t a_Offset) {
+        return static_cast<uint8_t>(~Fields::GetUsedBits(a_Offset));
+    }
+
+    /*! \brief  Query whether any reserved bit of a block is set
+     * 
+     *  \param  a_Buffer the block of SIZE octets
+     * 
+     *  \retval true at least one reserved bit is set, i.e., the block contains unknown fields
+     *  \retval false all reserved bits are zero
+     *  \return Indicates whether any reserved bit is set
+     */
+    static bool HasReservedBits(const unsigned char* a_Buffer) {
+        for (size_t l_Offset = 0; l_Offset < SIZE; ++l_Offset) {
+            if (a_Buffer[l_Offset] & GetReservedBits(l_Offset)) {
+                return true;
+            } // if
+        } // for
+
+        return false;
+    }
+
+    /*! \brief  Append a zero-filled block to a buffer
+     * 
+     *  \param  a_Buffer the buffer to append SIZE octets to
+     * 
+     *  \return The first octet of the appended block, valid until the buffer is modified
+     */
+    static unsigned char* Append(std::vector<unsigned char>& a_Buffer) {
+        a_Buffer.resize(a_Buffer.size() + SIZE);
+        return (a_Buffer.data() + (a_Buffer.size() - SIZE));
+    }
+
+    /*! \brief  Encode a field of the block
+     * 
+     *  \param  a_Buffer the block of SIZE octets
+     *  \param  a_Value the value of the field
+     */
+    template<class TField> static void Encode(unsigned char* a_Buffer, typename TField::ValueType a_Value) {
+        static_assert(Fields::template Contains<TField>(), "The field is not part of this layout");
+        TField::Encode(a_Buffer, a_Value);
+    }
+
+    /*! \brief  Decode a field of the block
+     * 
+     *  \param  a_Buffer the block of SIZE octets
+     * 
+     *  \return The value of the field
+     */
+    template<class TField> static typename TField::ValueType Decode(const unsigned char* a_Buffer) {
+        static_assert(Fields::template Contains<TField>(), "The field is not part of this layout");
+        return TField::Decode(a_Buffer);
+    }
+};
+
+#endif // HDLCD_WIRE_SCHEMA_H
@@ -0,0 +1,174 @@
+/**
+ * \file      HdlcByteStuffingTest.cpp
+ * \brief     Differential fuzz test of the HDLC byte stuffing codec
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcByteStuffing.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Differential fuzz test of HdlcByteStuffing: the block-wise codec and each search variant are compared against a
+// bytewise reference implementation on random buffers of random length, alignment, and density of special octets.
+
+static std::vector<unsigned char> ReferenceStuff(const std::vector<unsigned char>& a_Buffer) {
+    std::vector<unsigned char> l_Stuffed;
+    for (unsigned char l_Octet: a_Buffer) {
+        if ((l_Octet == HdlcByteStuffing::FLAG) || (l_Octet == HdlcByteStuffing::ESCAPE)) {
+            l_Stuffed.push_back(HdlcByteStuffing::ESCAPE);
+            l_Stuffed.push_back(l_Octet ^ HdlcByteStuffing::XOR);
+        } else {
+            l_Stuffed.push_back(l_Octet);
+        } // else
+    } // for
+
+    return l_Stuffed;
+}
+
+static bool ReferenceUnstuff(const std::vector<unsigned char>& a_Buffer, std::vector<unsigned char>& a_Unstuffed) {
+    for (size_t l_Index = 0; l_Index < a_Buffer.size(); ++l_Index) {
+        if (a_Buffer[l_Index] == HdlcByteStuffing::FLAG) {
+            return false;
+        } else if (a_Buffer[l_Index] == HdlcByteStuffing::ESCAPE) {
+            if (++l_Index == a_Buffer.size()) {
+                return false;
+            } // if
+
+            a_Unstuffed.push_back(a_Buffer[l_Index] ^ HdlcByteStuffing::XOR);
+        } else {
+            a_Unstuffed.push_back(a_Buffer[l_Index]);
+        } // else
+    } // for
+
+    return true;
+}
+
+static bool Fail(size_t a_Iteration, const std::string& a_What) {
+    std::cerr << "Iteration " << a_Iteration << ": " << a_What << std::endl;
+    return false;
+}
+
+static bool CheckSearch(size_t a_Iteration, const unsigned char* a_Buffer, size_t a_Length) {
+    // Compare all search variants for each suffix of the buffer
+    for (size_t l_Start = 0; l_Start < a_Length; l_Start += 7) {
+        size_t l_Expected = HdlcByteStuffing::FindSpecialScalar(a_Buffer + l_Start, a_Length - l_Start);
+        if (HdlcByteStuffing::FindSpecial(a_Buffer + l_Start, a_Length - l_Start) != l_Expected) {
+            return Fail(a_Iteration, "FindSpecial differs from FindSpecialScalar");
+        } // if
+
+#ifdef HDLC_BYTE_STUFFING_HAS_SIMD
+        if (HdlcByteStuffing::FindSpecialSse2(a_Buffer + l_Start, a_Length - l_Start) != l_Expected) {
+            return Fail(a_Iteration, "FindSpecialSse2 differs from FindSpecialScalar");
+        } // if
+
+        if (__builtin_cpu_supports("avx2") && (HdlcByteStuffing::FindSpecialAvx2(a_Buffer + l_Start, a_Length - l_Start) != l_Expected)) {
+            return Fail(a_Iteration, "FindSpecialAvx2 differs from FindSpecialScalar");
+        } // if
+#endif
+    } // for
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of iterations and the seed
+    size_t l_Iterations = ((argc > 1) ? std::stoul(argv[1]) : 20000);
+    std::mt19937 l_Random((argc > 2) ? std::stoul(argv[2]) : 1662);
+    for (size_t l_Iteration = 0; l_Iteration < l_Iterations; ++l_Iteration) {
+        // A random buffer at a random misalignment with a random density of special octets, one in 2 to 4096
+        size_t l_Length = (l_Random() % ((l_Iteration % 16) ? 256 : 4096));
+        size_t l_Alignment = (l_Random() % 32);
+        uint32_t l_Density = (2u << (l_Random() % 12));
+        std::vector<unsigned char> l_Storage(l_Alignment + l_Length);
+        for (size_t l_Index = l_Alignment; l_Index < l_Storage.size(); ++l_Index) {
+            uint32_t l_Value = l_Random();
+            if ((l_Value % l_Density) == 0) {
+                l_Storage[l_Index] = (((l_Value >> 16) & 1) ? HdlcByteStuffing::FLAG : HdlcByteStuffing::ESCAPE);
+            } else {
+                l_Storage[l_Index] = static_cast<unsigned char>(l_Value >> 8);
+            } // else
+        } // for
+
+        const unsigned char* l_Buffer = (l_Storage.data() + l_Alignment);
+        const std::vector<unsigned char> l_Payload(l_Buffer, l_Buffer + l_Length);
+        if (!CheckSearch(l_Iteration, l_Buffer, l_Length)) {
+            return 1;
+        } // if
+
+        // Stuffing, appending to existing content
+        std::vector<unsigned char> l_Stuffed(1, 0x42);
+        HdlcByteStuffing::Stuff(l_Buffer, l_Length, l_Stuffed);
+        std::vector<unsigned char> l_Expected(1, 0x42);
+        const std::vector<unsigned char> l_ReferenceStuffed = ReferenceStuff(l_Payload);
+        l_Expected.insert(l_Expected.end(), l_ReferenceStuffed.begin(), l_ReferenceStuffed.end());
+        if (l_Stuffed != l_Expected) {
+            Fail(l_Iteration, "Stuff differs from the reference");
+            return 1;
+        } // if
+
+        std::vector<unsigned char> l_Frame;
+        HdlcByteStuffing::StuffFrame(l_Buffer, l_Length, l_Frame);
+        if ((l_Frame.size() != (l_ReferenceStuffed.size() + 2)) || (l_Frame.front() != HdlcByteStuffing::FLAG) || (l_Frame.back() != HdlcByteStuffing::FLAG) ||
+            !std::equal(l_ReferenceStuffed.begin(), l_ReferenceStuffed.end(), l_Frame.begin() + 1)) {
+            Fail(l_Iteration, "StuffFrame differs from the reference");
+            return 1;
+        } // if
+
+        // Unstuffing the stuffed form must restore the payload
+        std::vector<unsigned char> l_Unstuffed;
+        if ((!HdlcByteStuffing::Unstuff(l_ReferenceStuffed.data(), l_ReferenceStuffed.size(), l_Unstuffed)) || (l_Unstuffed != l_Payload)) {
+            Fail(l_Iteration, "Unstuff does not restore the payload");
+            return 1;
+        } // if
+
+        // Unstuffing the raw buffer, which may be invalid, must agree with the reference
+        std::vector<unsigned char> l_Raw, l_ReferenceRaw;
+        bool l_bValid = HdlcByteStuffing::Unstuff(l_Buffer, l_Length, l_Raw);
+        if (l_bValid != ReferenceUnstuff(l_Payload, l_ReferenceRaw)) {
+            Fail(l_Iteration, "Unstuff differs from the reference in validity");
+            return 1;
+        } // if
+
+        if (l_bValid && (l_Raw != l_ReferenceRaw)) {
+            Fail(l_Iteration, "Unstuff differs from the reference");
+            return 1;
+        } // if
+    } // for
+
+    std::cout << l_Iterations << " iterations passed" << std::endl;
+    return 0;
+}
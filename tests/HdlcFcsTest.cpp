@@ -0,0 +1,166 @@
+/**
+ * \file      HdlcFcsTest.cpp
+ * \brief     Differential test of the HDLC frame check sequences
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcFcs.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Differential test of HdlcFcs: the sliced lookup tables and, on CPUs supporting carry-less multiplication, the folding
+// path of the FCS-32 are compared against a bitwise reference implementation on random buffers of random length and
+// alignment. Additionally, the check values of CRC-16/X.25 and CRC-32 and the residues of intact frames are verified.
+
+static uint16_t ReferenceFcs16(uint16_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+    for (size_t l_Index = 0; l_Index < a_Length; ++l_Index) {
+        a_Fcs ^= a_Buffer[l_Index];
+        for (unsigned int l_Bit = 0; l_Bit < 8; ++l_Bit) {
+            a_Fcs = ((a_Fcs & 1) ? ((a_Fcs >> 1) ^ 0x8408) : (a_Fcs >> 1));
+        } // for
+    } // for
+
+    return a_Fcs;
+}
+
+static uint32_t ReferenceFcs32(uint32_t a_Fcs, const unsigned char* a_Buffer, size_t a_Length) {
+    for (size_t l_Index = 0; l_Index < a_Length; ++l_Index) {
+        a_Fcs ^= a_Buffer[l_Index];
+        for (unsigned int l_Bit = 0; l_Bit < 8; ++l_Bit) {
+            a_Fcs = ((a_Fcs & 1) ? ((a_Fcs >> 1) ^ 0xEDB88320) : (a_Fcs >> 1));
+        } // for
+    } // for
+
+    return a_Fcs;
+}
+
+static bool Fail(size_t a_Iteration, const std::string& a_What, size_t a_Length, size_t a_Alignment) {
+    std::cerr << "Iteration " << a_Iteration << ": " << a_What << " (length " << a_Length << ", alignment " << a_Alignment << ")" << std::endl;
+    return false;
+}
+
+static bool CheckBuffer(size_t a_Iteration, const unsigned char* a_Buffer, size_t a_Length, size_t a_Alignment) {
+    const uint16_t l_Fcs16 = ReferenceFcs16(HdlcFcs::FCS16_INIT, a_Buffer, a_Length);
+    const uint32_t l_Fcs32 = ReferenceFcs32(HdlcFcs::FCS32_INIT, a_Buffer, a_Length);
+    if (HdlcFcs::Fcs16(HdlcFcs::FCS16_INIT, a_Buffer, a_Length) != l_Fcs16) {
+        return Fail(a_Iteration, "FCS-16 differs", a_Length, a_Alignment);
+    } // if
+
+    if (HdlcFcs::Fcs32Sliced(HdlcFcs::FCS32_INIT, a_Buffer, a_Length) != l_Fcs32) {
+        return Fail(a_Iteration, "sliced FCS-32 differs", a_Length, a_Alignment);
+    } // if
+
+    if (HdlcFcs::Fcs32(HdlcFcs::FCS32_INIT, a_Buffer, a_Length) != l_Fcs32) {
+        return Fail(a_Iteration, "FCS-32 differs", a_Length, a_Alignment);
+    } // if
+
+    // Continuing a calculation at an arbitrary split point yields the same result
+    const size_t l_Split = (a_Length / 3);
+    if (HdlcFcs::Fcs16(HdlcFcs::Fcs16(HdlcFcs::FCS16_INIT, a_Buffer, l_Split), a_Buffer + l_Split, a_Length - l_Split) != l_Fcs16) {
+        return Fail(a_Iteration, "continued FCS-16 differs", a_Length, a_Alignment);
+    } // if
+
+    if (HdlcFcs::Fcs32(HdlcFcs::Fcs32(HdlcFcs::FCS32_INIT, a_Buffer, l_Split), a_Buffer + l_Split, a_Length - l_Split) != l_Fcs32) {
+        return Fail(a_Iteration, "continued FCS-32 differs", a_Length, a_Alignment);
+    } // if
+
+    return true;
+}
+
+static bool CheckFrames(size_t a_Iteration, const unsigned char* a_Buffer, size_t a_Length) {
+    // Append the inverted FCS least significant octet first, the residue of the frame must match
+    std::vector<unsigned char> l_Frame16(a_Buffer, a_Buffer + a_Length);
+    const uint16_t l_Fcs16 = ~ReferenceFcs16(HdlcFcs::FCS16_INIT, a_Buffer, a_Length);
+    l_Frame16.push_back(l_Fcs16 & 0xFF);
+    l_Frame16.push_back(l_Fcs16 >> 8);
+    std::vector<unsigned char> l_Frame32(a_Buffer, a_Buffer + a_Length);
+    const uint32_t l_Fcs32 = ~ReferenceFcs32(HdlcFcs::FCS32_INIT, a_Buffer, a_Length);
+    for (unsigned int l_Octet = 0; l_Octet < 4; ++l_Octet) {
+        l_Frame32.push_back((l_Fcs32 >> (8 * l_Octet)) & 0xFF);
+    } // for
+
+    if ((!HdlcFcs::CheckFcs16(l_Frame16.data(), l_Frame16.size())) || (!HdlcFcs::CheckFcs32(l_Frame32.data(), l_Frame32.size()))) {
+        return Fail(a_Iteration, "intact frame rejected", a_Length, 0);
+    } // if
+
+    // A single flipped bit is always detected
+    const size_t l_Bit = (a_Iteration % (8 * l_Frame16.size()));
+    l_Frame16[l_Bit / 8] ^= (1 << (l_Bit % 8));
+    l_Frame32[l_Bit / 8] ^= (1 << (l_Bit % 8));
+    if ((HdlcFcs::CheckFcs16(l_Frame16.data(), l_Frame16.size())) || (HdlcFcs::CheckFcs32(l_Frame32.data(), l_Frame32.size()))) {
+        return Fail(a_Iteration, "corrupted frame accepted", a_Length, 0);
+    } // if
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of iterations and the seed
+    const size_t l_Iterations = ((argc > 1) ? std::stoul(argv[1]) : 4000);
+    const uint32_t l_Seed = ((argc > 2) ? std::stoul(argv[2]) : 1662);
+    std::mt19937 l_Generator(l_Seed);
+    std::cout << "Seed " << l_Seed << ", " << l_Iterations << " iterations" << std::endl;
+#ifdef HDLC_FCS_HAS_PCLMUL
+    std::cout << "Carry-less multiplication " << ((__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) ? "available" : "not available") << std::endl;
+#endif
+
+    // Check values of "123456789"
+    const std::string l_Check("123456789");
+    const unsigned char* l_CheckBuffer = reinterpret_cast<const unsigned char*>(l_Check.data());
+    if ((uint16_t(~HdlcFcs::Fcs16(HdlcFcs::FCS16_INIT, l_CheckBuffer, l_Check.size())) != 0x906E) ||
+        (uint32_t(~HdlcFcs::Fcs32(HdlcFcs::FCS32_INIT, l_CheckBuffer, l_Check.size())) != 0xCBF43926)) {
+        std::cerr << "Wrong check values" << std::endl;
+        return 1;
+    } // if
+
+    // Random buffers; lengths up to 4096 octets, the lengths around the thresholds of the folding path are more likely
+    std::vector<unsigned char> l_Storage(4096 + 16);
+    for (size_t l_Iteration = 0; l_Iteration < l_Iterations; ++l_Iteration) {
+        const size_t l_Length = ((l_Iteration % 2) ? (l_Generator() % 4097) : (l_Generator() % 160));
+        const size_t l_Alignment = (l_Generator() % 16);
+        for (size_t l_Index = 0; l_Index < l_Length; ++l_Index) {
+            l_Storage[l_Alignment + l_Index] = (l_Generator() & 0xFF);
+        } // for
+
+        if ((!CheckBuffer(l_Iteration, l_Storage.data() + l_Alignment, l_Length, l_Alignment)) ||
+            (!CheckFrames(l_Iteration, l_Storage.data() + l_Alignment, l_Length))) {
+            return 1;
+        } // if
+    } // for
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * \file      HdlcFrameDissectorTest.cpp
+ * \brief     Unit test of the HDLC frame dissector
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcFrameDissector.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Unit test of HdlcFrameDissector: I-, S-, and U-frames with basic and extended control fields, frames too short to be
+// classified, wrong frame check sequences, and batches of data packets
+
+static int s_Failures = 0;
+
+static void Check(bool a_bCondition, const char* a_What) {
+    if (!a_bCondition) {
+        std::cerr << "Failed: " << a_What << std::endl;
+        ++s_Failures;
+    } // if
+}
+
+// Build a frame from address, control, and information field, followed by the inverted FCS least significant octet first
+static std::vector<unsigned char> CreateFrame(std::vector<unsigned char> a_Header, const std::vector<unsigned char>& a_Information, E_HDLC_FCS_TYPE a_eFcsType) {
+    std::vector<unsigned char> l_Frame(a_Header);
+    l_Frame.insert(l_Frame.end(), a_Information.begin(), a_Information.end());
+    if (a_eFcsType == HDLC_FCS_TYPE_16) {
+        const uint16_t l_Fcs = ~HdlcFcs::Fcs16(HdlcFcs::FCS16_INIT, l_Frame.data(), l_Frame.size());
+        l_Frame.push_back(l_Fcs & 0xFF);
+        l_Frame.push_back(l_Fcs >> 8);
+    } else if (a_eFcsType == HDLC_FCS_TYPE_32) {
+        const uint32_t l_Fcs = ~HdlcFcs::Fcs32(HdlcFcs::FCS32_INIT, l_Frame.data(), l_Frame.size());
+        for (unsigned int l_Octet = 0; l_Octet < 4; ++l_Octet) {
+            l_Frame.push_back((l_Fcs >> (8 * l_Octet)) & 0xFF);
+        } // for
+    } // else if
+
+    return l_Frame;
+}
+
+int main() {
+    const std::vector<unsigned char> l_Information = { 'a', 'b', 'c' };
+    HdlcFrameInfo l_FrameInfo;
+    {
+        // Basic control field, FCS-16: I-frame with N(S) 3, N(R) 5, and the poll bit set
+        HdlcFrameDissector l_Dissector(HDLC_FCS_TYPE_16);
+        std::vector<unsigned char> l_Frame = CreateFrame({ 0xFF, 0xB6 }, l_Information, HDLC_FCS_TYPE_16);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "basic I-frame valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_I) && (l_FrameInfo.m_bFcsValid) && (l_FrameInfo.m_Address == 0xFF) &&
+               (l_FrameInfo.m_SendSequence == 3) && (l_FrameInfo.m_ReceiveSequence == 5) && (l_FrameInfo.m_bPollFinal)), "basic I-frame fields");
+        Check(((l_FrameInfo.m_Information == (l_Frame.data() + 2)) && (l_FrameInfo.m_InformationSize == 3)), "basic I-frame information field");
+
+        // S-frame: RNR with N(R) 2, no information field
+        l_Frame = CreateFrame({ 0x03, 0x45 }, std::vector<unsigned char>(), HDLC_FCS_TYPE_16);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "basic S-frame valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_S) && (l_FrameInfo.m_Function == 0x01) && (l_FrameInfo.m_ReceiveSequence == 2) &&
+               (!l_FrameInfo.m_bPollFinal) && (l_FrameInfo.m_Information == nullptr) && (l_FrameInfo.m_InformationSize == 0)), "basic S-frame fields");
+
+        // U-frame: UA with the final bit set
+        l_Frame = CreateFrame({ 0x03, 0x73 }, std::vector<unsigned char>(), HDLC_FCS_TYPE_16);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "U-frame valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_U) && (l_FrameInfo.m_Function == 0x0C) && (l_FrameInfo.m_bPollFinal)), "U-frame fields");
+
+        // A wrong FCS is reported, but the frame is classified nonetheless
+        l_Frame = CreateFrame({ 0xFF, 0xB6 }, l_Information, HDLC_FCS_TYPE_16);
+        l_Frame[3] ^= 0x01;
+        Check((!l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo)), "wrong FCS-16 rejected");
+        Check(((!l_FrameInfo.m_bFcsValid) && (l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_I)), "wrong FCS-16 classified");
+
+        // Too short: address and control field are required in front of the FCS
+        l_Frame = CreateFrame({ 0xFF }, std::vector<unsigned char>(), HDLC_FCS_TYPE_16);
+        Check((!l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo)), "short frame rejected");
+        Check((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_INVALID), "short frame not classified");
+        Check((!l_Dissector.Dissect(l_Frame.data(), 0, l_FrameInfo)), "empty frame rejected");
+    }
+
+    {
+        // Extended control field, FCS-32: I-frame with N(S) 100, N(R) 77, and the poll bit set
+        HdlcFrameDissector l_Dissector(HDLC_FCS_TYPE_32, true);
+        std::vector<unsigned char> l_Frame = CreateFrame({ 0x01, 0xC8, 0x9B }, l_Information, HDLC_FCS_TYPE_32);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "extended I-frame valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_I) && (l_FrameInfo.m_Control == 0x9BC8) && (l_FrameInfo.m_SendSequence == 100) &&
+               (l_FrameInfo.m_ReceiveSequence == 77) && (l_FrameInfo.m_bPollFinal)), "extended I-frame fields");
+        Check(((l_FrameInfo.m_Information == (l_Frame.data() + 3)) && (l_FrameInfo.m_InformationSize == 3)), "extended I-frame information field");
+
+        // S-frame: REJ with N(R) 127
+        l_Frame = CreateFrame({ 0x01, 0x09, 0xFE }, std::vector<unsigned char>(), HDLC_FCS_TYPE_32);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "extended S-frame valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_S) && (l_FrameInfo.m_Function == 0x02) && (l_FrameInfo.m_ReceiveSequence == 127) &&
+               (!l_FrameInfo.m_bPollFinal)), "extended S-frame fields");
+
+        // U-frames keep a single control octet: SABME with the poll bit set carries the information field directly
+        l_Frame = CreateFrame({ 0x01, 0x7F }, l_Information, HDLC_FCS_TYPE_32);
+        Check(l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo), "U-frame with extended control valid");
+        Check(((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_U) && (l_FrameInfo.m_bPollFinal) && (l_FrameInfo.m_Information == (l_Frame.data() + 2)) &&
+               (l_FrameInfo.m_InformationSize == 3)), "U-frame with extended control fields");
+
+        // An I-frame lacking its second control octet
+        l_Frame = CreateFrame({ 0x01, 0xC8 }, std::vector<unsigned char>(), HDLC_FCS_TYPE_32);
+        Check((!l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo)), "truncated extended I-frame rejected");
+        Check((l_FrameInfo.m_eFrameType == HDLC_FRAME_TYPE_INVALID), "truncated extended I-frame not classified");
+
+        // Wrong FCS-32
+        l_Frame = CreateFrame({ 0x01, 0xC8, 0x9B }, l_Information, HDLC_FCS_TYPE_32);
+        l_Frame.back() ^= 0x80;
+        Check((!l_Dissector.Dissect(l_Frame.data(), l_Frame.size(), l_FrameInfo)), "wrong FCS-32 rejected");
+    }
+
+    {
+        // Without FCS every classified frame is valid; a batch reports one result per data packet
+        HdlcFrameDissector l_Dissector(HDLC_FCS_TYPE_NONE);
+        std::vector<std::shared_ptr<const HdlcdPacketData>> l_Packets;
+        l_Packets.emplace_back(std::make_shared<HdlcdPacketData>(HdlcdPacketData::CreatePacket({ 0xFF, 0x10, 'x' }, true)));
+        l_Packets.emplace_back(std::make_shared<HdlcdPacketData>(HdlcdPacketData::CreatePacket({ 0xFF }, true)));
+        l_Packets.emplace_back(std::make_shared<HdlcdPacketData>(HdlcdPacketData::CreatePacket({ 0xFF, 0x01 }, true)));
+        std::vector<HdlcFrameInfo> l_FrameInfos;
+        Check((l_Dissector.DissectBatch(l_Packets, l_FrameInfos) == 2), "valid frames of a batch");
+        Check(((l_FrameInfos.size() == 3) && (l_FrameInfos[0].m_eFrameType == HDLC_FRAME_TYPE_I) && (l_FrameInfos[0].m_InformationSize == 1) &&
+               (l_FrameInfos[1].m_eFrameType == HDLC_FRAME_TYPE_INVALID) && (l_FrameInfos[2].m_eFrameType == HDLC_FRAME_TYPE_S)), "results of a batch");
+    }
+
+    return (s_Failures ? 1 : 0);
+}
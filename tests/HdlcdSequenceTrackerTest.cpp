@@ -0,0 +1,103 @@
+/**
+ * \file      HdlcdSequenceTrackerTest.cpp
+ * \brief     Unit test of the sequence-gap detection
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcdSequenceTracker.h"
+#include <iostream>
+#include <stdint.h>
+
+// Unit test of HdlcdSequenceTracker: gaps, late data packets, the wrap-around of sequence numbers, and restarts
+
+static int s_Failures = 0;
+
+static void Check(bool a_bCondition, const char* a_What) {
+    if (!a_bCondition) {
+        std::cerr << "Failed: " << a_What << std::endl;
+        ++s_Failures;
+    } // if
+}
+
+int main() {
+    {
+        // In-order data packets do not produce any gap
+        HdlcdSequenceTracker l_Tracker;
+        for (uint32_t l_SequenceNumber = 1000; l_SequenceNumber < 1100; ++l_SequenceNumber) {
+            Check((l_Tracker.Update(l_SequenceNumber) == 0), "no loss in order");
+        } // for
+
+        Check((l_Tracker.GetReceived() == 100), "received in order");
+        Check(((l_Tracker.GetLost() == 0) && (l_Tracker.GetGaps() == 0) && (l_Tracker.GetLate() == 0)), "no gaps in order");
+    }
+
+    {
+        // Two bursts of lost data packets, then a duplicate and an old data packet
+        HdlcdSequenceTracker l_Tracker;
+        l_Tracker.Update(1);
+        Check((l_Tracker.Update(5) == 3), "burst of three");
+        Check((l_Tracker.Update(6) == 0), "in order after a burst");
+        Check((l_Tracker.Update(8) == 1), "burst of one");
+        Check((l_Tracker.Update(8) == 0), "duplicate");
+        Check((l_Tracker.Update(2) == 0), "old data packet");
+        Check((l_Tracker.Update(9) == 0), "expected sequence number not moved back");
+        Check(((l_Tracker.GetReceived() == 7) && (l_Tracker.GetLost() == 4) && (l_Tracker.GetGaps() == 2) && (l_Tracker.GetLate() == 2)), "burst counters");
+        Check(((l_Tracker.GetBursts().GetCount() == 2) && (l_Tracker.GetBursts().GetMin() == 1) && (l_Tracker.GetBursts().GetMax() == 3)), "burst histogram");
+    }
+
+    {
+        // The sequence numbers wrap around
+        HdlcdSequenceTracker l_Tracker;
+        l_Tracker.Update(0xFFFFFFFE);
+        Check((l_Tracker.Update(0xFFFFFFFF) == 0), "in order before the wrap-around");
+        Check((l_Tracker.Update(0) == 0), "in order across the wrap-around");
+        Check((l_Tracker.Update(3) == 2), "burst after the wrap-around");
+        Check((l_Tracker.Update(0xFFFFFFF0) == 0), "late across the wrap-around");
+        Check(((l_Tracker.GetLost() == 2) && (l_Tracker.GetGaps() == 1) && (l_Tracker.GetLate() == 1)), "wrap-around counters");
+    }
+
+    {
+        // A restart takes the next sequence number as is, but keeps the counters
+        HdlcdSequenceTracker l_Tracker;
+        l_Tracker.Update(10);
+        l_Tracker.Update(12);
+        l_Tracker.Restart();
+        Check((l_Tracker.Update(1) == 0), "no loss or late data packet after a restart");
+        Check((l_Tracker.Update(2) == 0), "in order after a restart");
+        Check(((l_Tracker.GetReceived() == 4) && (l_Tracker.GetLost() == 1) && (l_Tracker.GetLate() == 0)), "counters kept on restart");
+    }
+
+    return (s_Failures ? 1 : 0);
+}
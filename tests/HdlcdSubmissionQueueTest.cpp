@@ -0,0 +1,129 @@
+/**
+ * \file      HdlcdSubmissionQueueTest.cpp
+ * \brief     Stress test of the lock-free submission queue
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcdSubmissionQueue.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stress test of HdlcdSubmissionQueue with the wakeup protocol of HdlcdClient::Submit(): several producers push
+// sequence-numbered items, and a consumer drains batches only after a wakeup was requested. A lost item, a reordered
+// item of one producer, or a lost wakeup leaving items behind in the queue fails the test.
+
+static const size_t s_Producers = 4;
+
+int main(int argc, char* argv[]) {
+    // Optional: the number of items per producer and the number of rounds
+    const size_t l_Items = ((argc > 1) ? std::stoul(argv[1]) : 200000);
+    const size_t l_Rounds = ((argc > 2) ? std::stoul(argv[2]) : 5);
+    for (size_t l_Round = 0; l_Round < l_Rounds; ++l_Round) {
+        // A small queue to provoke full queues and contention
+        HdlcdSubmissionQueue<uint64_t> l_Queue(64);
+        std::atomic<size_t> l_Wakeups(0);
+        std::atomic<bool> l_bStop(false);
+        std::vector<uint64_t> l_Next(s_Producers, 0);
+        size_t l_Received = 0;
+        bool l_bInOrder = true;
+
+        // The consumer sleeps until a wakeup was requested, then drains the queue until EndBatch() permits to sleep again
+        std::thread l_Consumer([&]() {
+            while (true) {
+                if (l_Wakeups.load() == 0) {
+                    if (l_bStop.load()) {
+                        break;
+                    } // if
+
+                    std::this_thread::yield();
+                    continue;
+                } // if
+
+                l_Wakeups.fetch_sub(1);
+                do {
+                    uint64_t l_Item;
+                    while (l_Queue.Pop(l_Item)) {
+                        const size_t l_Producer = (l_Item >> 32);
+                        l_bInOrder &= ((l_Item & 0xFFFFFFFF) == l_Next[l_Producer]++);
+                        ++l_Received;
+                    } // while
+                } while (l_Queue.EndBatch());
+            } // while
+        });
+
+        std::vector<std::thread> l_Producers;
+        for (size_t l_Producer = 0; l_Producer < s_Producers; ++l_Producer) {
+            l_Producers.emplace_back([&, l_Producer]() {
+                for (uint64_t l_Index = 0; l_Index < l_Items; ++l_Index) {
+                    uint64_t l_Item = ((uint64_t(l_Producer) << 32) | l_Index);
+                    while (!l_Queue.Push(std::move(l_Item))) {
+                        std::this_thread::yield();
+                    } // while
+
+                    if (l_Queue.RequestWakeup()) {
+                        l_Wakeups.fetch_add(1);
+                    } // if
+                } // for
+            });
+        } // for
+
+        for (auto& l_Producer: l_Producers) {
+            l_Producer.join();
+        } // for
+
+        // Wait for the consumer to go to sleep with all wakeups consumed
+        auto l_Deadline = (std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        while ((l_Wakeups.load() != 0) && (std::chrono::steady_clock::now() < l_Deadline)) {
+            std::this_thread::yield();
+        } // while
+
+        l_bStop = true;
+        l_Consumer.join();
+        if ((l_Received != (s_Producers * l_Items)) || (!l_bInOrder) || (l_Queue.GetDepth() != 0)) {
+            std::cerr << "Round " << l_Round << ": received " << l_Received << " of " << (s_Producers * l_Items) << " items, "
+                      << (l_bInOrder ? "in order" : "out of order") << ", " << l_Queue.GetDepth() << " left in the queue" << std::endl;
+            return 1;
+        } // if
+
+        std::cout << "Round " << l_Round << ": " << l_Received << " items, " << l_Queue.GetWakeups() << " wakeups, "
+                  << l_Queue.GetContention() << " retries, " << l_Queue.GetRejected() << " rejected" << std::endl;
+    } // for
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * \file      HdlcdWireSchemaTest.cpp
+ * \brief     Unit test of the compile-time wire schema
+ * \author    Florian Evers, florian-evers@gmx.de
+ * \copyright BSD 3 Clause licence
+ *
+ * Copyright (c) 2016, Florian Evers, florian-evers@gmx.de
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer. 
+ * 
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.  
+ *     
+ *     (3)The name of the author may not be used to
+ *     endorse or promote products derived from this software without
+ *     specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HdlcdWireSchema.h"
+#include "HdlcdPortStatistics.h"
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+// Unit test of HdlcdWireLayout: network byte order, bit fields and flags sharing an octet, reserved bits, and the
+// serialization of HdlcdPortStatistics against a known octet sequence
+
+static int s_Failures = 0;
+
+static void Check(bool a_bCondition, const char* a_What) {
+    if (!a_bCondition) {
+        std::cerr << "Failed: " << a_What << std::endl;
+        ++s_Failures;
+    } // if
+}
+
+// A layout with a 16 bit field, a 24 bit field, and an octet shared by a two-bit field and a flag
+typedef HdlcdWireField<0, 2> Length;
+typedef HdlcdWireField<2, 3> Offset;
+typedef HdlcdWireBits<5, 0x30> Mode;
+typedef HdlcdWireFlag<5, 0x01> Final;
+typedef HdlcdWireLayout<Length, Offset, Mode, Final> TestLayout;
+static_assert((TestLayout::SIZE == 6), "The size of the test layout is derived from its fields");
+
+int main() {
+    {
+        // Encoding in network byte order
+        std::vector<unsigned char> l_Buffer(1, 0xAA);
+        unsigned char* l_Block = TestLayout::Append(l_Buffer);
+        TestLayout::Encode<Length>(l_Block, 0x1234);
+        TestLayout::Encode<Offset>(l_Block, 0x56789A);
+        TestLayout::Encode<Mode>(l_Block, 0x20);
+        TestLayout::Encode<Final>(l_Block, true);
+        const std::vector<unsigned char> l_Expected = { 0xAA, 0x12, 0x34, 0x56, 0x78, 0x9A, 0x21 };
+        Check((l_Buffer == l_Expected), "encoded octets");
+
+        // Decoding, and clearing a flag does not touch the neighbouring bits
+        l_Block = (l_Buffer.data() + 1);
+        Check((TestLayout::Decode<Length>(l_Block) == 0x1234), "decoded 16 bit field");
+        Check((TestLayout::Decode<Offset>(l_Block) == 0x56789A), "decoded 24 bit field");
+        Check((TestLayout::Decode<Mode>(l_Block) == 0x20), "decoded bit field");
+        Check((TestLayout::Decode<Final>(l_Block)), "decoded flag");
+        TestLayout::Encode<Final>(l_Block, false);
+        Check(((!TestLayout::Decode<Final>(l_Block)) && (TestLayout::Decode<Mode>(l_Block) == 0x20)), "cleared flag");
+    }
+
+    {
+        // Reserved bits
+        Check((TestLayout::GetReservedBits(0) == 0x00), "no reserved bits in a full octet");
+        Check((TestLayout::GetReservedBits(5) == 0xCE), "reserved bits of the shared octet");
+        unsigned char l_Block[TestLayout::SIZE] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x31 };
+        Check((!TestLayout::HasReservedBits(l_Block)), "all reserved bits zero");
+        l_Block[5] |= 0x40;
+        Check((TestLayout::HasReservedBits(l_Block)), "a reserved bit set");
+    }
+
+    {
+        // HdlcdPortStatistics: serialization and a roundtrip
+        HdlcdPortStatistics l_Statistics;
+        l_Statistics.SetRxFrames(0x0102030405060708ULL);
+        l_Statistics.SetTxFrames(0x1112131415161718ULL);
+        l_Statistics.SetRxOctets(0x2122232425262728ULL);
+        l_Statistics.SetTxOctets(0x3132333435363738ULL);
+        l_Statistics.SetCrcErrors(0x41424344);
+        l_Statistics.SetRetransmissions(0x51525354);
+        l_Statistics.SetTxQueueDepth(0x61626364);
+        l_Statistics.SetUptime(0x71727374);
+        std::vector<unsigned char> l_Buffer;
+        l_Statistics.Serialize(l_Buffer);
+        Check((l_Buffer.size() == HdlcdPortStatistics::SIZE), "size of the serialized counters");
+        const unsigned char l_Leads[] = { 0x01, 0x11, 0x21, 0x31, 0x41, 0x51, 0x61, 0x71 };
+        const size_t l_Offsets[] = { 0, 8, 16, 24, 32, 36, 40, 44 };
+        for (size_t l_Index = 0; l_Index < 8; ++l_Index) {
+            Check((l_Buffer[l_Offsets[l_Index]] == l_Leads[l_Index]), "most significant octet first");
+        } // for
+
+        HdlcdPortStatistics l_Decoded;
+        l_Decoded.Deserialize(l_Buffer.data());
+        Check(((l_Decoded.GetRxFrames() == l_Statistics.GetRxFrames()) && (l_Decoded.GetTxFrames() == l_Statistics.GetTxFrames()) &&
+               (l_Decoded.GetRxOctets() == l_Statistics.GetRxOctets()) && (l_Decoded.GetTxOctets() == l_Statistics.GetTxOctets()) &&
+               (l_Decoded.GetCrcErrors() == l_Statistics.GetCrcErrors()) && (l_Decoded.GetRetransmissions() == l_Statistics.GetRetransmissions()) &&
+               (l_Decoded.GetTxQueueDepth() == l_Statistics.GetTxQueueDepth()) && (l_Decoded.GetUptime() == l_Statistics.GetUptime())), "roundtrip");
+    }
+
+    return (s_Failures ? 1 : 0);
+}